@@ -137,16 +137,24 @@ bool tinygraph_array_resize(tinygraph_array * const array, uint32_t size) {
   } else if (size > array->size) {
     TINYGRAPH_ASSERT(size > array->size);
 
-    uint64_t growth = ceil((uint64_t)array->items_len * 1.5);
+    // Only grow when out of capacity; growing on every
+    // resize would multiply the capacity per push
+    if (size > array->items_len) {
+      uint64_t growth = ceil((uint64_t)array->items_len * 1.5);
 
-    if (growth >= UINT32_MAX) {
-      growth = UINT32_MAX;
-    }
+      if (growth < size) {
+        growth = size;
+      }
+
+      if (growth >= UINT32_MAX) {
+        growth = UINT32_MAX;
+      }
 
-    const bool ok = tinygraph_array_reserve(array, (uint32_t)growth);
+      const bool ok = tinygraph_array_reserve(array, (uint32_t)growth);
 
-    if (!ok) {
-      return false;
+      if (!ok) {
+        return false;
+      }
     }
 
     TINYGRAPH_ASSERT(size <= array->items_len);
@@ -0,0 +1,1050 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+#include "tinygraph.h"
+#include "tinygraph-impl.h"
+#include "tinygraph-rng.h"
+#include "tinygraph-bits.h"
+#include "tinygraph-cpu.h"
+#include "tinygraph-zorder.h"
+#include "tinygraph-bitset.h"
+#include "tinygraph-rankselect.h"
+#include "tinygraph-vbyte.h"
+#include "tinygraph-streamvbyte.h"
+#include "tinygraph-elias.h"
+
+/*
+ * Micro-benchmarks for the hot building blocks.
+ *
+ * Numbers are only meaningful when compiled
+ * with optimizations and without sanitizers.
+ *
+ *   make tinygraph-bench
+ *   ./tinygraph-bench
+ */
+
+
+static double bench_now(void) {
+  struct timespec ts;
+
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+    abort();
+  }
+
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static void bench_report(const char *name, uint64_t num_items, uint64_t num_bytes, double seconds) {
+  if (num_bytes == 0) {
+    printf("%-32s %10.1f M items/s %8.1f ns/item\n", name,
+        num_items / seconds * 1e-6, seconds / num_items * 1e9);
+
+    return;
+  }
+
+  printf("%-32s %10.1f M items/s %8.2f GB/s\n", name,
+      num_items / seconds * 1e-6, num_bytes / seconds * 1e-9);
+}
+
+
+void bench_vbyte(void) {
+  const uint32_t n = UINT32_C(1) << 22;
+  const uint32_t rounds = 50;
+
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  uint32_t *data = malloc(n * sizeof(uint32_t));
+  uint32_t *out = malloc(n * sizeof(uint32_t));
+  uint8_t *vbytes = malloc(n * 5);
+  uint8_t *svbytes = malloc(tinygraph_streamvbyte_max_bytes(n));
+  assert(data && out && vbytes && svbytes);
+
+  // Mostly small values as in delta coded adjacency
+  // lists, with a tail of wider values mixed in
+
+  for (uint32_t i = 0; i < n; ++i) {
+    const uint32_t r = tinygraph_rng_bounded(rng, 16);
+    const uint32_t shift = r < 10 ? 26 : r < 14 ? 18 : r < 15 ? 10 : 0;
+
+    data[i] = tinygraph_rng_random(rng) >> shift;
+  }
+
+  const uint32_t vlen = tinygraph_vbyte_encode(data, vbytes, n);
+  const uint32_t svlen = tinygraph_streamvbyte_encode(data, svbytes, n);
+
+  printf("vbyte %.2f bytes/item, stream vbyte %.2f bytes/item\n",
+      (double)vlen / n, (double)svlen / n);
+
+  uint64_t checksum = 0;
+
+  double start = bench_now();
+
+  for (uint32_t r = 0; r < rounds; ++r) {
+    checksum += tinygraph_vbyte_decode(vbytes, out, n);
+    checksum += out[r];
+  }
+
+  bench_report("vbyte decode", (uint64_t)n * rounds,
+      (uint64_t)n * rounds * sizeof(uint32_t), bench_now() - start);
+
+  start = bench_now();
+
+  for (uint32_t r = 0; r < rounds; ++r) {
+    checksum += tinygraph_streamvbyte_decode(svbytes, out, n);
+    checksum += out[r];
+  }
+
+  bench_report("stream vbyte decode", (uint64_t)n * rounds,
+      (uint64_t)n * rounds * sizeof(uint32_t), bench_now() - start);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    assert(out[i] == data[i]);
+  }
+
+  printf("checksum %ju\n", (uintmax_t)checksum);
+
+  free(svbytes);
+  free(vbytes);
+  free(out);
+  free(data);
+  tinygraph_rng_destruct(rng);
+}
+
+
+void bench_elias(void) {
+  const uint32_t n = UINT32_C(1) << 22;
+  const uint32_t rounds = 20;
+
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  uint32_t *data = malloc(n * sizeof(uint32_t));
+  uint32_t *out = malloc(n * sizeof(uint32_t));
+  uint64_t *words = malloc(tinygraph_elias_num_words(n * UINT64_C(63)) * sizeof(uint64_t));
+  assert(data && out && words);
+
+  // Small positive gaps as in edge weights or sorted
+  // node coordinates, with a tail of larger values
+
+  for (uint32_t i = 0; i < n; ++i) {
+    const uint32_t r = tinygraph_rng_bounded(rng, 16);
+    const uint32_t shift = r < 12 ? 29 : r < 15 ? 24 : 16;
+
+    data[i] = (tinygraph_rng_random(rng) >> shift) + 1;
+  }
+
+  uint64_t checksum = 0;
+
+  const uint64_t gamma = tinygraph_elias_gamma_encode(data, words, n);
+
+  double start = bench_now();
+
+  for (uint32_t r = 0; r < rounds; ++r) {
+    checksum += tinygraph_elias_gamma_decode(words, out, n);
+    checksum += out[r];
+  }
+
+  printf("gamma %.2f bits/item\n", (double)gamma / n);
+
+  bench_report("gamma decode", (uint64_t)n * rounds,
+      (uint64_t)n * rounds * sizeof(uint32_t), bench_now() - start);
+
+  const uint64_t delta = tinygraph_elias_delta_encode(data, words, n);
+
+  start = bench_now();
+
+  for (uint32_t r = 0; r < rounds; ++r) {
+    checksum += tinygraph_elias_delta_decode(words, out, n);
+    checksum += out[r];
+  }
+
+  printf("delta %.2f bits/item\n", (double)delta / n);
+
+  bench_report("delta decode", (uint64_t)n * rounds,
+      (uint64_t)n * rounds * sizeof(uint32_t), bench_now() - start);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    assert(out[i] == data[i]);
+  }
+
+  printf("checksum %ju\n", (uintmax_t)checksum);
+
+  free(words);
+  free(out);
+  free(data);
+  tinygraph_rng_destruct(rng);
+}
+
+
+void bench_popcount(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  // Cache resident and memory bound ranges
+  const uint64_t sizes[2] = {UINT64_C(1) << 12, UINT64_C(1) << 24};
+
+  for (uint32_t k = 0; k < 2; ++k) {
+    const uint64_t n = sizes[k];
+    const uint64_t rounds = (UINT64_C(1) << 30) / n;
+
+    uint64_t *words = malloc(n * sizeof(uint64_t));
+    assert(words);
+
+    for (uint64_t i = 0; i < n; ++i) {
+      words[i] = (uint64_t)tinygraph_rng_random(rng) << 32 | tinygraph_rng_random(rng);
+    }
+
+    printf("popcount over %ju KiB\n", (uintmax_t)(n * sizeof(uint64_t) / 1024));
+
+    uint64_t checksum = 0;
+
+    double start = bench_now();
+
+    for (uint64_t r = 0; r < rounds; ++r) {
+      for (uint64_t i = 0; i < n; i += 8) {
+        checksum += tinygraph_bits_count_512(words + i);
+      }
+
+      words[r % n] += 1;
+    }
+
+    bench_report("count 512 bit blocks", n * rounds, n * rounds * sizeof(uint64_t), bench_now() - start);
+
+    start = bench_now();
+
+    for (uint64_t r = 0; r < rounds; ++r) {
+      checksum += tinygraph_bits_count_n(words, n);
+
+      words[r % n] += 1;
+    }
+
+    bench_report("count bulk", n * rounds, n * rounds * sizeof(uint64_t), bench_now() - start);
+
+    uint32_t *counts = malloc(n / 8 * sizeof(uint32_t));
+    assert(counts);
+
+    start = bench_now();
+
+    for (uint64_t r = 0; r < rounds; ++r) {
+      tinygraph_bits_count_512_n(words, n / 8, counts);
+      checksum += counts[r % (n / 8)];
+
+      words[r % n] += 1;
+    }
+
+    bench_report("count bulk 512 bit blocks", n * rounds, n * rounds * sizeof(uint64_t), bench_now() - start);
+
+    printf("checksum %ju\n", (uintmax_t)checksum);
+
+    free(counts);
+    free(words);
+  }
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void bench_rankselect(void) {
+  const uint64_t n = UINT64_C(1) << 28;
+  const uint32_t num_queries = UINT32_C(1) << 22;
+
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  uint64_t *queries = malloc(num_queries * sizeof(uint64_t));
+  assert(queries);
+
+  // Random queries over a bitset larger than the
+  // caches, at half and at 1/16 density each
+
+  const uint32_t densities[2] = {2, 16};
+
+  for (uint32_t d = 0; d < 2; ++d) {
+    tinygraph_bitset_s bits = tinygraph_bitset_construct(n);
+    assert(bits);
+
+    for (uint64_t i = 0; i < n; ++i) {
+      if (tinygraph_rng_bounded(rng, densities[d]) == 0) {
+        tinygraph_bitset_set_at(bits, i);
+      }
+    }
+
+    double start = bench_now();
+
+    tinygraph_rankselect_s rs = tinygraph_rankselect_construct(bits);
+    assert(rs);
+
+    const double construct = bench_now() - start;
+
+    const uint64_t count = tinygraph_rankselect_get_count(rs);
+
+    printf("rankselect 1/%ju density, overhead %.2f%%, construct %.1f ms\n",
+        (uintmax_t)densities[d],
+        tinygraph_rankselect_get_size_in_bytes(rs) * 8 * 100.0 / n,
+        construct * 1e3);
+
+    uint64_t checksum = 0;
+
+    for (uint32_t i = 0; i < num_queries; ++i) {
+      queries[i] = ((uint64_t)tinygraph_rng_random(rng) << 32 | tinygraph_rng_random(rng)) % n;
+    }
+
+    start = bench_now();
+
+    for (uint32_t i = 0; i < num_queries; ++i) {
+      checksum += tinygraph_rankselect_rank(rs, queries[i]);
+    }
+
+    bench_report("rank", num_queries, 0, bench_now() - start);
+
+    for (uint32_t i = 0; i < num_queries; ++i) {
+      queries[i] = queries[i] % count;
+    }
+
+    start = bench_now();
+
+    for (uint32_t i = 0; i < num_queries; ++i) {
+      checksum += tinygraph_rankselect_select(rs, queries[i]);
+    }
+
+    bench_report("select", num_queries, 0, bench_now() - start);
+
+    for (uint32_t i = 0; i < num_queries; ++i) {
+      queries[i] = queries[i] % (n - count);
+    }
+
+    start = bench_now();
+
+    for (uint32_t i = 0; i < num_queries; ++i) {
+      checksum += tinygraph_rankselect_select0(rs, queries[i]);
+    }
+
+    bench_report("select0", num_queries, 0, bench_now() - start);
+
+    printf("checksum %ju\n", (uintmax_t)checksum);
+
+    tinygraph_rankselect_destruct(rs);
+    tinygraph_bitset_destruct(bits);
+  }
+
+  free(queries);
+  tinygraph_rng_destruct(rng);
+}
+
+
+void bench_select(void) {
+  const uint32_t n = UINT32_C(1) << 16;
+  const uint32_t rounds = 500;
+
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  uint64_t *words = malloc(n * sizeof(uint64_t));
+  uint32_t *ranks = malloc(n * sizeof(uint32_t));
+  uint32_t *xs = malloc(n * sizeof(uint32_t));
+  uint32_t *ys = malloc(n * sizeof(uint32_t));
+  assert(words && ranks && xs && ys);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    words[i] = (uint64_t)tinygraph_rng_random(rng) << 32 | tinygraph_rng_random(rng) | 1;
+    ranks[i] = tinygraph_rng_bounded(rng, tinygraph_bits_count(words[i]));
+    xs[i] = tinygraph_rng_random(rng);
+    ys[i] = tinygraph_rng_random(rng);
+  }
+
+  printf("select and z-order (fast pdep: %s, avx512: %s)\n",
+      tinygraph_cpu_has_fast_pdep() ? "yes" : "no",
+      tinygraph_cpu_has_avx512() ? "yes" : "no");
+
+  uint64_t checksum = 0;
+
+#define BENCH_SELECT(name, fn) do {                  \
+    const double start = bench_now();                \
+                                                     \
+    for (uint32_t r = 0; r < rounds; ++r) {          \
+      for (uint32_t i = 0; i < n; ++i) {             \
+        checksum += fn(words[i], ranks[i]);          \
+      }                                              \
+    }                                                \
+                                                     \
+    bench_report(name, (uint64_t)n * rounds, 0, bench_now() - start); \
+  } while (0)
+
+#define BENCH_ZORDER(name, fn) do {                  \
+    const double start = bench_now();                \
+                                                     \
+    for (uint32_t r = 0; r < rounds; ++r) {          \
+      for (uint32_t i = 0; i < n; ++i) {             \
+        checksum += fn(xs[i], ys[i] + r);            \
+      }                                              \
+    }                                                \
+                                                     \
+    bench_report(name, (uint64_t)n * rounds, 0, bench_now() - start); \
+  } while (0)
+
+  BENCH_SELECT("select dispatched", tinygraph_bits_select);
+  BENCH_SELECT("select broadword", tinygraph_bits_select_broadword);
+
+  if (tinygraph_cpu_has_bmi2()) {
+    BENCH_SELECT("select pdep", tinygraph_bits_select_pdep);
+  }
+
+  BENCH_ZORDER("zorder encode dispatched", tinygraph_zorder_encode64);
+
+  uint64_t *zs = malloc(n * sizeof(uint64_t));
+  assert(zs);
+
+  const double start = bench_now();
+
+  for (uint32_t r = 0; r < rounds; ++r) {
+    tinygraph_zorder_encode64_n(xs, ys, zs, n);
+    checksum += zs[r % n];
+    ys[r % n] += 1;
+  }
+
+  bench_report("zorder encode bulk", (uint64_t)n * rounds, 0, bench_now() - start);
+
+  free(zs);
+
+  BENCH_ZORDER("zorder encode lut", tinygraph_zorder_encode64_lut);
+
+  if (tinygraph_cpu_has_bmi2()) {
+    BENCH_ZORDER("zorder encode pdep", tinygraph_zorder_encode64_pdep);
+  }
+
+#undef BENCH_SELECT
+#undef BENCH_ZORDER
+
+  printf("checksum %ju\n", (uintmax_t)checksum);
+
+  free(ys);
+  free(xs);
+  free(ranks);
+  free(words);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+typedef struct bench_edge {
+  uint32_t source;
+  uint32_t target;
+} bench_edge;
+
+static int bench_edge_cmp(const void *lhs, const void *rhs) {
+  const bench_edge elhs = *(const bench_edge *)lhs;
+  const bench_edge erhs = *(const bench_edge *)rhs;
+
+  if (elhs.source != erhs.source) {
+    return elhs.source < erhs.source ? -1 : 1;
+  }
+
+  return (elhs.target > erhs.target) - (elhs.target < erhs.target);
+}
+
+
+void bench_sort(void) {
+  const uint32_t n = UINT32_C(1) << 24;
+  const uint32_t num_nodes = UINT32_C(1) << 22;
+
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  uint32_t *sources = malloc(n * sizeof(uint32_t));
+  uint32_t *targets = malloc(n * sizeof(uint32_t));
+  uint32_t *sorted_sources = malloc(n * sizeof(uint32_t));
+  uint32_t *sorted_targets = malloc(n * sizeof(uint32_t));
+  bench_edge *edges = malloc(n * sizeof(bench_edge));
+  assert(sources && targets && sorted_sources && sorted_targets && edges);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    sources[i] = tinygraph_rng_bounded(rng, num_nodes);
+    targets[i] = tinygraph_rng_bounded(rng, num_nodes);
+  }
+
+  printf("sorting %ju edges\n", (uintmax_t)n);
+
+  // The former qsort path: copy into edge structs, sort
+  // with a comparator callback, copy back out again
+
+  double start = bench_now();
+
+  for (uint32_t i = 0; i < n; ++i) {
+    edges[i] = (bench_edge){ .source = sources[i], .target = targets[i] };
+  }
+
+  qsort(edges, n, sizeof(bench_edge), bench_edge_cmp);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    sorted_sources[i] = edges[i].source;
+    sorted_targets[i] = edges[i].target;
+  }
+
+  bench_report("qsort edges", n, 0, bench_now() - start);
+
+  memcpy(sorted_sources, sources, n * sizeof(uint32_t));
+  memcpy(sorted_targets, targets, n * sizeof(uint32_t));
+
+  start = bench_now();
+
+  const bool ok = tinygraph_sort_sources_targets(sorted_sources, sorted_targets, n);
+  assert(ok);
+  (void)ok;
+
+  bench_report("radix sort edges", n, 0, bench_now() - start);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    assert(sorted_sources[i] == edges[i].source);
+    assert(sorted_targets[i] == edges[i].target);
+  }
+
+  start = bench_now();
+
+  tinygraph_s graph = tinygraph_construct_from_unsorted_edges(sources, targets, n);
+  assert(graph);
+
+  bench_report("construct from unsorted edges", n, 0, bench_now() - start);
+
+  tinygraph_destruct(graph);
+
+  // Weights along with the edges: a payload carrying construction
+  // against constructing and then sorting the weights on their own
+
+  uint16_t *weights = malloc(n * sizeof(uint16_t));
+  uint16_t *weights_out = malloc(n * sizeof(uint16_t));
+  assert(weights && weights_out);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    weights[i] = (uint16_t)(sources[i] ^ targets[i]);
+  }
+
+  start = bench_now();
+
+  graph = tinygraph_construct_from_unsorted_edges_payload(sources, targets, n, weights, weights_out, sizeof(uint16_t));
+  assert(graph);
+
+  bench_report("construct with weights", n, 0, bench_now() - start);
+
+  tinygraph_destruct(graph);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    assert(weights_out[i] == (uint16_t)(sorted_sources[i] ^ sorted_targets[i]));
+  }
+
+  free(weights_out);
+  free(weights);
+
+  start = bench_now();
+
+  graph = tinygraph_construct_from_unsorted_edges_parallel(sources, targets, n, 4);
+  assert(graph);
+
+  bench_report("construct, 4 threads", n, 0, bench_now() - start);
+
+  start = bench_now();
+
+  tinygraph_s reversed = tinygraph_copy_reversed(graph);
+  assert(reversed);
+
+  bench_report("copy reversed", n, 0, bench_now() - start);
+
+  tinygraph_destruct(reversed);
+
+  start = bench_now();
+
+  reversed = tinygraph_copy_reversed_parallel(graph, 4);
+  assert(reversed);
+
+  bench_report("copy reversed, 4 threads", n, 0, bench_now() - start);
+
+  tinygraph_destruct(reversed);
+  tinygraph_destruct(graph);
+
+  free(edges);
+  free(sorted_targets);
+  free(sorted_sources);
+  free(targets);
+  free(sources);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+// Reports the distribution of the node id gaps between
+// neighbors, which the delta vbyte compression and the
+// cache misses during traversal depend on
+static void bench_gaps(const char *name, tinygraph_const_s graph) {
+  uint64_t widths[33] = {0};
+  double log_gaps = 0;
+
+  const uint32_t num_edges = tinygraph_get_num_edges(graph);
+
+  TINYGRAPH_FOR_EACH_NODE(s, graph) {
+    const uint32_t *it, *last;
+    tinygraph_get_neighbors(graph, &it, &last, s);
+
+    for (; it != last; ++it) {
+      const uint32_t gap = s > *it ? s - *it : *it - s;
+      const uint32_t width = gap == 0 ? 0 : 32 - tinygraph_bits_leading0_u32(gap);
+
+      widths[width] += 1;
+      log_gaps += log2(1.0 + gap);
+    }
+  }
+
+  tinygraph_s compressed = tinygraph_copy_compressed(graph);
+  assert(compressed);
+
+  const uint32_t size = tinygraph_size_in_bytes(compressed);
+
+  tinygraph_destruct(compressed);
+
+  uint64_t below7 = 0, below14 = 0;
+
+  for (uint32_t i = 0; i < 33; ++i) {
+    below7 += i <= 7 ? widths[i] : 0;
+    below14 += i <= 14 ? widths[i] : 0;
+  }
+
+  printf("%-10s avg log2 gap %5.2f, gaps < 2^7 %5.1f%%, < 2^14 %5.1f%%, compressed %.2f bytes/edge\n",
+      name, log_gaps / num_edges, 100.0 * below7 / num_edges, 100.0 * below14 / num_edges,
+      (double)size / num_edges);
+
+  double log_gap;
+  const uint32_t wasted = tinygraph_bytes_wasted((tinygraph *)graph, &log_gap);
+
+  printf("%-10s avg log2 vbyte gap %5.2f, %.2f bytes/edge saved by compression\n",
+      name, log_gap, (double)wasted / num_edges);
+
+  printf("%-10s gap bit widths %%:", name);
+
+  for (uint32_t i = 0; i <= 24; i += 2) {
+    printf(" %u:%.1f", i, 100.0 * (widths[i] + widths[i + 1]) / num_edges);
+  }
+
+  printf("\n");
+}
+
+
+void bench_reorder(void) {
+  // A road network like grid graph with jittered node
+  // coordinates, neighbors in four directions, and
+  // node ids in random order as a starting point
+
+  const uint32_t side = 512;
+  const uint32_t num_nodes = side * side;
+
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  uint32_t *ids = malloc(num_nodes * sizeof(uint32_t));
+  uint16_t *lngs = malloc(num_nodes * sizeof(uint16_t));
+  uint16_t *lats = malloc(num_nodes * sizeof(uint16_t));
+  uint32_t *sources = malloc(4 * num_nodes * sizeof(uint32_t));
+  uint32_t *targets = malloc(4 * num_nodes * sizeof(uint32_t));
+  uint32_t *nodes = malloc(num_nodes * sizeof(uint32_t));
+  assert(ids && lngs && lats && sources && targets && nodes);
+
+  for (uint32_t i = 0; i < num_nodes; ++i) {
+    ids[i] = i;
+  }
+
+  for (uint32_t i = num_nodes - 1; i > 0; --i) {
+    const uint32_t j = tinygraph_rng_bounded(rng, i + 1);
+    const uint32_t tmp = ids[i];
+    ids[i] = ids[j];
+    ids[j] = tmp;
+  }
+
+  uint32_t n = 0;
+
+  for (uint32_t x = 0; x < side; ++x) {
+    for (uint32_t y = 0; y < side; ++y) {
+      const uint32_t v = ids[x * side + y];
+
+      lngs[v] = (uint16_t)(x * 128 + tinygraph_rng_bounded(rng, 128));
+      lats[v] = (uint16_t)(y * 128 + tinygraph_rng_bounded(rng, 128));
+
+      if (x + 1 < side) {
+        sources[n] = v; targets[n] = ids[(x + 1) * side + y]; n += 1;
+        sources[n] = ids[(x + 1) * side + y]; targets[n] = v; n += 1;
+      }
+
+      if (y + 1 < side) {
+        sources[n] = v; targets[n] = ids[x * side + y + 1]; n += 1;
+        sources[n] = ids[x * side + y + 1]; targets[n] = v; n += 1;
+      }
+    }
+  }
+
+  tinygraph_s graph = tinygraph_construct_from_unsorted_edges(sources, targets, n);
+  assert(graph);
+
+  printf("reordering %ju nodes, %ju edges\n", (uintmax_t)num_nodes, (uintmax_t)n);
+
+  bench_gaps("random", graph);
+
+  const tinygraph_curve curves[2] = {TINYGRAPH_CURVE_ZORDER, TINYGRAPH_CURVE_HILBERT};
+  const char *names[2] = {"z-order", "hilbert"};
+
+  for (uint32_t k = 0; k < 2; ++k) {
+    for (uint32_t i = 0; i < num_nodes; ++i) {
+      nodes[i] = i;
+    }
+
+    double start = bench_now();
+
+    const bool ok = tinygraph_reorder_curve(nodes, lngs, lats, num_nodes, curves[k]);
+    assert(ok);
+    (void)ok;
+
+    bench_report(names[k], num_nodes, 0, bench_now() - start);
+
+    start = bench_now();
+
+    tinygraph_s permuted = tinygraph_permute(graph, nodes, NULL, NULL);
+    assert(permuted);
+
+    bench_report("permute", n, 0, bench_now() - start);
+
+    bench_gaps(names[k], permuted);
+
+    tinygraph_destruct(permuted);
+  }
+
+  // Orders from the graph's structure alone, without coordinates
+
+  const char *topologies[3] = {"degree", "rcm", "gorder"};
+
+  for (uint32_t k = 0; k < 3; ++k) {
+    double start = bench_now();
+
+    bool ok = false;
+
+    switch (k) {
+      case 0: ok = tinygraph_reorder_degree(graph, nodes); break;
+      case 1: ok = tinygraph_reorder_rcm(graph, nodes); break;
+      case 2: ok = tinygraph_reorder_gorder(graph, nodes, 5); break;
+    }
+
+    assert(ok);
+    (void)ok;
+
+    bench_report(topologies[k], num_nodes, 0, bench_now() - start);
+
+    tinygraph_s permuted = tinygraph_permute(graph, nodes, NULL, NULL);
+    assert(permuted);
+
+    bench_gaps(topologies[k], permuted);
+
+    tinygraph_destruct(permuted);
+  }
+
+  // The same nodes with 32 bit coordinates, fully and coarse ordered
+
+  uint32_t *lngs32 = malloc(num_nodes * sizeof(uint32_t));
+  uint32_t *lats32 = malloc(num_nodes * sizeof(uint32_t));
+  assert(lngs32 && lats32);
+
+  for (uint32_t i = 0; i < num_nodes; ++i) {
+    lngs32[i] = (uint32_t)lngs[i] << 16 | tinygraph_rng_bounded(rng, 1 << 16);
+    lats32[i] = (uint32_t)lats[i] << 16 | tinygraph_rng_bounded(rng, 1 << 16);
+  }
+
+  for (uint32_t coarse = 0; coarse < 2; ++coarse) {
+    for (uint32_t i = 0; i < num_nodes; ++i) {
+      nodes[i] = i;
+    }
+
+    const bool ok = tinygraph_reorder32(nodes, lngs32, lats32, num_nodes, TINYGRAPH_CURVE_HILBERT, coarse);
+    assert(ok);
+    (void)ok;
+
+    tinygraph_s permuted = tinygraph_permute(graph, nodes, NULL, NULL);
+    assert(permuted);
+
+    bench_gaps(coarse ? "coarse" : "hilbert32", permuted);
+
+    tinygraph_destruct(permuted);
+  }
+
+  free(lats32);
+  free(lngs32);
+
+  tinygraph_destruct(graph);
+
+  free(nodes);
+  free(targets);
+  free(sources);
+  free(lats);
+  free(lngs);
+  free(ids);
+
+  // Reordering run-time on more nodes than fit into the caches
+
+  const uint32_t m = UINT32_C(1) << 23;
+
+  nodes = malloc(m * sizeof(uint32_t));
+  lngs32 = malloc(m * sizeof(uint32_t));
+  lats32 = malloc(m * sizeof(uint32_t));
+  assert(nodes && lngs32 && lats32);
+
+  for (uint32_t i = 0; i < m; ++i) {
+    lngs32[i] = tinygraph_rng_random(rng);
+    lats32[i] = tinygraph_rng_random(rng);
+  }
+
+  printf("reordering %ju nodes with 32 bit coordinates\n", (uintmax_t)m);
+
+  for (uint32_t k = 0; k < 2; ++k) {
+    for (uint32_t coarse = 0; coarse < 2; ++coarse) {
+      for (uint32_t i = 0; i < m; ++i) {
+        nodes[i] = i;
+      }
+
+      const double start = bench_now();
+
+      const bool ok = tinygraph_reorder32(nodes, lngs32, lats32, m, curves[k], coarse);
+      assert(ok);
+      (void)ok;
+
+      char name[32];
+      snprintf(name, sizeof(name), "%s%s", names[k], coarse ? ", coarse" : "");
+
+      bench_report(name, m, 0, bench_now() - start);
+    }
+  }
+
+  free(lats32);
+  free(lngs32);
+  free(nodes);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void bench_dijkstra(void) {
+  // A road network like grid graph with node ids in
+  // row-major order and travel times as edge weights
+
+  const uint32_t side = 512;
+  const uint32_t num_nodes = side * side;
+
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  uint32_t *sources = malloc(4 * num_nodes * sizeof(uint32_t));
+  uint32_t *targets = malloc(4 * num_nodes * sizeof(uint32_t));
+  assert(sources && targets);
+
+  uint32_t n = 0;
+
+  for (uint32_t x = 0; x < side; ++x) {
+    for (uint32_t y = 0; y < side; ++y) {
+      const uint32_t v = x * side + y;
+
+      if (x + 1 < side) {
+        sources[n] = v; targets[n] = v + side; n += 1;
+        sources[n] = v + side; targets[n] = v; n += 1;
+      }
+
+      if (y + 1 < side) {
+        sources[n] = v; targets[n] = v + 1; n += 1;
+        sources[n] = v + 1; targets[n] = v; n += 1;
+      }
+    }
+  }
+
+  tinygraph_s graph = tinygraph_construct_from_unsorted_edges(sources, targets, n);
+  assert(graph);
+
+  uint16_t *weights = malloc(n * sizeof(uint16_t));
+  assert(weights);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    weights[i] = 1 + tinygraph_rng_bounded(rng, 1000);
+  }
+
+  const uint32_t num_queries = 20;
+
+  uint32_t *queries = malloc(2 * num_queries * sizeof(uint32_t));
+  assert(queries);
+
+  for (uint32_t i = 0; i < 2 * num_queries; ++i) {
+    queries[i] = tinygraph_rng_bounded(rng, num_nodes);
+  }
+
+  printf("dijkstra on %ju nodes, %ju edges\n", (uintmax_t)num_nodes, (uintmax_t)n);
+
+  const tinygraph_dijkstra_queue queues[4] = {
+    TINYGRAPH_DIJKSTRA_QUEUE_BINARY_HEAP,
+    TINYGRAPH_DIJKSTRA_QUEUE_RADIX_HEAP,
+    TINYGRAPH_DIJKSTRA_QUEUE_BUCKET_QUEUE,
+    TINYGRAPH_DIJKSTRA_QUEUE_INDEXED_HEAP,
+  };
+
+  const char *names[4] = {"binary heap", "radix heap", "bucket queue", "indexed heap"};
+
+  for (uint32_t k = 0; k < 4; ++k) {
+    tinygraph_dijkstra_s ctx = tinygraph_dijkstra_construct_with_queue(graph, weights, queues[k]);
+    assert(ctx);
+
+    uint64_t checksum = 0;
+
+    const double start = bench_now();
+
+    for (uint32_t i = 0; i < num_queries; ++i) {
+      const bool ok = tinygraph_dijkstra_shortest_path(ctx, queries[2 * i], queries[2 * i + 1]);
+      assert(ok);
+      (void)ok;
+
+      checksum += tinygraph_dijkstra_get_distance(ctx);
+    }
+
+    const double seconds = bench_now() - start;
+
+    printf("%-32s %10.2f ms/query (%ju)\n", names[k],
+        seconds / num_queries * 1e3, (uintmax_t)checksum);
+
+    tinygraph_dijkstra_destruct(ctx);
+  }
+
+  // Bidirectional searches meet halfway and settle
+  // about half the nodes on road network like graphs
+
+  tinygraph_bidirectional_s bidir = tinygraph_bidirectional_construct(graph);
+  assert(bidir);
+
+  for (uint32_t k = 0; k < 4; ++k) {
+    tinygraph_dijkstra_s ctx = tinygraph_dijkstra_construct_bidirectional(bidir, weights, queues[k]);
+    assert(ctx);
+
+    uint64_t checksum = 0;
+
+    const double start = bench_now();
+
+    for (uint32_t i = 0; i < num_queries; ++i) {
+      const bool ok = tinygraph_dijkstra_shortest_path(ctx, queries[2 * i], queries[2 * i + 1]);
+      assert(ok);
+      (void)ok;
+
+      checksum += tinygraph_dijkstra_get_distance(ctx);
+    }
+
+    const double seconds = bench_now() - start;
+
+    printf("bidirectional %-18s %10.2f ms/query (%ju)\n", names[k],
+        seconds / num_queries * 1e3, (uintmax_t)checksum);
+
+    tinygraph_dijkstra_destruct(ctx);
+  }
+
+  tinygraph_bidirectional_destruct(bidir);
+
+  // A* searches with the grid positions as coordinates;
+  // a unit long edge weighs at least one, the potential
+  // is a weak lower bound for the random travel times
+
+  uint32_t *lngs = malloc(num_nodes * sizeof(uint32_t));
+  uint32_t *lats = malloc(num_nodes * sizeof(uint32_t));
+  assert(lngs && lats);
+
+  for (uint32_t v = 0; v < num_nodes; ++v) {
+    lngs[v] = v / side * 1000;
+    lats[v] = v % side * 1000;
+  }
+
+  for (uint32_t k = 0; k < 4; ++k) {
+    tinygraph_dijkstra_s ctx = tinygraph_dijkstra_construct_astar(graph, weights, lngs, lats, 1e-3, queues[k]);
+    assert(ctx);
+
+    uint64_t checksum = 0;
+
+    const double start = bench_now();
+
+    for (uint32_t i = 0; i < num_queries; ++i) {
+      const bool ok = tinygraph_dijkstra_shortest_path(ctx, queries[2 * i], queries[2 * i + 1]);
+      assert(ok);
+      (void)ok;
+
+      checksum += tinygraph_dijkstra_get_distance(ctx);
+    }
+
+    const double seconds = bench_now() - start;
+
+    printf("astar %-26s %10.2f ms/query (%ju)\n", names[k],
+        seconds / num_queries * 1e3, (uintmax_t)checksum);
+
+    tinygraph_dijkstra_destruct(ctx);
+  }
+
+  free(lngs);
+  free(lats);
+
+  // Local queries a few nodes apart, where resetting the
+  // context between queries used to dominate the search
+
+  tinygraph_dijkstra_s ctx = tinygraph_dijkstra_construct(graph, weights);
+  assert(ctx);
+
+  const uint32_t num_local = 20000;
+
+  uint64_t checksum = 0;
+
+  const double start = bench_now();
+
+  for (uint32_t i = 0; i < num_local; ++i) {
+    const uint32_t x = queries[i % (2 * num_queries)] % (side - 2);
+    const uint32_t y = queries[i % (2 * num_queries)] / side % (side - 2);
+
+    const uint32_t s = x * side + y;
+    const uint32_t t = (x + 2) * side + y + 2;
+
+    const bool ok = tinygraph_dijkstra_shortest_path(ctx, s, t);
+    assert(ok);
+    (void)ok;
+
+    checksum += tinygraph_dijkstra_get_distance(ctx);
+
+    // Different source nodes in a row
+    const bool okr = tinygraph_dijkstra_shortest_path(ctx, t, s);
+    assert(okr);
+    (void)okr;
+  }
+
+  const double seconds = bench_now() - start;
+
+  printf("%-32s %10.2f us/query (%ju)\n", "local queries",
+      seconds / (2 * num_local) * 1e6, (uintmax_t)checksum);
+
+  tinygraph_dijkstra_destruct(ctx);
+
+  free(queries);
+  free(weights);
+  tinygraph_destruct(graph);
+  free(targets);
+  free(sources);
+
+  tinygraph_rng_destruct(rng);
+}
+
+int main(void) {
+  bench_vbyte();
+  bench_elias();
+  bench_popcount();
+  bench_rankselect();
+  bench_select();
+  bench_sort();
+  bench_reorder();
+  bench_dijkstra();
+}
@@ -1,19 +1,29 @@
 #include "tinygraph-utils.h"
 #include "tinygraph-bits.h"
+#include "tinygraph-cpu.h"
 
-#ifdef __BMI2__
+#if defined(__x86_64__) || defined(__i386__)
 #include <x86intrin.h>
 #endif
 
 /*
- * If we can not use the builtin functions, we should
- * look into the broadword ideas from the paper below.
+ * For select in a word we pick at load time between
+ * PDEP on hosts where it is fast and the broadword
+ * select from the paper below everywhere else.
  *
  * See
  * - https://vigna.di.unimi.it/ftp/papers/Broadword.pdf
  *
- * Todo
- * - faster popcnt e.g. https://arxiv.org/abs/1611.07612
+ * On hosts with AVX-512 and VPOPCNTDQ we count the
+ * bits in our 512 bit blocks as one zmm register.
+ *
+ * For counting bits in long ranges we use the AVX2
+ * Harley-Seal popcount from the paper below: a tree of
+ * carry-save adders over 16 vectors at a time and the
+ * vpshufb nibble lookup popcount for the adders' sums.
+ *
+ * See
+ * - https://arxiv.org/abs/1611.07612
  */
 
 uint32_t tinygraph_bits_count(uint64_t v) {
@@ -35,9 +45,10 @@ uint32_t tinygraph_bits_rank(uint64_t v, uint32_t n) {
   return tinygraph_bits_count(v << (UINT32_C(64) - n));
 }
 
-#ifdef __BMI2__
+#if defined(__x86_64__) || defined(__i386__)
 
-uint32_t tinygraph_bits_select(uint64_t v, uint32_t n) {
+__attribute__((target("bmi2")))
+uint32_t tinygraph_bits_select_pdep(uint64_t v, uint32_t n) {
   TINYGRAPH_STATIC_ASSERT(sizeof(uint64_t) == sizeof(unsigned long long));
   TINYGRAPH_ASSERT(n < tinygraph_bits_count(v));
 
@@ -50,11 +61,9 @@ uint32_t tinygraph_bits_select(uint64_t v, uint32_t n) {
   return tinygraph_bits_trailing0_u64(_pdep_u64(UINT64_C(1) << n, v));
 }
 
-#else // __BMI2__
+#endif
 
-// TODO: this non-BMI2 fallback is pretty slow; can we do better?
-// use select impl. idea from https://vigna.di.unimi.it/ftp/papers/Broadword.pdf
-uint32_t tinygraph_bits_select(uint64_t v, uint32_t n) {
+uint32_t tinygraph_bits_select_broadword(uint64_t v, uint32_t n) {
   TINYGRAPH_STATIC_ASSERT(sizeof(uint64_t) == sizeof(unsigned long long));
   TINYGRAPH_ASSERT(n < tinygraph_bits_count(v));
 
@@ -62,22 +71,48 @@ uint32_t tinygraph_bits_select(uint64_t v, uint32_t n) {
     TINYGRAPH_UNREACHABLE();
   }
 
-  uint32_t set = 0;
+  // "Broadword Implementation of Rank/Select Queries", Vigna
+  // https://vigna.di.unimi.it/ftp/papers/Broadword.pdf
+  //
+  // Sideways addition gives us the popcount per byte; the
+  // multiplication turns them into inclusive prefix sums
+  // per byte, with the total in the most significant byte.
 
-  for (uint32_t i = 0; i < 64; ++i) {
-    if ((v & (UINT64_C(1) << i)) != 0) {
-      if (set == n) {
-        return i;
-      }
+  const uint64_t ones8 = UINT64_C(0x0101010101010101);
+  const uint64_t msbs8 = UINT64_C(0x8080808080808080);
 
-      set += 1;
-    }
+  uint64_t s = v - ((v >> 1) & UINT64_C(0x5555555555555555));
+  s = (s & UINT64_C(0x3333333333333333)) + ((s >> 2) & UINT64_C(0x3333333333333333));
+  s = ((s + (s >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f)) * ones8;
+
+  // Byte-parallel comparison n >= s[i]: the most significant
+  // bit in each byte survives the subtraction exactly then;
+  // the number of such bytes is the byte our bit lives in.
+
+  const uint64_t geq = ((n * ones8) | msbs8) - s;
+  const uint32_t place = (uint32_t)(((geq & msbs8) >> 7) * ones8 >> 56) * 8;
+
+  // Set bits in the bytes before the one we are looking for
+  const uint32_t before = (uint32_t)((s << 8) >> place) & 0xff;
+
+  uint64_t byte = (v >> place) & 0xff;
+
+  for (uint32_t i = before; i < n; ++i) {
+    byte &= byte - 1;
   }
 
-  return 64;
+  return place + tinygraph_bits_trailing0_u64(byte);
 }
 
-#endif // __BMI2__
+uint32_t tinygraph_bits_select(uint64_t v, uint32_t n) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (TINYGRAPH_LIKELY(tinygraph_cpu_has_fast_pdep())) {
+    return tinygraph_bits_select_pdep(v, n);
+  }
+#endif
+
+  return tinygraph_bits_select_broadword(v, n);
+}
 
 
 uint32_t tinygraph_bits_leading0_u32(uint32_t v) {
@@ -120,10 +155,52 @@ uint32_t tinygraph_bits_trailing0_u64(uint64_t v) {
   return __builtin_ctzll(v);
 }
 
+#if defined(__x86_64__) || defined(__i386__)
+
+// On AVX-512 hosts a 512 bit block is exactly one zmm register;
+// we count its bits with VPOPCNTQ and a single lane reduction
+
+TINYGRAPH_TARGET_AVX512_POPCNT
+static uint32_t tinygraph_bits_count_512_avx512(const uint64_t * restrict p) {
+  return (uint32_t)_mm512_reduce_add_epi64(_mm512_popcnt_epi64(_mm512_loadu_si512((const void *)p)));
+}
+
+TINYGRAPH_TARGET_AVX512_POPCNT
+static uint32_t tinygraph_bits_rank_512_avx512(const uint64_t * restrict p, uint32_t n) {
+  // Per lane the number of bits to keep, clamped to [0, 64];
+  // a variable shift by 64 or more bits results in zero
+
+  const __m512i lanes = _mm512_setr_epi64(0, 64, 128, 192, 256, 320, 384, 448);
+  const __m512i width = _mm512_set1_epi64(64);
+
+  __m512i keep = _mm512_sub_epi64(_mm512_set1_epi64(n), lanes);
+  keep = _mm512_min_epi64(_mm512_max_epi64(keep, _mm512_setzero_si512()), width);
+
+  const __m512i mask = _mm512_srlv_epi64(_mm512_set1_epi64(-1), _mm512_sub_epi64(width, keep));
+  const __m512i v = _mm512_and_si512(_mm512_loadu_si512((const void *)p), mask);
+
+  return (uint32_t)_mm512_reduce_add_epi64(_mm512_popcnt_epi64(v));
+}
+
+TINYGRAPH_TARGET_AVX512_POPCNT
+static void tinygraph_bits_count_512_n_avx512(const uint64_t * restrict p, uint64_t n, uint32_t * restrict counts) {
+  for (uint64_t i = 0; i < n; ++i) {
+    counts[i] = (uint32_t)_mm512_reduce_add_epi64(_mm512_popcnt_epi64(_mm512_loadu_si512((const void *)(p + i * 8))));
+  }
+}
+
+#endif
+
 uint32_t tinygraph_bits_count_512(const uint64_t * restrict p) {
   TINYGRAPH_STATIC_ASSERT(sizeof(uint64_t) == sizeof(unsigned long long));
   TINYGRAPH_ASSERT(p);
 
+#if defined(__x86_64__) || defined(__i386__)
+  if (tinygraph_cpu_has_avx512_popcnt()) {
+    return tinygraph_bits_count_512_avx512(p);
+  }
+#endif
+
   //TINYGRAPH_PREFETCH(p);
 
   // Manually unroll loop and accumulate into separare registers,
@@ -158,6 +235,12 @@ uint32_t tinygraph_bits_rank_512(const uint64_t * restrict p, uint32_t n) {
     return 0;
   }
 
+#if defined(__x86_64__) || defined(__i386__)
+  if (tinygraph_cpu_has_avx512_popcnt()) {
+    return tinygraph_bits_rank_512_avx512(p, n);
+  }
+#endif
+
   //TINYGRAPH_PREFETCH(p);
 
   if (n == 512) {
@@ -204,3 +287,190 @@ uint32_t tinygraph_bits_select_512(const uint64_t * restrict p, uint32_t n) {
   // no popcount needed for last block, has to be in there
   return 7 * 64 + tinygraph_bits_select(p[7], n - count);
 }
+
+
+#ifdef __AVX2__
+
+// Per byte popcount via a nibble lookup table, summed up per 64 bit lane
+TINYGRAPH_WARN_UNUSED
+static inline __m256i tinygraph_bits_count_256(__m256i v) {
+  const __m256i lookup = _mm256_setr_epi8(
+      0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+      0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+
+  const __m256i lo = _mm256_and_si256(v, mask);
+  const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), mask);
+
+  const __m256i count = _mm256_add_epi8(
+      _mm256_shuffle_epi8(lookup, lo),
+      _mm256_shuffle_epi8(lookup, hi));
+
+  return _mm256_sad_epu8(count, _mm256_setzero_si256());
+}
+
+// Carry-save adder: h and l are the high and low bits of a + b + c
+static inline void tinygraph_bits_csa_256(__m256i *h, __m256i *l, __m256i a, __m256i b, __m256i c) {
+  const __m256i u = _mm256_xor_si256(a, b);
+
+  *h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+  *l = _mm256_xor_si256(u, c);
+}
+
+#define TINYGRAPH_BITS_LOAD(q, i) _mm256_loadu_si256((const __m256i *)((q) + (i) * 4))
+
+uint64_t tinygraph_bits_count_n(const uint64_t * restrict p, uint64_t n) {
+  TINYGRAPH_ASSERT(p || n == 0);
+
+  __m256i total = _mm256_setzero_si256();
+  __m256i ones = _mm256_setzero_si256();
+  __m256i twos = _mm256_setzero_si256();
+  __m256i fours = _mm256_setzero_si256();
+  __m256i eights = _mm256_setzero_si256();
+  __m256i sixteens, twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+
+  // 16 vectors of 256 bits, that is 64 words per step
+
+  uint64_t i = 0;
+
+  for (; i + 64 <= n; i += 64, p += 64) {
+    tinygraph_bits_csa_256(&twos_a, &ones, ones, TINYGRAPH_BITS_LOAD(p, 0), TINYGRAPH_BITS_LOAD(p, 1));
+    tinygraph_bits_csa_256(&twos_b, &ones, ones, TINYGRAPH_BITS_LOAD(p, 2), TINYGRAPH_BITS_LOAD(p, 3));
+    tinygraph_bits_csa_256(&fours_a, &twos, twos, twos_a, twos_b);
+    tinygraph_bits_csa_256(&twos_a, &ones, ones, TINYGRAPH_BITS_LOAD(p, 4), TINYGRAPH_BITS_LOAD(p, 5));
+    tinygraph_bits_csa_256(&twos_b, &ones, ones, TINYGRAPH_BITS_LOAD(p, 6), TINYGRAPH_BITS_LOAD(p, 7));
+    tinygraph_bits_csa_256(&fours_b, &twos, twos, twos_a, twos_b);
+    tinygraph_bits_csa_256(&eights_a, &fours, fours, fours_a, fours_b);
+    tinygraph_bits_csa_256(&twos_a, &ones, ones, TINYGRAPH_BITS_LOAD(p, 8), TINYGRAPH_BITS_LOAD(p, 9));
+    tinygraph_bits_csa_256(&twos_b, &ones, ones, TINYGRAPH_BITS_LOAD(p, 10), TINYGRAPH_BITS_LOAD(p, 11));
+    tinygraph_bits_csa_256(&fours_a, &twos, twos, twos_a, twos_b);
+    tinygraph_bits_csa_256(&twos_a, &ones, ones, TINYGRAPH_BITS_LOAD(p, 12), TINYGRAPH_BITS_LOAD(p, 13));
+    tinygraph_bits_csa_256(&twos_b, &ones, ones, TINYGRAPH_BITS_LOAD(p, 14), TINYGRAPH_BITS_LOAD(p, 15));
+    tinygraph_bits_csa_256(&fours_b, &twos, twos, twos_a, twos_b);
+    tinygraph_bits_csa_256(&eights_b, &fours, fours, fours_a, fours_b);
+    tinygraph_bits_csa_256(&sixteens, &eights, eights, eights_a, eights_b);
+
+    total = _mm256_add_epi64(total, tinygraph_bits_count_256(sixteens));
+  }
+
+  total = _mm256_slli_epi64(total, 4);
+  total = _mm256_add_epi64(total, _mm256_slli_epi64(tinygraph_bits_count_256(eights), 3));
+  total = _mm256_add_epi64(total, _mm256_slli_epi64(tinygraph_bits_count_256(fours), 2));
+  total = _mm256_add_epi64(total, _mm256_slli_epi64(tinygraph_bits_count_256(twos), 1));
+  total = _mm256_add_epi64(total, tinygraph_bits_count_256(ones));
+
+  uint64_t count = (uint64_t)_mm256_extract_epi64(total, 0)
+    + (uint64_t)_mm256_extract_epi64(total, 1)
+    + (uint64_t)_mm256_extract_epi64(total, 2)
+    + (uint64_t)_mm256_extract_epi64(total, 3);
+
+  for (; i < n; ++i) {
+    count += tinygraph_bits_count(*p++);
+  }
+
+  return count;
+}
+
+static void tinygraph_bits_count_512_n_base(const uint64_t * restrict p, uint64_t n, uint32_t * restrict counts) {
+  TINYGRAPH_ASSERT(p || n == 0);
+  TINYGRAPH_ASSERT(counts || n == 0);
+
+  // Four blocks at a time: the per byte counts of a block's
+  // two vectors are summed into four 64 bit lanes per block,
+  // then we pack two blocks into the lanes' lower and upper
+  // 32 bits and reduce the lanes of both packs at the same time
+
+  uint64_t i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    const uint64_t *q = p + i * 8;
+
+    const __m256i r0 = tinygraph_bits_count_256(TINYGRAPH_BITS_LOAD(q, 0));
+    const __m256i r1 = tinygraph_bits_count_256(TINYGRAPH_BITS_LOAD(q, 1));
+    const __m256i r2 = tinygraph_bits_count_256(TINYGRAPH_BITS_LOAD(q, 2));
+    const __m256i r3 = tinygraph_bits_count_256(TINYGRAPH_BITS_LOAD(q, 3));
+    const __m256i r4 = tinygraph_bits_count_256(TINYGRAPH_BITS_LOAD(q, 4));
+    const __m256i r5 = tinygraph_bits_count_256(TINYGRAPH_BITS_LOAD(q, 5));
+    const __m256i r6 = tinygraph_bits_count_256(TINYGRAPH_BITS_LOAD(q, 6));
+    const __m256i r7 = tinygraph_bits_count_256(TINYGRAPH_BITS_LOAD(q, 7));
+
+    const __m256i b01 = _mm256_or_si256(
+        _mm256_add_epi64(r0, r1),
+        _mm256_slli_epi64(_mm256_add_epi64(r2, r3), 32));
+
+    const __m256i b23 = _mm256_or_si256(
+        _mm256_add_epi64(r4, r5),
+        _mm256_slli_epi64(_mm256_add_epi64(r6, r7), 32));
+
+    const __m128i s01 = _mm_add_epi64(_mm256_castsi256_si128(b01), _mm256_extracti128_si256(b01, 1));
+    const __m128i s23 = _mm_add_epi64(_mm256_castsi256_si128(b23), _mm256_extracti128_si256(b23, 1));
+
+    const __m128i sums = _mm_add_epi64(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23));
+
+    _mm_storeu_si128((__m128i *)(counts + i), sums);
+  }
+
+  for (; i < n; ++i) {
+    counts[i] = tinygraph_bits_count_512(p + i * 8);
+  }
+}
+
+#undef TINYGRAPH_BITS_LOAD
+
+#else // __AVX2__
+
+uint64_t tinygraph_bits_count_n(const uint64_t * restrict p, uint64_t n) {
+  TINYGRAPH_ASSERT(p || n == 0);
+
+  uint64_t count[4] = {0, 0, 0, 0};
+
+  uint64_t i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    count[0] += tinygraph_bits_count(p[i + 0]);
+    count[1] += tinygraph_bits_count(p[i + 1]);
+    count[2] += tinygraph_bits_count(p[i + 2]);
+    count[3] += tinygraph_bits_count(p[i + 3]);
+  }
+
+  for (; i < n; ++i) {
+    count[0] += tinygraph_bits_count(p[i]);
+  }
+
+  return count[0] + count[1] + count[2] + count[3];
+}
+
+static void tinygraph_bits_count_512_n_base(const uint64_t * restrict p, uint64_t n, uint32_t * restrict counts) {
+  TINYGRAPH_ASSERT(p || n == 0);
+  TINYGRAPH_ASSERT(counts || n == 0);
+
+  for (uint64_t i = 0; i < n; ++i) {
+    counts[i] = tinygraph_bits_count_512(p + i * 8);
+  }
+}
+
+#endif // __AVX2__
+
+void tinygraph_bits_count_512_n(const uint64_t * restrict p, uint64_t n, uint32_t * restrict counts) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (tinygraph_cpu_has_avx512_popcnt()) {
+    tinygraph_bits_count_512_n_avx512(p, n, counts);
+    return;
+  }
+#endif
+
+  tinygraph_bits_count_512_n_base(p, n, counts);
+}
+
+uint64_t tinygraph_bits_rank_n(const uint64_t * restrict p, uint64_t n) {
+  TINYGRAPH_ASSERT(p || n == 0);
+
+  const uint64_t count = tinygraph_bits_count_n(p, n / 64);
+
+  if (n % 64 == 0) {
+    return count;
+  }
+
+  return count + tinygraph_bits_rank(p[n / 64], n % 64);
+}
@@ -27,6 +27,14 @@ uint32_t tinygraph_bits_rank(uint64_t v, uint32_t n);
 TINYGRAPH_WARN_UNUSED
 uint32_t tinygraph_bits_select(uint64_t v, uint32_t n);
 
+// The select implementations we dispatch between at
+// runtime; the PDEP one requires BMI2 on the host
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_bits_select_pdep(uint64_t v, uint32_t n);
+
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_bits_select_broadword(uint64_t v, uint32_t n);
+
 TINYGRAPH_WARN_UNUSED
 uint32_t tinygraph_bits_leading0_u32(uint32_t v);
 
@@ -48,5 +56,17 @@ uint32_t tinygraph_bits_rank_512(const uint64_t * restrict p, uint32_t n);
 TINYGRAPH_WARN_UNUSED
 uint32_t tinygraph_bits_select_512(const uint64_t * restrict p, uint32_t n);
 
+// Bulk counting for long ranges: the number of set
+// bits in the n words at p, and in the first n bits
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_bits_count_n(const uint64_t * restrict p, uint64_t n);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_bits_rank_n(const uint64_t * restrict p, uint64_t n);
+
+// Writes the number of set bits of each of the n
+// 512 bit blocks at p into counts, for rank indices
+void tinygraph_bits_count_512_n(const uint64_t * restrict p, uint64_t n, uint32_t * restrict counts);
+
 
 #endif
@@ -4,7 +4,14 @@
 #include <string.h>
 
 #include "tinygraph-utils.h"
+#include "tinygraph-align.h"
+#include "tinygraph-bits.h"
 #include "tinygraph-bitset.h"
+#include "tinygraph-cpu.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 
 typedef struct tinygraph_bitset {
@@ -31,9 +38,17 @@ tinygraph_bitset* tinygraph_bitset_construct(uint64_t size) {
     return out;
   }
 
-  uint64_t num_blocks = ceil(size / 64.f);
+  // Note: integer rounding here, a float based ceil loses
+  // precision for bitsets with more than 2^24 blocks
+  const uint64_t num_blocks = (size + UINT64_C(63)) / UINT64_C(64);
+
+  // We allocate cache-line aligned memory and pad it to a full
+  // cache-line of 512 bits, so that the 512 bit rank and select
+  // kernels can always operate on full cache-lines; the padding
+  // bits are never set and never part of the bitset's size
+  const uint64_t num_padded = (num_blocks + UINT64_C(7)) & ~UINT64_C(7);
 
-  uint64_t *blocks = calloc(num_blocks, sizeof(uint64_t));
+  uint64_t *blocks = tinygraph_align_malloc(64, num_padded * sizeof(uint64_t));
 
   if (!blocks) {
     free(out);
@@ -41,6 +56,8 @@ tinygraph_bitset* tinygraph_bitset_construct(uint64_t size) {
     return NULL;
   }
 
+  memset(blocks, 0, num_padded * sizeof(uint64_t));
+
   out->blocks = blocks;
   out->blocks_len = num_blocks;
 
@@ -53,7 +70,7 @@ tinygraph_bitset* tinygraph_bitset_copy(const tinygraph_bitset * const bitset) {
     return NULL;
   }
 
-  tinygraph_bitset *copy = tinygraph_bitset_construct(bitset->blocks_len);
+  tinygraph_bitset *copy = tinygraph_bitset_construct(bitset->size);
 
   if (!copy) {
     return NULL;
@@ -79,7 +96,7 @@ void tinygraph_bitset_destruct(tinygraph_bitset * const bitset) {
 
   TINYGRAPH_ASSERT(bitset->blocks || bitset->blocks_len == 0);
 
-  free(bitset->blocks);
+  tinygraph_align_free(bitset->blocks);
 
   bitset->blocks = NULL;
   bitset->blocks_len = 0;
@@ -97,6 +114,15 @@ void tinygraph_bitset_set_at(tinygraph_bitset * const bitset, uint64_t i) {
 }
 
 
+void tinygraph_bitset_clear_at(tinygraph_bitset * const bitset, uint64_t i) {
+  TINYGRAPH_ASSERT(bitset);
+  TINYGRAPH_ASSERT(bitset->blocks_len > 0);
+  TINYGRAPH_ASSERT((i >> 6) < bitset->blocks_len);
+
+  bitset->blocks[i >> 6] &= ~(UINT64_C(1) << (i & UINT64_C(63)));
+}
+
+
 bool tinygraph_bitset_get_at(const tinygraph_bitset * const bitset, uint64_t i) {
   TINYGRAPH_ASSERT(bitset);
   TINYGRAPH_ASSERT(bitset->blocks_len > 0);
@@ -113,6 +139,60 @@ uint64_t tinygraph_bitset_get_size(const tinygraph_bitset * const bitset) {
 }
 
 
+const uint64_t* tinygraph_bitset_get_data(const tinygraph_bitset * const bitset) {
+  TINYGRAPH_ASSERT(bitset);
+
+  return bitset->blocks;
+}
+
+
+uint64_t tinygraph_bitset_get_size_in_bytes(const tinygraph_bitset * const bitset) {
+  TINYGRAPH_ASSERT(bitset);
+
+  const uint64_t num_padded = (bitset->blocks_len + UINT64_C(7)) & ~UINT64_C(7);
+
+  return sizeof(tinygraph_bitset) + num_padded * sizeof(uint64_t);
+}
+
+
+uint64_t tinygraph_bitset_count(const tinygraph_bitset * const bitset) {
+  TINYGRAPH_ASSERT(bitset);
+
+  // The bits past the bitset's size are always unset
+  return tinygraph_bits_count_n(bitset->blocks, bitset->blocks_len);
+}
+
+
+uint64_t tinygraph_bitset_find_next(const tinygraph_bitset * const bitset, uint64_t i) {
+  TINYGRAPH_ASSERT(bitset);
+
+  if (i >= bitset->size) {
+    return bitset->size;
+  }
+
+  // Mask out the bits before i in the first block, then
+  // skip over empty blocks; for our succinct offsets the
+  // next set bit is almost always in the very same block
+
+  uint64_t b = i >> 6;
+  uint64_t block = bitset->blocks[b] & (UINT64_MAX << (i & UINT64_C(63)));
+
+  while (block == 0) {
+    b += 1;
+
+    if (b >= bitset->blocks_len) {
+      return bitset->size;
+    }
+
+    block = bitset->blocks[b];
+  }
+
+  const uint64_t rv = (b << 6) + (uint64_t)__builtin_ctzll(block);
+
+  return rv < bitset->size ? rv : bitset->size;
+}
+
+
 void tinygraph_bitset_clear(tinygraph_bitset * const bitset) {
   TINYGRAPH_ASSERT(bitset);
 
@@ -130,13 +210,54 @@ void tinygraph_bitset_not(tinygraph_bitset * const bitset) {
   for (uint64_t i = 0; i < bitset->blocks_len; ++i) {
     bitset->blocks[i] = ~bitset->blocks[i];
   }
+
+  // Keep the bits past the bitset's size unset, otherwise
+  // counting set bits on full blocks would pick them up
+  const uint64_t tail = bitset->size & UINT64_C(63);
+
+  if (tail != 0) {
+    bitset->blocks[bitset->blocks_len - 1] &= (UINT64_C(1) << tail) - 1;
+  }
 }
 
 
+#if defined(__x86_64__) || defined(__i386__)
+
+// On AVX-512 hosts one cache-line is one zmm register: we run the
+// bitwise operations over the zero padded, cache-line aligned
+// blocks, for which the padding stays unset in all three of them
+
+#define TINYGRAPH_BITSET_AVX512_OP(name, op)                                          \
+  TINYGRAPH_TARGET_AVX512                                                             \
+  static void name(uint64_t *blocks, const uint64_t *other, uint64_t n) {               \
+    for (uint64_t i = 0; i < n; i += 8) {                                             \
+      const __m512i lhs = _mm512_load_si512((const void *)(blocks + i));              \
+      const __m512i rhs = _mm512_load_si512((const void *)(other + i));               \
+                                                                                      \
+      _mm512_store_si512((void *)(blocks + i), op(lhs, rhs));                         \
+    }                                                                                 \
+  }
+
+TINYGRAPH_BITSET_AVX512_OP(tinygraph_bitset_and_avx512, _mm512_and_si512)
+TINYGRAPH_BITSET_AVX512_OP(tinygraph_bitset_or_avx512, _mm512_or_si512)
+TINYGRAPH_BITSET_AVX512_OP(tinygraph_bitset_xor_avx512, _mm512_xor_si512)
+
+#undef TINYGRAPH_BITSET_AVX512_OP
+
+#endif
+
+
 void tinygraph_bitset_and(tinygraph_bitset * const bitset, const tinygraph_bitset * const other) {
   TINYGRAPH_ASSERT(bitset);
   TINYGRAPH_ASSERT(bitset->blocks_len == other->blocks_len);
 
+#if defined(__x86_64__) || defined(__i386__)
+  if (tinygraph_cpu_has_avx512()) {
+    tinygraph_bitset_and_avx512(bitset->blocks, other->blocks, bitset->blocks_len);
+    return;
+  }
+#endif
+
   for (uint64_t i = 0; i < bitset->blocks_len; ++i) {
     bitset->blocks[i] = bitset->blocks[i] & other->blocks[i];
   }
@@ -147,6 +268,13 @@ void tinygraph_bitset_or(tinygraph_bitset * const bitset, const tinygraph_bitset
   TINYGRAPH_ASSERT(bitset);
   TINYGRAPH_ASSERT(bitset->blocks_len == other->blocks_len);
 
+#if defined(__x86_64__) || defined(__i386__)
+  if (tinygraph_cpu_has_avx512()) {
+    tinygraph_bitset_or_avx512(bitset->blocks, other->blocks, bitset->blocks_len);
+    return;
+  }
+#endif
+
   for (uint64_t i = 0; i < bitset->blocks_len; ++i) {
     bitset->blocks[i] = bitset->blocks[i] | other->blocks[i];
   }
@@ -157,6 +285,13 @@ void tinygraph_bitset_xor(tinygraph_bitset * const bitset, const tinygraph_bitse
   TINYGRAPH_ASSERT(bitset);
   TINYGRAPH_ASSERT(bitset->blocks_len == other->blocks_len);
 
+#if defined(__x86_64__) || defined(__i386__)
+  if (tinygraph_cpu_has_avx512()) {
+    tinygraph_bitset_xor_avx512(bitset->blocks, other->blocks, bitset->blocks_len);
+    return;
+  }
+#endif
+
   for (uint64_t i = 0; i < bitset->blocks_len; ++i) {
     bitset->blocks[i] = bitset->blocks[i] ^ other->blocks[i];
   }
@@ -28,12 +28,31 @@ void tinygraph_bitset_destruct(tinygraph_bitset_s bitset);
 
 void tinygraph_bitset_set_at(tinygraph_bitset_s bitset, uint64_t i);
 
+void tinygraph_bitset_clear_at(tinygraph_bitset_s bitset, uint64_t i);
+
 TINYGRAPH_WARN_UNUSED
 bool tinygraph_bitset_get_at(tinygraph_bitset_const_s bitset, uint64_t i);
 
 TINYGRAPH_WARN_UNUSED
 uint64_t tinygraph_bitset_get_size(tinygraph_bitset_const_s bitset);
 
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_bitset_get_size_in_bytes(tinygraph_bitset_const_s bitset);
+
+// Returns the bitset's blocks, cache-line aligned and zero
+// padded to a multiple of 512 bits, for rank and select
+TINYGRAPH_WARN_UNUSED
+const uint64_t* tinygraph_bitset_get_data(tinygraph_bitset_const_s bitset);
+
+// Returns the number of set bits in the bitset
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_bitset_count(tinygraph_bitset_const_s bitset);
+
+// Returns the position of the first set bit at or after i,
+// or the bitset's size if there is no set bit left
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_bitset_find_next(tinygraph_bitset_const_s bitset, uint64_t i);
+
 void tinygraph_bitset_clear(tinygraph_bitset_s bitset);
 
 void tinygraph_bitset_not(tinygraph_bitset_s bitset);
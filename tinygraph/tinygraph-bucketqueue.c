@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tinygraph-utils.h"
+#include "tinygraph-bits.h"
+#include "tinygraph-bucketqueue.h"
+
+/*
+ * Bucket queue for priorities in a sliding
+ * window of size C + 1 after the priority
+ * popped last, with C the largest edge weight
+ * in Dijkstra's algorithm: we keep a power of
+ * two number of buckets > C in a ring buffer
+ * and find the item with the smallest priority
+ * in the first non-empty bucket after the last
+ * popped one, wrapping around at the end.
+ *
+ * The buckets are singly linked lists of items
+ * in a shared pool, recycling popped items via
+ * a free list, and a bit per bucket tells us if
+ * it is non-empty so that we can skip over 64
+ * empty buckets at a time.
+ *
+ * Items in the same bucket have the same
+ * priority; we never have to look at them.
+ *
+ * See
+ *
+ * - Algorithm 360: Shortest-Path Forest with
+ *   Topological Ordering, Dial, CACM 1969
+ */
+
+#define TINYGRAPH_BUCKET_QUEUE_NIL UINT32_MAX
+
+typedef struct tinygraph_bucket_queue {
+  uint32_t *heads;
+  uint64_t *bits;
+  uint32_t num_buckets;
+
+  uint32_t *values;
+  uint32_t *nexts;
+  uint32_t pool_len;
+  uint32_t pool_capacity;
+  uint32_t free;
+
+  uint32_t last;
+  uint32_t size;
+} tinygraph_bucket_queue;
+
+
+tinygraph_bucket_queue* tinygraph_bucket_queue_construct(uint32_t window) {
+  TINYGRAPH_ASSERT(window < UINT32_C(1) << 31);
+
+  tinygraph_bucket_queue *out = malloc(sizeof(tinygraph_bucket_queue));
+
+  if (!out) {
+    return NULL;
+  }
+
+  // At least 64 buckets for a full word of bits
+  uint32_t num_buckets = 64;
+
+  while (num_buckets <= window) {
+    num_buckets *= 2;
+  }
+
+  uint32_t *heads = malloc(num_buckets * sizeof(uint32_t));
+
+  if (!heads) {
+    free(out);
+
+    return NULL;
+  }
+
+  uint64_t *bits = calloc(num_buckets / 64, sizeof(uint64_t));
+
+  if (!bits) {
+    free(heads);
+    free(out);
+
+    return NULL;
+  }
+
+  for (uint32_t i = 0; i < num_buckets; ++i) {
+    heads[i] = TINYGRAPH_BUCKET_QUEUE_NIL;
+  }
+
+  *out = (tinygraph_bucket_queue) {
+    .heads = heads,
+    .bits = bits,
+    .num_buckets = num_buckets,
+    .values = NULL,
+    .nexts = NULL,
+    .pool_len = 0,
+    .pool_capacity = 0,
+    .free = TINYGRAPH_BUCKET_QUEUE_NIL,
+    .last = 0,
+    .size = 0,
+  };
+
+  return out;
+}
+
+
+void tinygraph_bucket_queue_destruct(tinygraph_bucket_queue * const queue) {
+  if (!queue) {
+    return;
+  }
+
+  free(queue->heads);
+  free(queue->bits);
+  free(queue->values);
+  free(queue->nexts);
+
+  free(queue);
+}
+
+
+uint32_t tinygraph_bucket_queue_get_size(const tinygraph_bucket_queue * const queue) {
+  TINYGRAPH_ASSERT(queue);
+
+  return queue->size;
+}
+
+
+bool tinygraph_bucket_queue_is_empty(const tinygraph_bucket_queue * const queue) {
+  TINYGRAPH_ASSERT(queue);
+
+  return queue->size == 0;
+}
+
+
+uint32_t tinygraph_bucket_queue_get_last_priority(const tinygraph_bucket_queue * const queue) {
+  TINYGRAPH_ASSERT(queue);
+
+  return queue->last;
+}
+
+
+void tinygraph_bucket_queue_clear(tinygraph_bucket_queue * const queue) {
+  TINYGRAPH_ASSERT(queue);
+
+  // Only touch the non-empty buckets; after a
+  // search most of them are empty already
+
+  const uint32_t num_words = queue->num_buckets / 64;
+
+  for (uint32_t i = 0; i < num_words; ++i) {
+    uint64_t word = queue->bits[i];
+
+    while (word) {
+      queue->heads[i * 64 + tinygraph_bits_trailing0_u64(word)] = TINYGRAPH_BUCKET_QUEUE_NIL;
+      word &= word - 1;
+    }
+
+    queue->bits[i] = 0;
+  }
+
+  queue->pool_len = 0;
+  queue->free = TINYGRAPH_BUCKET_QUEUE_NIL;
+  queue->last = 0;
+  queue->size = 0;
+}
+
+
+bool tinygraph_bucket_queue_push(tinygraph_bucket_queue * const queue, uint32_t value, uint32_t priority) {
+  TINYGRAPH_ASSERT(queue);
+
+  TINYGRAPH_ASSERT(priority >= queue->last);
+  TINYGRAPH_ASSERT(priority - queue->last < queue->num_buckets);
+
+  uint32_t item = queue->free;
+
+  if (item != TINYGRAPH_BUCKET_QUEUE_NIL) {
+    queue->free = queue->nexts[item];
+  } else {
+    if (queue->pool_len == queue->pool_capacity) {
+      const uint32_t capacity = queue->pool_capacity == 0 ? 64 : queue->pool_capacity * 2;
+
+      uint32_t *values = realloc(queue->values, capacity * sizeof(uint32_t));
+
+      if (!values) {
+        return false;
+      }
+
+      queue->values = values;
+
+      uint32_t *nexts = realloc(queue->nexts, capacity * sizeof(uint32_t));
+
+      if (!nexts) {
+        return false;
+      }
+
+      queue->nexts = nexts;
+      queue->pool_capacity = capacity;
+    }
+
+    item = queue->pool_len++;
+  }
+
+  const uint32_t bucket = priority & (queue->num_buckets - 1);
+
+  queue->values[item] = value;
+  queue->nexts[item] = queue->heads[bucket];
+  queue->heads[bucket] = item;
+
+  queue->bits[bucket / 64] |= UINT64_C(1) << (bucket % 64);
+
+  queue->size += 1;
+
+  return true;
+}
+
+
+uint32_t tinygraph_bucket_queue_pop(tinygraph_bucket_queue * const queue) {
+  TINYGRAPH_ASSERT(queue);
+  TINYGRAPH_ASSERT(queue->size > 0);
+
+  const uint32_t mask = queue->num_buckets - 1;
+  const uint32_t num_words = queue->num_buckets / 64;
+
+  const uint32_t start = queue->last & mask;
+
+  // First the bits at and after the last bucket in its
+  // word, then the following words, wrapping around at
+  // the end; at the very end the bits before the last
+  // bucket in its word for a window of all the buckets
+
+  uint32_t word = start / 64;
+  uint64_t bits = queue->bits[word] & (UINT64_MAX << (start % 64));
+
+  for (uint32_t i = 0; !bits && i < num_words; ++i) {
+    word = (word + 1) & (num_words - 1);
+    bits = queue->bits[word];
+  }
+
+  TINYGRAPH_ASSERT(bits);
+
+  const uint32_t bucket = word * 64 + tinygraph_bits_trailing0_u64(bits);
+
+  queue->last += (bucket - start) & mask;
+
+  const uint32_t item = queue->heads[bucket];
+
+  TINYGRAPH_ASSERT(item != TINYGRAPH_BUCKET_QUEUE_NIL);
+
+  queue->heads[bucket] = queue->nexts[item];
+
+  if (queue->heads[bucket] == TINYGRAPH_BUCKET_QUEUE_NIL) {
+    queue->bits[bucket / 64] &= ~(UINT64_C(1) << (bucket % 64));
+  }
+
+  queue->nexts[item] = queue->free;
+  queue->free = item;
+
+  queue->size -= 1;
+
+  return queue->values[item];
+}
+
+
+void tinygraph_bucket_queue_print_internal(const tinygraph_bucket_queue * const queue) {
+  TINYGRAPH_ASSERT(queue);
+
+  fprintf(stderr, "bucket queue internals\n");
+
+  fprintf(stderr, "size: %ju, last: %ju, buckets: %ju\n",
+      (uintmax_t)queue->size, (uintmax_t)queue->last, (uintmax_t)queue->num_buckets);
+
+  for (uint32_t i = 0; i < queue->num_buckets; ++i) {
+    if (queue->heads[i] == TINYGRAPH_BUCKET_QUEUE_NIL) {
+      continue;
+    }
+
+    fprintf(stderr, "bucket %ju:", (uintmax_t)i);
+
+    for (uint32_t it = queue->heads[i]; it != TINYGRAPH_BUCKET_QUEUE_NIL; it = queue->nexts[it]) {
+      fprintf(stderr, " %ju", (uintmax_t)queue->values[it]);
+    }
+
+    fprintf(stderr, "\n");
+  }
+}
@@ -0,0 +1,53 @@
+#ifndef TINYGRAPH_BUCKETQUEUE_H
+#define TINYGRAPH_BUCKETQUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tinygraph-utils.h"
+
+/*
+ * Monotone min-queue for integer priorities
+ * in a sliding window (Dial's algorithm): the
+ * priorities pushed must lie in [last, last +
+ * window] for the priority popped last, as it
+ * is the case in Dijkstra's algorithm with the
+ * window being the largest edge weight. After
+ * construction and clear() it starts at zero.
+ *
+ * Push is in O(1), pop in O(window / 64).
+ */
+
+typedef struct tinygraph_bucket_queue* tinygraph_bucket_queue_s;
+typedef const struct tinygraph_bucket_queue* tinygraph_bucket_queue_const_s;
+
+
+TINYGRAPH_WARN_UNUSED
+tinygraph_bucket_queue_s tinygraph_bucket_queue_construct(uint32_t window);
+
+void tinygraph_bucket_queue_destruct(tinygraph_bucket_queue_s queue);
+
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_bucket_queue_get_size(tinygraph_bucket_queue_const_s queue);
+
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_bucket_queue_is_empty(tinygraph_bucket_queue_const_s queue);
+
+// Returns the priority popped last, zero after
+// construction and clear(); pushes must be in
+// the window after it
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_bucket_queue_get_last_priority(tinygraph_bucket_queue_const_s queue);
+
+void tinygraph_bucket_queue_clear(tinygraph_bucket_queue_s queue);
+
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_bucket_queue_push(tinygraph_bucket_queue_s queue, uint32_t value, uint32_t priority);
+
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_bucket_queue_pop(tinygraph_bucket_queue_s queue);
+
+void tinygraph_bucket_queue_print_internal(tinygraph_bucket_queue_const_s queue);
+
+
+#endif
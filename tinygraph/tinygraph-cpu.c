@@ -0,0 +1,105 @@
+#include <stdint.h>
+
+#include "tinygraph-cpu.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+/*
+ * We use cpuid directly instead of the compiler's
+ * __builtin_cpu_supports because we need the vendor
+ * and family on top of the feature bits: the AMD
+ * families 0x17 (Zen, Zen 2) and 0x18 (Hygon Dhyana)
+ * report BMI2 but run PDEP and PEXT in microcode
+ * with a latency of up to hundreds of cycles.
+ *
+ * For AVX-512 we need the operating system to save
+ * the opmask and upper zmm register state on top of
+ * the feature bits, which we check via xgetbv.
+ *
+ * The detection runs as a constructor when the
+ * library is loaded, before any of our functions
+ * can get called, so that lookups on the hot paths
+ * are a plain load of a flag which never changes.
+ */
+
+static bool tinygraph_cpu_bmi2 = false;
+static bool tinygraph_cpu_fast_pdep = false;
+static bool tinygraph_cpu_avx512 = false;
+static bool tinygraph_cpu_avx512_popcnt = false;
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((constructor))
+static void tinygraph_cpu_init(void) {
+  uint32_t eax, ebx, ecx, edx;
+
+  if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx)) {
+    return;
+  }
+
+  const uint32_t max_leaf = eax;
+
+  // The vendor string is spread over ebx, edx, ecx
+  const bool amd = (ebx == UINT32_C(0x68747541) && edx == UINT32_C(0x69746e65) && ecx == UINT32_C(0x444d4163)) // AuthenticAMD
+    || (ebx == UINT32_C(0x6f677948) && edx == UINT32_C(0x6e65476e) && ecx == UINT32_C(0x656e6975)); // HygonGenuine
+
+  if (max_leaf < 7) {
+    return;
+  }
+
+  __cpuid(1, eax, ebx, ecx, edx);
+
+  const uint32_t signature = eax;
+  const bool osxsave = (ecx & bit_OSXSAVE) != 0;
+
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+  tinygraph_cpu_bmi2 = (ebx & bit_BMI2) != 0;
+
+  const uint32_t avx512 = bit_AVX512F | bit_AVX512DQ | bit_AVX512CD | bit_AVX512BW | bit_AVX512VL;
+
+  if (osxsave && (ebx & avx512) == avx512) {
+    uint32_t xcr0, xcr0_hi;
+
+    __asm__ ("xgetbv" : "=a"(xcr0), "=d"(xcr0_hi) : "c"(0));
+
+    // The sse, avx, opmask, zmm 0-15 upper, and zmm 16-31 states
+    tinygraph_cpu_avx512 = (xcr0 & UINT32_C(0xe6)) == UINT32_C(0xe6);
+    tinygraph_cpu_avx512_popcnt = tinygraph_cpu_avx512 && (ecx & bit_AVX512VPOPCNTDQ) != 0;
+  }
+
+  if (!tinygraph_cpu_bmi2) {
+    return;
+  }
+
+  // The extended family adds onto the base family only if the latter is 0xf
+  uint32_t family = (signature >> 8) & 0xf;
+
+  if (family == 0xf) {
+    family += (signature >> 20) & 0xff;
+  }
+
+  tinygraph_cpu_fast_pdep = !(amd && family < 0x19);
+}
+
+#endif
+
+
+bool tinygraph_cpu_has_bmi2(void) {
+  return tinygraph_cpu_bmi2;
+}
+
+bool tinygraph_cpu_has_fast_pdep(void) {
+  return tinygraph_cpu_fast_pdep;
+}
+
+bool tinygraph_cpu_has_avx512(void) {
+  return tinygraph_cpu_avx512;
+}
+
+bool tinygraph_cpu_has_avx512_popcnt(void) {
+  return tinygraph_cpu_avx512_popcnt;
+}
@@ -0,0 +1,46 @@
+#ifndef TINYGRAPH_CPU_H
+#define TINYGRAPH_CPU_H
+
+#include <stdbool.h>
+
+#include "tinygraph-utils.h"
+
+/*
+ * Runtime CPU feature detection. We run the
+ * detection once at load time so that a single
+ * library build can pick the fastest of our
+ * implementations for the host it is running on.
+ */
+
+
+// The host supports the BMI2 instruction set
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_cpu_has_bmi2(void);
+
+// The host supports BMI2 and implements the PDEP
+// and PEXT instructions in hardware; AMD before
+// Zen 3 implements them in slow microcode
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_cpu_has_fast_pdep(void);
+
+// The host supports the x86-64-v4 AVX-512 subsets
+// and the operating system saves the zmm registers
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_cpu_has_avx512(void);
+
+// The host supports x86-64-v4 and the AVX-512
+// VPOPCNTDQ extension for vectorized popcounts
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_cpu_has_avx512_popcnt(void);
+
+
+// Function attributes for kernels we compile for
+// x86-64-v4 no matter the baseline we build for;
+// callers have to check the host's support first
+#if defined(__x86_64__) || defined(__i386__)
+#define TINYGRAPH_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512cd,avx512dq,avx512vl")))
+#define TINYGRAPH_TARGET_AVX512_POPCNT __attribute__((target("avx512f,avx512bw,avx512cd,avx512dq,avx512vl,avx512vpopcntdq")))
+#endif
+
+
+#endif
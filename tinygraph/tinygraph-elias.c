@@ -0,0 +1,320 @@
+#include <stdbool.h>
+
+#include "tinygraph-bits.h"
+#include "tinygraph-elias.h"
+
+/*
+ * Gamma coding
+ *
+ * Write floor(log2(x)) zeros, followed by bin(x), e.g.
+ * gamma(13) = 000 1101. Decoding works by counting n
+ * leading zeros, if n==0 return 1. Otherwise we read
+ * n + 1 bits which is the decoded binary value.
+ *
+ * Delta coding
+ *
+ * Write floor(log2(x)) + 1 as gamma code, followed by
+ * by bin(x), but skip the first 1 in bin(x) because it
+ * is always 1 (by design), e.g. delta(13) = 00100 101.
+ * Decoding works by decoding the gamma coded length,
+ * then reading length bits, pre-pending a one.
+ *
+ * We store the bits least significant bit first: the
+ * zeros are trailing zeros in the word, followed by a
+ * one and the value's remaining bits, least significant
+ * bit first. The code lengths are the same as above but
+ * decoding needs a trailing zero count and shifts only.
+ *
+ * Decoding peeks at 64 bits at a time and decodes codes
+ * from these bits for as long as they are complete. For
+ * short codes of at most 8 bits, that is values up to
+ * 15, a table lookup on the lowest byte gives us both
+ * the value and the code's length.
+ *
+ * See
+ * - https://www.lx.it.pt/~mtf/Elias.pdf
+ */
+
+
+// Per byte the (length << 4 | value) of the gamma
+// code in its lowest bits, or zero if not complete
+static const uint8_t tinygraph_elias_gamma_table[256] = {
+  0x00, 0x11, 0x32, 0x11, 0x54, 0x11, 0x33, 0x11, 0x78, 0x11, 0x32, 0x11, 0x55, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x56, 0x11, 0x33, 0x11, 0x79, 0x11, 0x32, 0x11, 0x57, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x54, 0x11, 0x33, 0x11, 0x7a, 0x11, 0x32, 0x11, 0x55, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x56, 0x11, 0x33, 0x11, 0x7b, 0x11, 0x32, 0x11, 0x57, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x54, 0x11, 0x33, 0x11, 0x7c, 0x11, 0x32, 0x11, 0x55, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x56, 0x11, 0x33, 0x11, 0x7d, 0x11, 0x32, 0x11, 0x57, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x54, 0x11, 0x33, 0x11, 0x7e, 0x11, 0x32, 0x11, 0x55, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x56, 0x11, 0x33, 0x11, 0x7f, 0x11, 0x32, 0x11, 0x57, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x54, 0x11, 0x33, 0x11, 0x78, 0x11, 0x32, 0x11, 0x55, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x56, 0x11, 0x33, 0x11, 0x79, 0x11, 0x32, 0x11, 0x57, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x54, 0x11, 0x33, 0x11, 0x7a, 0x11, 0x32, 0x11, 0x55, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x56, 0x11, 0x33, 0x11, 0x7b, 0x11, 0x32, 0x11, 0x57, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x54, 0x11, 0x33, 0x11, 0x7c, 0x11, 0x32, 0x11, 0x55, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x56, 0x11, 0x33, 0x11, 0x7d, 0x11, 0x32, 0x11, 0x57, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x54, 0x11, 0x33, 0x11, 0x7e, 0x11, 0x32, 0x11, 0x55, 0x11, 0x33, 0x11,
+  0x00, 0x11, 0x32, 0x11, 0x56, 0x11, 0x33, 0x11, 0x7f, 0x11, 0x32, 0x11, 0x57, 0x11, 0x33, 0x11,
+};
+
+// Per byte the (length << 4 | value) of the delta
+// code in its lowest bits, or zero if not complete
+static const uint8_t tinygraph_elias_delta_table[256] = {
+  0x00, 0x11, 0x42, 0x11, 0x88, 0x11, 0x54, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x55, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x00, 0x11, 0x56, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x57, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x89, 0x11, 0x54, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x55, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x00, 0x11, 0x56, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x57, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x8a, 0x11, 0x54, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x55, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x00, 0x11, 0x56, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x57, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x8b, 0x11, 0x54, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x55, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x00, 0x11, 0x56, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x57, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x8c, 0x11, 0x54, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x55, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x00, 0x11, 0x56, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x57, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x8d, 0x11, 0x54, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x55, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x00, 0x11, 0x56, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x57, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x8e, 0x11, 0x54, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x55, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x00, 0x11, 0x56, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x57, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x8f, 0x11, 0x54, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x55, 0x11,
+  0x00, 0x11, 0x42, 0x11, 0x00, 0x11, 0x56, 0x11, 0x00, 0x11, 0x43, 0x11, 0x00, 0x11, 0x57, 0x11,
+};
+
+
+TINYGRAPH_WARN_UNUSED
+static inline uint32_t tinygraph_elias_floorlog2_u32(uint32_t value) {
+  TINYGRAPH_ASSERT(value > 0);
+
+  return 31 - tinygraph_bits_leading0_u32(value);
+}
+
+TINYGRAPH_WARN_UNUSED
+static inline uint64_t tinygraph_elias_mask(uint32_t n) {
+  TINYGRAPH_ASSERT(n < 64);
+
+  return (UINT64_C(1) << n) - 1;
+}
+
+
+// Returns the gamma code for value and its length in bits
+TINYGRAPH_WARN_UNUSED
+static inline uint64_t tinygraph_elias_gamma_code(uint32_t value, uint32_t *len) {
+  const uint32_t n = tinygraph_elias_floorlog2_u32(value);
+
+  *len = 2 * n + 1;
+
+  return (UINT64_C(1) << n) | ((value & tinygraph_elias_mask(n)) << (n + 1));
+}
+
+// Returns the delta code for value and its length in bits
+TINYGRAPH_WARN_UNUSED
+static inline uint64_t tinygraph_elias_delta_code(uint32_t value, uint32_t *len) {
+  const uint32_t n = tinygraph_elias_floorlog2_u32(value);
+
+  uint32_t head;
+
+  const uint64_t code = tinygraph_elias_gamma_code(n + 1, &head);
+
+  *len = head + n;
+
+  return code | ((value & tinygraph_elias_mask(n)) << head);
+}
+
+
+uint64_t tinygraph_elias_num_words(uint64_t num_bits) {
+  return (num_bits + 63) / 64 + 1;
+}
+
+
+uint64_t tinygraph_elias_gamma_num_bits(const uint32_t * restrict data, uint32_t n) {
+  TINYGRAPH_ASSERT(data || n == 0);
+
+  uint64_t num_bits = 0;
+
+  for (uint32_t i = 0; i < n; ++i) {
+    num_bits += 2 * tinygraph_elias_floorlog2_u32(data[i]) + 1;
+  }
+
+  return num_bits;
+}
+
+
+uint64_t tinygraph_elias_delta_num_bits(const uint32_t * restrict data, uint32_t n) {
+  TINYGRAPH_ASSERT(data || n == 0);
+
+  uint64_t num_bits = 0;
+
+  for (uint32_t i = 0; i < n; ++i) {
+    const uint32_t k = tinygraph_elias_floorlog2_u32(data[i]);
+
+    num_bits += 2 * tinygraph_elias_floorlog2_u32(k + 1) + 1 + k;
+  }
+
+  return num_bits;
+}
+
+
+TINYGRAPH_WARN_UNUSED
+static inline uint64_t tinygraph_elias_encode(
+    const uint32_t * restrict data,
+    uint64_t * restrict out,
+    uint32_t n,
+    bool delta)
+{
+  TINYGRAPH_ASSERT(data || n == 0);
+  TINYGRAPH_ASSERT(out);
+
+  // We collect codes in a word and write it out once
+  // full; codes are at most 63 bits long, so they
+  // can straddle at most two consecutive words
+
+  uint64_t *it = out;
+  uint64_t word = 0;
+  uint32_t fill = 0;
+  uint64_t num_bits = 0;
+
+  for (uint32_t i = 0; i < n; ++i) {
+    TINYGRAPH_ASSERT(data[i] > 0);
+
+    uint32_t len;
+
+    const uint64_t code = delta
+      ? tinygraph_elias_delta_code(data[i], &len)
+      : tinygraph_elias_gamma_code(data[i], &len);
+
+    TINYGRAPH_ASSERT(len < 64);
+
+    word |= code << fill;
+
+    if (fill + len >= 64) {
+      *it++ = word;
+
+      word = fill > 0 ? code >> (64 - fill) : 0;
+    }
+
+    fill = (fill + len) % 64;
+    num_bits += len;
+  }
+
+  // The last partial word plus the padding word
+
+  if (fill > 0) {
+    *it++ = word;
+  }
+
+  *it++ = 0;
+
+  TINYGRAPH_ASSERT((uint64_t)(it - out) == tinygraph_elias_num_words(num_bits));
+
+  return num_bits;
+}
+
+
+TINYGRAPH_WARN_UNUSED
+static inline uint64_t tinygraph_elias_peek(const uint64_t * restrict data, uint64_t pos) {
+  const uint64_t w = pos / 64;
+  const uint32_t o = pos % 64;
+
+  if (o == 0) {
+    return data[w];
+  }
+
+  return (data[w] >> o) | (data[w + 1] << (64 - o));
+}
+
+
+TINYGRAPH_WARN_UNUSED
+static inline uint64_t tinygraph_elias_decode(
+    const uint64_t * restrict data,
+    uint32_t * restrict out,
+    uint32_t n,
+    bool delta)
+{
+  TINYGRAPH_ASSERT(data || n == 0);
+  TINYGRAPH_ASSERT(out || n == 0);
+
+  const uint8_t * const table = delta
+    ? tinygraph_elias_delta_table
+    : tinygraph_elias_gamma_table;
+
+  uint64_t pos = 0;
+  uint32_t i = 0;
+
+  while (i < n) {
+    uint64_t window = tinygraph_elias_peek(data, pos);
+    uint32_t used = 0;
+
+    // The window's top used bits are shifted in zeros;
+    // decode from it for as long as codes are complete
+
+    while (i < n) {
+      if (used <= 56) {
+        const uint8_t entry = table[window & 0xff];
+
+        if (TINYGRAPH_LIKELY(entry != 0)) {
+          const uint32_t len = entry >> 4;
+
+          out[i++] = entry & 15;
+          window >>= len;
+          used += len;
+
+          continue;
+        }
+      }
+
+      const uint32_t z = tinygraph_bits_trailing0_u64(window);
+      const uint32_t head = 2 * z + 1;
+
+      if (used + head > 64) {
+        break;
+      }
+
+      const uint32_t value = (UINT64_C(1) << z) | ((window >> (z + 1)) & tinygraph_elias_mask(z));
+
+      if (!delta) {
+        out[i++] = value;
+        window >>= head;
+        used += head;
+
+        continue;
+      }
+
+      const uint32_t k = value - 1;
+
+      if (used + head + k > 64) {
+        break;
+      }
+
+      TINYGRAPH_ASSERT(k < 32);
+
+      out[i++] = (UINT64_C(1) << k) | ((window >> head) & tinygraph_elias_mask(k));
+      window = (window >> head) >> k;
+      used += head + k;
+    }
+
+    // A full window always holds at least one code
+    TINYGRAPH_ASSERT(used > 0 || i == n);
+
+    pos += used;
+  }
+
+  return pos;
+}
+
+
+uint64_t tinygraph_elias_gamma_encode(const uint32_t * restrict data, uint64_t * restrict out, uint32_t n) {
+  return tinygraph_elias_encode(data, out, n, false);
+}
+
+
+uint64_t tinygraph_elias_gamma_decode(const uint64_t * restrict data, uint32_t * restrict out, uint32_t n) {
+  return tinygraph_elias_decode(data, out, n, false);
+}
+
+
+uint64_t tinygraph_elias_delta_encode(const uint32_t * restrict data, uint64_t * restrict out, uint32_t n) {
+  return tinygraph_elias_encode(data, out, n, true);
+}
+
+
+uint64_t tinygraph_elias_delta_decode(const uint64_t * restrict data, uint32_t * restrict out, uint32_t n) {
+  return tinygraph_elias_decode(data, out, n, true);
+}
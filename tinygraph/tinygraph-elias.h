@@ -0,0 +1,48 @@
+#ifndef TINYGRAPH_ELIAS_H
+#define TINYGRAPH_ELIAS_H
+
+#include <stdint.h>
+
+#include "tinygraph-utils.h"
+
+/*
+ * Elias gamma and delta coding to store positive
+ * 32 bit integers in a variable number of bits,
+ * depending on their value. Use in combination
+ * with delta coding and add one to gaps that can
+ * be zero: the codes can not represent zero.
+ *
+ * Codes are written back to back into 64 bit words
+ * starting at the least significant bit. The output
+ * must have space for tinygraph_elias_num_words of
+ * the number of bits, which includes one padding
+ * word, so that decoding can read ahead.
+ *
+ * The functions encode or decode n integers and
+ * return the number of bits used.
+ */
+
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_elias_num_words(uint64_t num_bits);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_elias_gamma_num_bits(const uint32_t * restrict data, uint32_t n);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_elias_gamma_encode(const uint32_t * restrict data, uint64_t * restrict out, uint32_t n);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_elias_gamma_decode(const uint64_t * restrict data, uint32_t * restrict out, uint32_t n);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_elias_delta_num_bits(const uint32_t * restrict data, uint32_t n);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_elias_delta_encode(const uint32_t * restrict data, uint64_t * restrict out, uint32_t n);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_elias_delta_decode(const uint64_t * restrict data, uint32_t * restrict out, uint32_t n);
+
+
+#endif
@@ -1,91 +1,307 @@
-#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 #include "tinygraph-bits.h"
+#include "tinygraph-bitset.h"
+#include "tinygraph-rankselect.h"
 #include "tinygraph-eliasfano.h"
 
 
 /*
- * Gamma coding
+ * Elias-Fano coding
  *
- * Write floor(log2(x)) zeros, followed by bin(x), e.g.
- * gamma(13) = 000 1101. Decoding works by counting n
- * leading zeros, if n==0 return 1. Otherwise we read
- * n + 1 bits which is the decoded binary value.
+ * For n sorted integers below u we split each integer
+ * into its l = floor(log2(u / n)) low bits and the
+ * remaining high bits. The low bits are stored packed
+ * as is in n * l bits. The high bits are stored in
+ * unary as the gaps between consecutive high parts:
+ * for the i-th integer x we set bit (x >> l) + i.
+ * These are n set bits and at most (u >> l) + 1 unset
+ * bits, that is at most 2n + 1 bits.
  *
- * Delta coding
- *
- * Write floor(log2(x)) + 1 as gamma code, followed by
- * by bin(x), but skip the first 1 in bin(x) because it
- * is always 1 (by design), e.g. delta(13) = 00100 101.
- * Decoding works by decoding the gamma coded length,
- * then reading length bits, pre-pending a one.
+ * Random access to the i-th integer is a select(i)
+ * on the high bits. To find the first integer >= x
+ * we jump to the bucket of integers with the same
+ * high part as x, with a select0 on the high bits,
+ * and scan the few integers in this bucket.
  *
  * See
- * - https://www.lx.it.pt/~mtf/Elias.pdf
+ * - https://vigna.di.unimi.it/ftp/papers/QuasiSuccinctIndices.pdf
+ * - https://www.antoniomallia.it/sorted-integers-compression-with-elias-fano-encoding.html
  */
 
+typedef struct tinygraph_eliasfano {
+  tinygraph_bitset_s high;
+  tinygraph_rankselect_s high_rs;
+  uint64_t *low;
+  uint64_t low_len;
+  uint32_t size;
+  uint32_t low_bits;
+} tinygraph_eliasfano;
 
-TINYGRAPH_WARN_UNUSED
-static uint32_t tinygraph_eliasfano_floorlog2_u32(uint32_t value) {
-  return 31 - tinygraph_bits_leading0_u32(value);
-}
 
 TINYGRAPH_WARN_UNUSED
-static uint32_t tinygraph_eliasfano_gamma_num_bits(uint32_t value) {
-  return 2 * tinygraph_eliasfano_floorlog2_u32(value) + 1;
-}
+static inline uint32_t tinygraph_eliasfano_get_low(
+    const tinygraph_eliasfano * const ef,
+    uint32_t i)
+{
+  if (ef->low_bits == 0) {
+    return 0;
+  }
 
-TINYGRAPH_WARN_UNUSED
-static uint32_t tinygraph_eliasfano_delta_num_bits(uint32_t value) {
-  const uint32_t n = tinygraph_eliasfano_floorlog2_u32(value);
-  return tinygraph_eliasfano_gamma_num_bits(n + 1) + (n + 1) - 1;
+  const uint64_t bit = (uint64_t)i * ef->low_bits;
+  const uint64_t word = bit / 64;
+  const uint32_t offset = bit % 64;
+
+  uint64_t value = ef->low[word] >> offset;
+
+  if (offset + ef->low_bits > 64) {
+    value |= ef->low[word + 1] << (64 - offset);
+  }
+
+  return value & ((UINT64_C(1) << ef->low_bits) - 1);
 }
 
 
-tinygraph_bitset_s tinygraph_eliasfano_encode(const uint32_t * restrict data, uint32_t n) {
-  uint64_t nbits = 0;
+tinygraph_eliasfano* tinygraph_eliasfano_construct(const uint32_t * restrict data, uint32_t n) {
+  TINYGRAPH_ASSERT(data || n == 0);
 
-  for (uint32_t i = 0; i < n; ++i) {
-    nbits += tinygraph_eliasfano_delta_num_bits(data[i]);
+  tinygraph_eliasfano *out = malloc(sizeof(tinygraph_eliasfano));
+
+  if (!out) {
+    return NULL;
   }
 
-  tinygraph_bitset_s out = tinygraph_bitset_construct(nbits);
+  const uint64_t universe = n > 0 ? (uint64_t)data[n - 1] + 1 : 0;
 
-  uint64_t it = 0;
+  // At most 31 low bits, so that there is always
+  // at least one high bit, even for a single item
+  const uint32_t log = universe > n ? 63 - tinygraph_bits_leading0_u64(universe / n) : 0;
+  const uint32_t low_bits = log < 31 ? log : 31;
+
+  // One more word so that reading low bits never
+  // has to check for the very last word's bounds
+  const uint64_t low_len = ((uint64_t)n * low_bits + 63) / 64 + 1;
+  const uint64_t high_size = (uint64_t)n + (n > 0 ? (data[n - 1] >> low_bits) : 0) + 1;
+
+  uint64_t *low = calloc(low_len, sizeof(uint64_t));
+  tinygraph_bitset_s high = tinygraph_bitset_construct(high_size);
+
+  if (!low || !high) {
+    free(low);
+    tinygraph_bitset_destruct(high);
+    free(out);
+
+    return NULL;
+  }
 
   for (uint32_t i = 0; i < n; ++i) {
-    const uint32_t value = data[i];
+    TINYGRAPH_ASSERT(i == 0 || data[i - 1] <= data[i]);
 
-    TINYGRAPH_ASSERT(value > 0);
+    const uint32_t value = data[i];
 
-    const uint32_t len = tinygraph_eliasfano_floorlog2_u32(value) + 1;
+    tinygraph_bitset_set_at(high, (uint64_t)(value >> low_bits) + i);
 
-    // Write number of digits in the binary value (len) as gamma code
+    if (low_bits > 0) {
+      const uint64_t bits = value & ((UINT64_C(1) << low_bits) - 1);
 
-    const uint32_t lenlen = tinygraph_eliasfano_floorlog2_u32(len);
+      const uint64_t bit = (uint64_t)i * low_bits;
+      const uint64_t word = bit / 64;
+      const uint32_t offset = bit % 64;
 
-    it += lenlen;
+      low[word] |= bits << offset;
 
-    for (uint32_t j = 0; j < (lenlen + 1); ++j) {
-      if ((len & (UINT32_C(1) << (lenlen + 1 - j - 1))) != 0) {
-        tinygraph_bitset_set_at(out, it);
+      if (offset + low_bits > 64) {
+        low[word + 1] |= bits >> (64 - offset);
       }
+    }
+  }
+
+  tinygraph_rankselect_s high_rs = tinygraph_rankselect_construct(high);
+
+  if (!high_rs) {
+    free(low);
+    tinygraph_bitset_destruct(high);
+    free(out);
+
+    return NULL;
+  }
+
+  *out = (tinygraph_eliasfano){
+    .high = high,
+    .high_rs = high_rs,
+    .low = low,
+    .low_len = low_len,
+    .size = n,
+    .low_bits = low_bits,
+  };
+
+  return out;
+}
+
+
+void tinygraph_eliasfano_destruct(tinygraph_eliasfano * const ef) {
+  if (!ef) {
+    return;
+  }
+
+  tinygraph_rankselect_destruct(ef->high_rs);
+  tinygraph_bitset_destruct(ef->high);
+  free(ef->low);
+
+  ef->high = NULL;
+  ef->high_rs = NULL;
+  ef->low = NULL;
+  ef->low_len = 0;
+  ef->size = 0;
+  ef->low_bits = 0;
+
+  free(ef);
+}
+
+
+uint32_t tinygraph_eliasfano_get_size(const tinygraph_eliasfano * const ef) {
+  TINYGRAPH_ASSERT(ef);
+
+  return ef->size;
+}
+
+
+uint64_t tinygraph_eliasfano_get_size_in_bytes(const tinygraph_eliasfano * const ef) {
+  TINYGRAPH_ASSERT(ef);
+
+  return sizeof(tinygraph_eliasfano)
+    + ef->low_len * sizeof(uint64_t)
+    + tinygraph_bitset_get_size_in_bytes(ef->high)
+    + tinygraph_rankselect_get_size_in_bytes(ef->high_rs);
+}
+
+
+uint32_t tinygraph_eliasfano_access(const tinygraph_eliasfano * const ef, uint32_t i) {
+  TINYGRAPH_ASSERT(ef);
+  TINYGRAPH_ASSERT(i < ef->size);
+
+  const uint64_t high = tinygraph_rankselect_select(ef->high_rs, i) - i;
 
-      it += 1;
+  return (high << ef->low_bits) | tinygraph_eliasfano_get_low(ef, i);
+}
+
+
+// Returns the index of the first integer >= value
+// or the size if there is none, and writes the
+// integer into out if there is one, zero otherwise
+TINYGRAPH_WARN_UNUSED
+static uint32_t tinygraph_eliasfano_lower_bound(
+    const tinygraph_eliasfano * const ef,
+    uint32_t value,
+    uint32_t *out)
+{
+  TINYGRAPH_ASSERT(ef);
+  TINYGRAPH_ASSERT(out);
+
+  const uint64_t high = value >> ef->low_bits;
+
+  // There are as many unset bits as there are
+  // buckets; beyond the last bucket is nothing
+  const uint64_t num_buckets = tinygraph_bitset_get_size(ef->high)
+    - tinygraph_rankselect_get_count(ef->high_rs);
+
+  *out = 0;
+
+  if (high >= num_buckets) {
+    return ef->size;
+  }
+
+  // The bucket for high starts after its
+  // preceding bucket's terminating unset bit
+
+  uint64_t pos = high == 0 ? 0 : tinygraph_rankselect_select0(ef->high_rs, high - 1) + 1;
+  uint32_t i = pos - high;
+
+  for (; tinygraph_bitset_get_at(ef->high, pos); ++pos, ++i) {
+    const uint32_t x = (high << ef->low_bits) | tinygraph_eliasfano_get_low(ef, i);
+
+    if (x >= value) {
+      *out = x;
+      return i;
     }
+  }
+
+  // All integers after the bucket are larger
+  if (i < ef->size) {
+    *out = tinygraph_eliasfano_access(ef, i);
+  }
 
-    // Write binary value itself, but discard first bit (always 1)
+  return i;
+}
+
+
+uint32_t tinygraph_eliasfano_rank(const tinygraph_eliasfano * const ef, uint32_t value) {
+  TINYGRAPH_ASSERT(ef);
+
+  uint32_t x;
+
+  return tinygraph_eliasfano_lower_bound(ef, value, &x);
+}
 
-    for (uint32_t k = 0; k < (len - 1); ++k) {
-      if ((value & (UINT32_C(1) << (len - 1 - k - 1))) != 0) {
-        tinygraph_bitset_set_at(out, it);
-      }
 
-      it += 1;
+bool tinygraph_eliasfano_next_geq(const tinygraph_eliasfano * const ef, uint32_t value, uint32_t *out) {
+  TINYGRAPH_ASSERT(ef);
+  TINYGRAPH_ASSERT(out);
+
+  return tinygraph_eliasfano_lower_bound(ef, value, out) < ef->size;
+}
+
+
+uint32_t tinygraph_eliasfano_decode_next(const tinygraph_eliasfano * const ef, uint32_t i, uint64_t *pos) {
+  TINYGRAPH_ASSERT(ef);
+  TINYGRAPH_ASSERT(pos);
+  TINYGRAPH_ASSERT(i < ef->size);
+
+  const uint64_t p = tinygraph_bitset_find_next(ef->high, *pos);
+
+  TINYGRAPH_ASSERT(p < tinygraph_bitset_get_size(ef->high));
+
+  *pos = p + 1;
+
+  return ((p - i) << ef->low_bits) | tinygraph_eliasfano_get_low(ef, i);
+}
+
+
+void tinygraph_eliasfano_decode(const tinygraph_eliasfano * const ef, uint32_t * restrict out) {
+  TINYGRAPH_ASSERT(ef);
+  TINYGRAPH_ASSERT(out || ef->size == 0);
+
+  // Walk over the high bits' words and extract
+  // the set bits' positions word at a time
+
+  const uint64_t *words = tinygraph_bitset_get_data(ef->high);
+
+  uint32_t i = 0;
+
+  for (uint64_t w = 0; i < ef->size; ++w) {
+    uint64_t word = words[w];
+
+    while (word != 0) {
+      const uint64_t p = w * 64 + tinygraph_bits_trailing0_u64(word);
+
+      out[i] = ((p - i) << ef->low_bits) | tinygraph_eliasfano_get_low(ef, i);
+
+      i += 1;
+      word &= word - 1;
     }
   }
+}
 
-  TINYGRAPH_ASSERT(it == nbits);
 
-  return out;
+void tinygraph_eliasfano_print_internal(const tinygraph_eliasfano * const ef) {
+  TINYGRAPH_ASSERT(ef);
+
+  fprintf(stderr, "eliasfano internals\n");
+
+  fprintf(stderr, "size: %ju, low bits: %ju\n",
+      (uintmax_t)ef->size, (uintmax_t)ef->low_bits);
+
+  tinygraph_bitset_print_internal(ef->high);
+  tinygraph_rankselect_print_internal(ef->high_rs);
 }
@@ -2,17 +2,61 @@
 #define TINYGRAPH_ELIASFANO_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
-#include "tinygraph-bitset.h"
 #include "tinygraph-utils.h"
 
 /*
  * Quasi succinct Elias-Fano coding.
+ *
+ * The Elias-Fano structure stores a sorted
+ * sequence of n integers below u in about
+ * 2 + log2(u / n) bits per integer and still
+ * allows for random access into the sequence
+ * and finding the first integer >= a value.
  */
 
+typedef struct tinygraph_eliasfano* tinygraph_eliasfano_s;
+typedef const struct tinygraph_eliasfano* tinygraph_eliasfano_const_s;
 
+
+// Constructs the Elias-Fano structure over the n
+// integers in data, which must be sorted ascending
+TINYGRAPH_WARN_UNUSED
+tinygraph_eliasfano_s tinygraph_eliasfano_construct(const uint32_t * restrict data, uint32_t n);
+
+void tinygraph_eliasfano_destruct(tinygraph_eliasfano_s ef);
+
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_eliasfano_get_size(tinygraph_eliasfano_const_s ef);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_eliasfano_get_size_in_bytes(tinygraph_eliasfano_const_s ef);
+
+// Returns the i-th integer in the sequence
 TINYGRAPH_WARN_UNUSED
-tinygraph_bitset_s tinygraph_eliasfano_encode(const uint32_t * restrict data, uint32_t n);
+uint32_t tinygraph_eliasfano_access(tinygraph_eliasfano_const_s ef, uint32_t i);
+
+// Returns the number of integers less than value
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_eliasfano_rank(tinygraph_eliasfano_const_s ef, uint32_t value);
+
+// Writes the first integer >= value into out and returns
+// true, or returns false if there is no such integer
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_eliasfano_next_geq(tinygraph_eliasfano_const_s ef, uint32_t value, uint32_t *out);
+
+// Returns the i-th integer for sequential decoding; pos
+// is a cursor into the high bits, start with i and pos
+// zero and pass i + 1 and the updated pos next time
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_eliasfano_decode_next(tinygraph_eliasfano_const_s ef, uint32_t i, uint64_t *pos);
+
+// Decodes all integers into out, which must have
+// space for tinygraph_eliasfano_get_size integers
+void tinygraph_eliasfano_decode(tinygraph_eliasfano_const_s ef, uint32_t * restrict out);
+
+void tinygraph_eliasfano_print_internal(tinygraph_eliasfano_const_s ef);
 
 
 #endif
@@ -302,6 +302,13 @@ bool tinygraph_heap_is_empty(const tinygraph_heap * const heap) {
   return heap->size == 0;
 }
 
+uint32_t tinygraph_heap_get_min_priority(const tinygraph_heap * const heap) {
+  TINYGRAPH_ASSERT(heap);
+  TINYGRAPH_ASSERT(heap->size > 0);
+
+  return heap->items[0].priority;
+}
+
 void tinygraph_heap_clear(tinygraph_heap * const heap) {
   TINYGRAPH_ASSERT(heap);
 
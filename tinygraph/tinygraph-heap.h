@@ -39,6 +39,10 @@ uint32_t tinygraph_heap_get_capacity(tinygraph_heap_const_s heap);
 TINYGRAPH_WARN_UNUSED
 bool tinygraph_heap_is_empty(tinygraph_heap_const_s heap);
 
+// The priority of the item pop() returns next
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_heap_get_min_priority(tinygraph_heap_const_s heap);
+
 void tinygraph_heap_clear(tinygraph_heap_s heap);
 
 TINYGRAPH_WARN_UNUSED
@@ -0,0 +1,155 @@
+#include "tinygraph-hilbert.h"
+#include "tinygraph-zorder.h"
+
+/*
+ * The Hilbert space filling curve for 2d. Unlike the
+ * z-order curve it never jumps: consecutive positions
+ * on the curve are neighboring cells in the grid.
+ *
+ * Walking the curve's quadrants from the most to the
+ * least significant bit, each quadrant's sub-curve is
+ * the parent curve transposed and or mirrored. That
+ * is a state machine over the bits, which we compute
+ * as branch-free prefix scans over all bits at once
+ * instead of bit by bit.
+ *
+ * The transformed bits then get interleaved into the
+ * curve position exactly like the z-order curve does,
+ * so that we use its PDEP or look up table fast paths
+ * depending on the host, see the tinygraph-zorder module.
+ *
+ * See
+ * - https://threadlocalmutex.com/?p=126
+ * - Hacker's Delight, 2nd edition, chapter 16
+ */
+
+
+// The transform from coordinates into the curve's two
+// bit planes; the prefix scan keeps track of the four
+// possible quadrant orientations in a, b with c, d the
+// orientation dependent mirroring of the lower bits
+#define TINYGRAPH_HILBERT_ROUND(s)                              \
+  do {                                                          \
+    const uint32_t a = A;                                       \
+    const uint32_t b = B;                                       \
+    const uint32_t c = C;                                       \
+    const uint32_t d = D;                                       \
+                                                                \
+    A = (a & (a >> (s))) ^ (b & (b >> (s)));                    \
+    B = (a & (b >> (s))) ^ (b & ((a ^ b) >> (s)));              \
+    C ^= (a & (c >> (s))) ^ (b & (d >> (s)));                   \
+    D ^= (b & (c >> (s))) ^ ((a ^ b) & (d >> (s)));             \
+  } while (0)
+
+static inline void tinygraph_hilbert_planes(
+    uint32_t x,
+    uint32_t y,
+    uint32_t mask,
+    uint32_t * restrict i0,
+    uint32_t * restrict i1)
+{
+  uint32_t A, B, C, D;
+
+  {
+    const uint32_t a = x ^ y;
+    const uint32_t b = mask ^ a;
+    const uint32_t c = mask ^ (x | y);
+    const uint32_t d = x & (y ^ mask);
+
+    A = a | (b >> 1);
+    B = (a >> 1) ^ a;
+    C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+    D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+  }
+
+  TINYGRAPH_HILBERT_ROUND(2);
+  TINYGRAPH_HILBERT_ROUND(4);
+
+  if (mask == UINT32_MAX) {
+    TINYGRAPH_HILBERT_ROUND(8);
+  }
+
+  // The last round only needs the mirroring
+  {
+    const uint32_t s = mask == UINT32_MAX ? 16 : 8;
+    const uint32_t a = A;
+    const uint32_t b = B;
+    const uint32_t c = C;
+    const uint32_t d = D;
+
+    C ^= (a & (c >> s)) ^ (b & (d >> s));
+    D ^= (b & (c >> s)) ^ ((a ^ b) & (d >> s));
+  }
+
+  const uint32_t a = C ^ (C >> 1);
+  const uint32_t b = D ^ (D >> 1);
+
+  *i0 = x ^ y;
+  *i1 = b | (mask ^ (*i0 | a));
+}
+
+#undef TINYGRAPH_HILBERT_ROUND
+
+
+// The inverse transform from the curve's two bit planes
+// back into coordinates; for decoding the orientations
+// are xor prefix scans over the bit planes
+static inline void tinygraph_hilbert_coords(
+    uint32_t i0,
+    uint32_t i1,
+    uint32_t mask,
+    uint32_t * restrict x,
+    uint32_t * restrict y)
+{
+  uint32_t t0 = (i0 | i1) ^ mask;
+  uint32_t t1 = i0 & i1;
+
+  for (uint32_t s = mask == UINT32_MAX ? 16 : 8; s > 0; s /= 2) {
+    t0 ^= t0 >> s;
+    t1 ^= t1 >> s;
+  }
+
+  const uint32_t a = ((i0 ^ mask) & t1) | (i0 & t0);
+
+  *x = a ^ i1;
+  *y = a ^ i0 ^ i1;
+}
+
+
+uint32_t tinygraph_hilbert_encode32(uint16_t x, uint16_t y) {
+  uint32_t i0, i1;
+  tinygraph_hilbert_planes(x, y, UINT16_MAX, &i0, &i1);
+
+  return tinygraph_zorder_encode32((uint16_t)i0, (uint16_t)i1);
+}
+
+uint64_t tinygraph_hilbert_encode64(uint32_t x, uint32_t y) {
+  uint32_t i0, i1;
+  tinygraph_hilbert_planes(x, y, UINT32_MAX, &i0, &i1);
+
+  return tinygraph_zorder_encode64(i0, i1);
+}
+
+void tinygraph_hilbert_decode32(uint32_t h, uint16_t * restrict x, uint16_t * restrict y) {
+  TINYGRAPH_ASSERT(x);
+  TINYGRAPH_ASSERT(y);
+
+  uint16_t i0, i1;
+  tinygraph_zorder_decode32(h, &i0, &i1);
+
+  uint32_t hx, hy;
+  tinygraph_hilbert_coords(i0, i1, UINT16_MAX, &hx, &hy);
+
+  *x = (uint16_t)hx;
+  *y = (uint16_t)hy;
+}
+
+void tinygraph_hilbert_decode64(uint64_t h, uint32_t * restrict x, uint32_t * restrict y) {
+  TINYGRAPH_ASSERT(x);
+  TINYGRAPH_ASSERT(y);
+
+  uint32_t i0, i1;
+  tinygraph_zorder_decode64(h, &i0, &i1);
+
+  tinygraph_hilbert_coords(i0, i1, UINT32_MAX, x, y);
+}
@@ -0,0 +1,25 @@
+#ifndef TINYGRAPH_HILBERT_H
+#define TINYGRAPH_HILBERT_H
+
+#include <stdint.h>
+
+#include "tinygraph-utils.h"
+
+/*
+ * Hilbert space filling curve.
+ */
+
+
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_hilbert_encode32(uint16_t x, uint16_t y);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_hilbert_encode64(uint32_t x, uint32_t y);
+
+
+void tinygraph_hilbert_decode32(uint32_t h, uint16_t * restrict x, uint16_t * restrict y);
+
+void tinygraph_hilbert_decode64(uint64_t h, uint32_t * restrict x, uint32_t * restrict y);
+
+
+#endif
@@ -4,34 +4,12 @@
 #include <string.h>
 #include <limits.h>
 
+#include "tinygraph.h"
 #include "tinygraph-utils.h"
 #include "tinygraph-impl.h"
-
-
-typedef struct tinygraph_edge {
-  uint32_t source;
-  uint32_t target;
-} tinygraph_edge;
-
-TINYGRAPH_WARN_UNUSED
-static inline int tinygraph_edge_cmp(const void* lhs, const void *rhs) {
-  const tinygraph_edge elhs = *(const tinygraph_edge *)lhs;
-  const tinygraph_edge erhs = *(const tinygraph_edge *)rhs;
-
-  if (elhs.source < erhs.source) {
-    return -1;
-  } else if (elhs.source > erhs.source) {
-    return 1;
-  } else {
-    if (elhs.target < erhs.target) {
-      return -1;
-    } else if (elhs.target > erhs.target) {
-      return 1;
-    } else {
-      return 0;
-    }
-  }
-}
+#include "tinygraph-zigzag.h"
+#include "tinygraph-sort.h"
+#include "tinygraph-bits.h"
 
 
 uint8_t tinygraph_saturated_add_u8(uint8_t a, uint8_t b) {
@@ -255,27 +233,42 @@ bool tinygraph_sort_sources_targets(
   TINYGRAPH_ASSERT(sources);
   TINYGRAPH_ASSERT(targets);
 
-  tinygraph_edge *edges = calloc(n, sizeof(tinygraph_edge));
+  // Sorting edges by source then target is sorting the edges'
+  // packed 64 bit (source, target) keys. We pack the targets
+  // into as few bits as needed so that the radix sort can skip
+  // the passes for the unused high bits of smaller graphs
+
+  uint32_t max_target = 0;
 
-  if (!edges) {
+  for (uint32_t i = 0; i < n; ++i) {
+    max_target = targets[i] > max_target ? targets[i] : max_target;
+  }
+
+  const uint32_t bits = 32 - tinygraph_bits_leading0_u32(max_target);
+  const uint32_t mask = bits == 32 ? UINT32_MAX : (UINT32_C(1) << bits) - 1;
+
+  uint64_t *keys = malloc(n * sizeof(uint64_t));
+
+  if (!keys) {
     return false;
   }
 
   for (uint32_t i = 0; i < n; ++i) {
-    edges[i] = (tinygraph_edge) {
-      .source = sources[i],
-      .target = targets[i],
-    };
+    keys[i] = (uint64_t)sources[i] << bits | targets[i];
   }
 
-  qsort(edges, n, sizeof(tinygraph_edge), tinygraph_edge_cmp);
+  if (!tinygraph_radix_sort_u64(keys, n)) {
+    free(keys);
+
+    return false;
+  }
 
   for (uint32_t i = 0; i < n; ++i) {
-    sources[i] = edges[i].source;
-    targets[i] = edges[i].target;
+    sources[i] = (uint32_t)(keys[i] >> bits);
+    targets[i] = (uint32_t)keys[i] & mask;
   }
 
-  free(edges);
+  free(keys);
 
   return true;
 }
@@ -290,9 +283,17 @@ tinygraph* tinygraph_construct_empty(void) {
 
   *out = (tinygraph){
     .offsets = NULL,
+    .offsets_rs = NULL,
     .targets = NULL,
-    .offsets_len = 0,
+    .num_nodes = 0,
     .targets_len = 0,
+    .bytes_offsets = NULL,
+    .bytes_offsets_rs = NULL,
+    .bytes = NULL,
+    .bytes_len = 0,
+    .hubs = NULL,
+    .hubs_nodes = NULL,
+    .hubs_len = 0,
   };
 
   return out;
@@ -309,47 +310,206 @@ bool tinygraph_reserve(
   TINYGRAPH_ASSERT(num_nodes != UINT32_MAX);
 
   TINYGRAPH_ASSERT(!graph->offsets);
+  TINYGRAPH_ASSERT(!graph->offsets_rs);
   TINYGRAPH_ASSERT(!graph->targets);
 
-  TINYGRAPH_ASSERT(graph->offsets_len == 0);
+  TINYGRAPH_ASSERT(graph->num_nodes == 0);
   TINYGRAPH_ASSERT(graph->targets_len == 0);
 
-  uint32_t *offsets = calloc(num_nodes + 1, sizeof(uint32_t));
+  // One bit per node, one bit per edge, and the tombstone
+  const uint64_t num_bits = (uint64_t)num_nodes + num_edges + 1;
+
+  tinygraph_bitset_s offsets = tinygraph_bitset_construct(num_bits);
   uint32_t *targets = calloc(num_edges, sizeof(uint32_t));
 
   if (!offsets || !targets) {
-    free(offsets);
+    tinygraph_bitset_destruct(offsets);
     free(targets);
 
     return false;
   }
 
+  // tombstone for: E[select(v)], E[select(v + 1)]
+  tinygraph_bitset_set_at(offsets, num_bits - 1);
+
   *graph = (tinygraph){
     .offsets = offsets,
+    .offsets_rs = NULL,
     .targets = targets,
-    .offsets_len = num_nodes + 1,  // tombstone for: E[V[v]], E[V[v+1]]
+    .num_nodes = num_nodes,
     .targets_len = num_edges,
+    .bytes_offsets = NULL,
+    .bytes_offsets_rs = NULL,
+    .bytes = NULL,
+    .bytes_len = 0,
+    .hubs = NULL,
+    .hubs_nodes = NULL,
+    .hubs_len = 0,
   };
 
   return true;
 }
 
 
+bool tinygraph_reserve_compressed(
+    tinygraph *graph,
+    uint32_t num_nodes,
+    uint32_t num_edges,
+    uint64_t num_bytes,
+    uint32_t num_hubs)
+{
+  TINYGRAPH_ASSERT(graph);
+
+  TINYGRAPH_ASSERT(num_nodes != UINT32_MAX);
+
+  TINYGRAPH_ASSERT(!graph->offsets);
+  TINYGRAPH_ASSERT(!graph->bytes_offsets);
+  TINYGRAPH_ASSERT(!graph->bytes);
+
+  TINYGRAPH_ASSERT(graph->num_nodes == 0);
+  TINYGRAPH_ASSERT(graph->bytes_len == 0);
+
+  const uint64_t num_bits = (uint64_t)num_nodes + num_edges + 1;
+  const uint64_t num_bytes_bits = (uint64_t)num_nodes + num_bytes + 1;
+
+  tinygraph_bitset_s offsets = tinygraph_bitset_construct(num_bits);
+  tinygraph_bitset_s bytes_offsets = tinygraph_bitset_construct(num_bytes_bits);
+  uint8_t *bytes = malloc(num_bytes > 0 ? num_bytes : 1);
+
+  // The hubs are filled in by the caller, calloc
+  // makes sure destructing a partial graph works
+  tinygraph_eliasfano_s *hubs = NULL;
+  uint32_t *hubs_nodes = NULL;
+
+  if (num_hubs > 0) {
+    hubs = calloc(num_hubs, sizeof(tinygraph_eliasfano_s));
+    hubs_nodes = calloc(num_hubs, sizeof(uint32_t));
+  }
+
+  if (!offsets || !bytes_offsets || !bytes || (num_hubs > 0 && (!hubs || !hubs_nodes))) {
+    tinygraph_bitset_destruct(offsets);
+    tinygraph_bitset_destruct(bytes_offsets);
+    free(bytes);
+    free(hubs);
+    free(hubs_nodes);
+
+    return false;
+  }
+
+  tinygraph_bitset_set_at(offsets, num_bits - 1);
+  tinygraph_bitset_set_at(bytes_offsets, num_bytes_bits - 1);
+
+  *graph = (tinygraph){
+    .offsets = offsets,
+    .offsets_rs = NULL,
+    .targets = NULL,
+    .num_nodes = num_nodes,
+    .targets_len = num_edges,
+    .bytes_offsets = bytes_offsets,
+    .bytes_offsets_rs = NULL,
+    .bytes = bytes,
+    .bytes_len = num_bytes,
+    .hubs = hubs,
+    .hubs_nodes = hubs_nodes,
+    .hubs_len = num_hubs,
+  };
+
+  return true;
+}
+
+
+void tinygraph_offsets_set(tinygraph *graph, uint32_t v, uint32_t offset) {
+  TINYGRAPH_ASSERT(graph);
+  TINYGRAPH_ASSERT(graph->offsets);
+  TINYGRAPH_ASSERT(!graph->offsets_rs);
+  TINYGRAPH_ASSERT(v < graph->num_nodes);
+  TINYGRAPH_ASSERT(offset <= graph->targets_len);
+
+  tinygraph_bitset_set_at(graph->offsets, (uint64_t)v + offset);
+}
+
+
+void tinygraph_bytes_offsets_set(tinygraph *graph, uint32_t v, uint64_t offset) {
+  TINYGRAPH_ASSERT(graph);
+  TINYGRAPH_ASSERT(graph->bytes_offsets);
+  TINYGRAPH_ASSERT(!graph->bytes_offsets_rs);
+  TINYGRAPH_ASSERT(v < graph->num_nodes);
+  TINYGRAPH_ASSERT(offset <= graph->bytes_len);
+
+  tinygraph_bitset_set_at(graph->bytes_offsets, v + offset);
+}
+
+
+bool tinygraph_offsets_build(tinygraph *graph) {
+  TINYGRAPH_ASSERT(graph);
+  TINYGRAPH_ASSERT(graph->offsets);
+  TINYGRAPH_ASSERT(!graph->offsets_rs);
+  TINYGRAPH_ASSERT(!graph->bytes_offsets_rs);
+
+  graph->offsets_rs = tinygraph_rankselect_construct(graph->offsets);
+
+  if (!graph->offsets_rs) {
+    return false;
+  }
+
+  // Every node plus the tombstone has its bit set
+  TINYGRAPH_ASSERT(tinygraph_rankselect_get_count(graph->offsets_rs)
+      == (uint64_t)graph->num_nodes + 1);
+
+  if (!graph->bytes_offsets) {
+    return true;
+  }
+
+  graph->bytes_offsets_rs = tinygraph_rankselect_construct(graph->bytes_offsets);
+
+  if (!graph->bytes_offsets_rs) {
+    return false;
+  }
+
+  TINYGRAPH_ASSERT(tinygraph_rankselect_get_count(graph->bytes_offsets_rs)
+      == (uint64_t)graph->num_nodes + 1);
+
+  return true;
+}
+
+
 void tinygraph_print_internal(tinygraph *graph) {
   TINYGRAPH_ASSERT(graph);
 
   fprintf(stderr, "graph internals\n");
   fprintf(stderr, "graph->offsets:");
 
-  for (uint32_t i = 0; i < graph->offsets_len; ++i) {
-    fprintf(stderr, " %ju", (uintmax_t)graph->offsets[i]);
+  if (graph->offsets) {
+    const uint64_t size = tinygraph_bitset_get_size(graph->offsets);
+
+    for (uint64_t i = 0; i < size; ++i) {
+      fprintf(stderr, " %ju", (uintmax_t)tinygraph_bitset_get_at(graph->offsets, i));
+    }
   }
 
   fprintf(stderr, "\n");
   fprintf(stderr, "graph->targets:");
 
-  for (uint32_t i = 0; i < graph->targets_len; ++i) {
-    fprintf(stderr, " %ju", (uintmax_t)graph->targets[i]);
+  if (graph->targets) {
+    for (uint32_t i = 0; i < graph->targets_len; ++i) {
+      fprintf(stderr, " %ju", (uintmax_t)graph->targets[i]);
+    }
+  }
+
+  fprintf(stderr, "\n");
+  fprintf(stderr, "graph->bytes:");
+
+  if (graph->bytes) {
+    for (uint64_t i = 0; i < graph->bytes_len; ++i) {
+      fprintf(stderr, " %ju", (uintmax_t)graph->bytes[i]);
+    }
+  }
+
+  fprintf(stderr, "\n");
+  fprintf(stderr, "graph->hubs_nodes:");
+
+  for (uint32_t i = 0; i < graph->hubs_len; ++i) {
+    fprintf(stderr, " %ju", (uintmax_t)graph->hubs_nodes[i]);
   }
 
   fprintf(stderr, "\n");
@@ -365,24 +525,69 @@ uint8_t tinygraph_requires_num_bytes_u32(uint32_t value) {
 }
 
 
-uint32_t tinygraph_bytes_wasted(tinygraph *graph) {
+uint32_t tinygraph_target_gap_encode(uint32_t source, uint32_t prev, uint32_t target, bool head) {
+  if (head) {
+    return tinygraph_zigzag_encode((int32_t)(target - source));
+  }
+
+  TINYGRAPH_ASSERT(target >= prev);
+
+  return target - prev;
+}
+
+
+uint32_t tinygraph_bytes_wasted(tinygraph *graph, double *log_gap) {
   TINYGRAPH_ASSERT(graph);
 
-  uint32_t actual = 0;
-  uint32_t needed = 0;
+  // The offsets are a succinct bit vector already,
+  // what is left to squeeze out are the edge targets:
+  // we compare them against their vbyte coded gaps,
+  // which depend on the node order and which is what
+  // a compressed copy of the graph would need.
+  //
+  // The average log gap over all edges is a measure
+  // for how well the node order fits the graph, see
+  // e.g. the tinygraph_reorder functions
 
-  actual += sizeof(uint32_t) * graph->offsets_len;
-  actual += sizeof(uint32_t) * graph->targets_len;
+  uint64_t actual = 0;
+  uint64_t needed = 0;
+  double log_gaps = 0;
+
+  const uint32_t num_edges = tinygraph_get_num_edges(graph);
+
+  TINYGRAPH_FOR_EACH_NODE(s, graph) {
+    tinygraph_neighbors_it it;
+    uint32_t t;
+
+    uint32_t prev = s;
+    bool head = true;
+
+    tinygraph_neighbors_begin(graph, &it, s);
+
+    while (tinygraph_neighbors_next(&it, &t)) {
+      const uint32_t gap = tinygraph_target_gap_encode(s, prev, t, head);
 
-  for (uint32_t i = 0; i < graph->offsets_len; ++i) {
-    needed += tinygraph_requires_num_bytes_u32(graph->offsets[i]);
+      needed += tinygraph_requires_num_bytes_u32(gap);
+      log_gaps += log2(1.0 + gap);
+
+      prev = t;
+      head = false;
+    }
+  }
+
+  if (log_gap) {
+    *log_gap = num_edges == 0 ? 0 : log_gaps / num_edges;
   }
 
-  for (uint32_t i = 0; i < graph->targets_len; ++i) {
-    needed += tinygraph_requires_num_bytes_u32(graph->targets[i]);
+  // The targets of a compressed graph are vbyte coded already
+  if (graph->bytes) {
+    return 0;
   }
 
-  TINYGRAPH_ASSERT(actual >= needed);
+  actual += sizeof(uint32_t) * graph->targets_len;
+
+  // Gaps of 2^28 and more need a fifth byte
+  const uint64_t wasted = actual > needed ? actual - needed : 0;
 
-  return actual - needed;
+  return wasted > UINT32_MAX ? UINT32_MAX : (uint32_t)wasted;
 }
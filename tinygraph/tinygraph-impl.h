@@ -5,13 +5,44 @@
 #include <stdbool.h>
 
 #include "tinygraph-utils.h"
-
+#include "tinygraph-bitset.h"
+#include "tinygraph-rankselect.h"
+#include "tinygraph-eliasfano.h"
+
+
+// The graph's out-edge ranges are stored as a succinct
+// bit vector instead of an offsets array: for each node
+// v we write a one followed by out_degree(v) zeros, and
+// a tombstone one at the very end. The edge range of v
+// then is [select(v) - v, select(v + 1) - (v + 1)).
+//
+// Compressed graphs store no flat targets array. Instead
+// each node's sorted targets are delta coded against the
+// node itself (zig-zag coded for the first target) and
+// then vbyte coded into a byte range. The byte ranges are
+// stored in a second unary coded bit vector: for each
+// node v a one followed by one zero per byte.
+//
+// In compressed graphs nodes with at least as many out
+// edges as the hub degree store their targets in an
+// Elias-Fano structure instead, with an empty byte range.
+// This gives random access and fast membership tests
+// for the few nodes with large adjacency lists.
+#define TINYGRAPH_HUB_DEGREE 128
 
 typedef struct tinygraph {
-  uint32_t *offsets;
+  tinygraph_bitset_s offsets;
+  tinygraph_rankselect_s offsets_rs;
   uint32_t *targets;
-  uint32_t offsets_len;
+  uint32_t num_nodes;
   uint32_t targets_len;
+  tinygraph_bitset_s bytes_offsets;
+  tinygraph_rankselect_s bytes_offsets_rs;
+  uint8_t *bytes;
+  uint64_t bytes_len;
+  tinygraph_eliasfano_s *hubs;
+  uint32_t *hubs_nodes;
+  uint32_t hubs_len;
 } tinygraph;
 
 TINYGRAPH_WARN_UNUSED
@@ -71,9 +102,13 @@ bool tinygraph_sort_sources_targets(
     uint32_t *targets,
     uint32_t n);
 
-/* TODO
-void tinygraph_renumber
-*/
+// Node ids per 4k memory page
+#define TINYGRAPH_REORDER_PAGE_NODES (UINT32_C(4096) / sizeof(uint32_t))
+
+// The number of low bits in the n curve positions
+// `keys` the coarse reordering does not sort by
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_reorder_coarse_bits(const uint64_t *keys, uint32_t n);
 
 TINYGRAPH_WARN_UNUSED
 tinygraph* tinygraph_construct_empty(void);
@@ -84,12 +119,38 @@ bool tinygraph_reserve(
     uint32_t num_nodes,
     uint32_t num_edges);
 
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_reserve_compressed(
+    tinygraph *graph,
+    uint32_t num_nodes,
+    uint32_t num_edges,
+    uint64_t num_bytes,
+    uint32_t num_hubs);
+
+// Marks node v's edge range to start at `offset`
+// in the offsets bit vector; once all nodes have
+// their offsets set, build the rank/select index
+void tinygraph_offsets_set(tinygraph *graph, uint32_t v, uint32_t offset);
+
+void tinygraph_bytes_offsets_set(tinygraph *graph, uint32_t v, uint64_t offset);
+
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_offsets_build(tinygraph *graph);
+
 void tinygraph_print_internal(tinygraph *graph);
 
 TINYGRAPH_WARN_UNUSED
 uint8_t tinygraph_requires_num_bytes_u32(uint32_t value);
 
+// The vbyte coded gap to the previous target; the
+// very first target is relative to its source node
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_target_gap_encode(uint32_t source, uint32_t prev, uint32_t target, bool head);
+
+// The bytes the uncompressed graph's targets need on
+// top of their vbyte coded gaps, and the average log2
+// gap into `log_gap` if not NULL
 TINYGRAPH_WARN_UNUSED
-uint32_t tinygraph_bytes_wasted(tinygraph *graph);
+uint32_t tinygraph_bytes_wasted(tinygraph *graph, double *log_gap);
 
 #endif
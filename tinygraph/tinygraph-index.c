@@ -180,10 +180,15 @@ tinygraph_index* tinygraph_index_construct(
   // sorting by the z-order values and then turn the single
   // array-of-struct into a struct-of-array again to query.
 
+  // The z-order values go into their final array first, batch
+  // encoded; we overwrite them in sorted order further below
+
+  tinygraph_zorder_encode64_n(lngs, lats, zvals_, n);
+
   for (uint32_t i = 0; i < n; ++i) {
     tinygraph_index_item item = (tinygraph_index_item){
       .node = nodes[i],
-      .zval = tinygraph_zorder_encode64(lngs[i], lats[i]),
+      .zval = zvals_[i],
       .lng = lngs[i],
       .lat = lats[i],
     };
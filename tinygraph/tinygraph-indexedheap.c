@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tinygraph-utils.h"
+#include "tinygraph-align.h"
+#include "tinygraph-indexedheap.h"
+
+/*
+ * Indexed 4-ary min-heap: a dense array of heap
+ * items as in the binary heap, plus an array
+ * from each value to its item's position so
+ * that we can find and decrease a value's
+ * priority in place. Graph searches such as
+ * Dijkstra's then keep a single item per node
+ * on the frontier instead of re-inserting
+ * nodes and skipping the outdated items.
+ *
+ * The children of item i are 4i+1 to 4i+4, the
+ * heap is half as deep as the binary heap and
+ * moving an item down compares the four items
+ * next to each other in memory. We offset the
+ * items by three from a cache-line aligned
+ * allocation so that the four children of any
+ * item are in the same half of a cache line.
+ *
+ * See
+ *
+ * - https://en.wikipedia.org/wiki/D-ary_heap
+ *
+ * - https://www3.cs.stonybrook.edu/~rezaul/papers/TR-07-54.pdf
+ *   Priority Queues and Dijkstra’s Algorithm
+ */
+
+#define TINYGRAPH_INDEXED_HEAP_ARITY 4
+#define TINYGRAPH_INDEXED_HEAP_OFFSET 3
+#define TINYGRAPH_INDEXED_HEAP_NIL UINT32_MAX
+
+typedef struct tinygraph_indexed_heap_item {
+  uint32_t value;
+  uint32_t priority;
+} tinygraph_indexed_heap_item;
+
+typedef struct tinygraph_indexed_heap {
+  tinygraph_indexed_heap_item *block;
+  tinygraph_indexed_heap_item *items;
+  uint32_t items_len;
+  uint32_t size;
+
+  uint32_t *positions;
+  uint32_t n;
+} tinygraph_indexed_heap;
+
+
+TINYGRAPH_WARN_UNUSED
+static inline uint32_t tinygraph_indexed_heap_parent(uint32_t i) {
+  TINYGRAPH_ASSERT(i > 0);
+
+  return (i - 1) / TINYGRAPH_INDEXED_HEAP_ARITY;
+}
+
+
+TINYGRAPH_WARN_UNUSED
+static inline uint32_t tinygraph_indexed_heap_child(uint32_t i) {
+  return TINYGRAPH_INDEXED_HEAP_ARITY * i + 1;
+}
+
+
+// Moves the item at i up to its position, filling
+// the hole on the way with the parents it passes
+static inline void tinygraph_indexed_heap_sift_up(
+    tinygraph_indexed_heap * const heap, uint32_t i)
+{
+  const tinygraph_indexed_heap_item item = heap->items[i];
+
+  while (i > 0) {
+    const uint32_t p = tinygraph_indexed_heap_parent(i);
+
+    if (heap->items[p].priority <= item.priority) {
+      break;
+    }
+
+    heap->items[i] = heap->items[p];
+    heap->positions[heap->items[i].value] = i;
+
+    i = p;
+  }
+
+  heap->items[i] = item;
+  heap->positions[item.value] = i;
+}
+
+
+// Moves the item at i down to its position, filling
+// the hole on the way with the smallest children
+static inline void tinygraph_indexed_heap_sift_down(
+    tinygraph_indexed_heap * const heap, uint32_t i)
+{
+  const tinygraph_indexed_heap_item item = heap->items[i];
+
+  while (true) {
+    const uint32_t first = tinygraph_indexed_heap_child(i);
+
+    if (first >= heap->size) {
+      break;
+    }
+
+    uint32_t last = first + TINYGRAPH_INDEXED_HEAP_ARITY;
+    last = last < heap->size ? last : heap->size;
+
+    uint32_t s = first;
+
+    for (uint32_t c = first + 1; c < last; ++c) {
+      s = heap->items[c].priority < heap->items[s].priority ? c : s;
+    }
+
+    if (item.priority <= heap->items[s].priority) {
+      break;
+    }
+
+    heap->items[i] = heap->items[s];
+    heap->positions[heap->items[i].value] = i;
+
+    i = s;
+  }
+
+  heap->items[i] = item;
+  heap->positions[item.value] = i;
+}
+
+
+TINYGRAPH_WARN_UNUSED
+static bool tinygraph_indexed_heap_reserve(tinygraph_indexed_heap * const heap, uint32_t capacity) {
+  if (capacity <= heap->items_len) {
+    return true;
+  }
+
+  // There is no aligned realloc, we copy the items over
+  tinygraph_indexed_heap_item *block = tinygraph_align_malloc(64,
+      ((size_t)capacity + TINYGRAPH_INDEXED_HEAP_OFFSET) * sizeof(tinygraph_indexed_heap_item));
+
+  if (!block) {
+    return false;
+  }
+
+  tinygraph_indexed_heap_item *items = block + TINYGRAPH_INDEXED_HEAP_OFFSET;
+
+  if (heap->size > 0) {
+    memcpy(items, heap->items, heap->size * sizeof(tinygraph_indexed_heap_item));
+  }
+
+  tinygraph_align_free(heap->block);
+
+  heap->block = block;
+  heap->items = items;
+  heap->items_len = capacity;
+
+  return true;
+}
+
+
+tinygraph_indexed_heap* tinygraph_indexed_heap_construct(uint32_t n) {
+  tinygraph_indexed_heap *out = malloc(sizeof(tinygraph_indexed_heap));
+
+  if (!out) {
+    return NULL;
+  }
+
+  uint32_t *positions = malloc(n * sizeof(uint32_t));
+
+  if (!positions && n > 0) {
+    free(out);
+
+    return NULL;
+  }
+
+  for (uint32_t i = 0; i < n; ++i) {
+    positions[i] = TINYGRAPH_INDEXED_HEAP_NIL;
+  }
+
+  *out = (tinygraph_indexed_heap) {
+    .block = NULL,
+    .items = NULL,
+    .items_len = 0,
+    .size = 0,
+    .positions = positions,
+    .n = n,
+  };
+
+  return out;
+}
+
+
+void tinygraph_indexed_heap_destruct(tinygraph_indexed_heap * const heap) {
+  if (!heap) {
+    return;
+  }
+
+  tinygraph_align_free(heap->block);
+  free(heap->positions);
+
+  free(heap);
+}
+
+
+uint32_t tinygraph_indexed_heap_get_size(const tinygraph_indexed_heap * const heap) {
+  TINYGRAPH_ASSERT(heap);
+
+  return heap->size;
+}
+
+
+bool tinygraph_indexed_heap_is_empty(const tinygraph_indexed_heap * const heap) {
+  TINYGRAPH_ASSERT(heap);
+
+  return heap->size == 0;
+}
+
+
+bool tinygraph_indexed_heap_contains(const tinygraph_indexed_heap * const heap, uint32_t value) {
+  TINYGRAPH_ASSERT(heap);
+  TINYGRAPH_ASSERT(value < heap->n);
+
+  return heap->positions[value] != TINYGRAPH_INDEXED_HEAP_NIL;
+}
+
+
+uint32_t tinygraph_indexed_heap_get_priority(const tinygraph_indexed_heap * const heap, uint32_t value) {
+  TINYGRAPH_ASSERT(heap);
+  TINYGRAPH_ASSERT(tinygraph_indexed_heap_contains(heap, value));
+
+  return heap->items[heap->positions[value]].priority;
+}
+
+
+uint32_t tinygraph_indexed_heap_get_min_priority(const tinygraph_indexed_heap * const heap) {
+  TINYGRAPH_ASSERT(heap);
+  TINYGRAPH_ASSERT(heap->size > 0);
+
+  return heap->items[0].priority;
+}
+
+
+void tinygraph_indexed_heap_clear(tinygraph_indexed_heap * const heap) {
+  TINYGRAPH_ASSERT(heap);
+
+  // Only the values in the heap have a position
+  for (uint32_t i = 0; i < heap->size; ++i) {
+    heap->positions[heap->items[i].value] = TINYGRAPH_INDEXED_HEAP_NIL;
+  }
+
+  heap->size = 0;
+}
+
+
+bool tinygraph_indexed_heap_push(tinygraph_indexed_heap * const heap, uint32_t value, uint32_t priority) {
+  TINYGRAPH_ASSERT(heap);
+  TINYGRAPH_ASSERT(!tinygraph_indexed_heap_contains(heap, value));
+
+  if (heap->size == heap->items_len) {
+    // Values are in the heap at most once
+    uint64_t growth = heap->items_len == 0 ? 64 : (uint64_t)heap->items_len * 2;
+
+    if (growth > heap->n) {
+      growth = heap->n;
+    }
+
+    if (!tinygraph_indexed_heap_reserve(heap, (uint32_t)growth)) {
+      return false;
+    }
+  }
+
+  heap->items[heap->size] = (tinygraph_indexed_heap_item){
+    .value = value,
+    .priority = priority,
+  };
+
+  heap->size += 1;
+
+  tinygraph_indexed_heap_sift_up(heap, heap->size - 1);
+
+  return true;
+}
+
+
+void tinygraph_indexed_heap_decrease(tinygraph_indexed_heap * const heap, uint32_t value, uint32_t priority) {
+  TINYGRAPH_ASSERT(heap);
+  TINYGRAPH_ASSERT(tinygraph_indexed_heap_contains(heap, value));
+
+  const uint32_t i = heap->positions[value];
+
+  TINYGRAPH_ASSERT(priority <= heap->items[i].priority);
+
+  heap->items[i].priority = priority;
+
+  tinygraph_indexed_heap_sift_up(heap, i);
+}
+
+
+uint32_t tinygraph_indexed_heap_pop(tinygraph_indexed_heap * const heap) {
+  TINYGRAPH_ASSERT(heap);
+  TINYGRAPH_ASSERT(heap->size > 0);
+
+  const uint32_t value = heap->items[0].value;
+
+  heap->positions[value] = TINYGRAPH_INDEXED_HEAP_NIL;
+  heap->size -= 1;
+
+  if (heap->size > 0) {
+    heap->items[0] = heap->items[heap->size];
+
+    tinygraph_indexed_heap_sift_down(heap, 0);
+  }
+
+  return value;
+}
+
+
+void tinygraph_indexed_heap_print_internal(const tinygraph_indexed_heap * const heap) {
+  TINYGRAPH_ASSERT(heap);
+
+  fprintf(stderr, "indexed heap internals\n");
+
+  fprintf(stderr, "size: %ju, capacity: %ju, values: %ju\n",
+      (uintmax_t)heap->size, (uintmax_t)heap->items_len, (uintmax_t)heap->n);
+
+  for (uint32_t i = 0; i < heap->size; ++i) {
+    fprintf(stderr, " (%ju, %ju)",
+        (uintmax_t)heap->items[i].value,
+        (uintmax_t)heap->items[i].priority);
+  }
+
+  fprintf(stderr, "\n");
+}
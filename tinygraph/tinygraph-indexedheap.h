@@ -0,0 +1,59 @@
+#ifndef TINYGRAPH_INDEXEDHEAP_H
+#define TINYGRAPH_INDEXEDHEAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tinygraph-utils.h"
+
+/*
+ * Min-heap over the values [0, n) with each
+ * value in the heap at most once, supporting
+ * to decrease a value's priority in place.
+ *
+ * Push, decrease, and pop are in O(log n),
+ * the heap's size is bounded by n.
+ */
+
+typedef struct tinygraph_indexed_heap* tinygraph_indexed_heap_s;
+typedef const struct tinygraph_indexed_heap* tinygraph_indexed_heap_const_s;
+
+
+TINYGRAPH_WARN_UNUSED
+tinygraph_indexed_heap_s tinygraph_indexed_heap_construct(uint32_t n);
+
+void tinygraph_indexed_heap_destruct(tinygraph_indexed_heap_s heap);
+
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_indexed_heap_get_size(tinygraph_indexed_heap_const_s heap);
+
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_indexed_heap_is_empty(tinygraph_indexed_heap_const_s heap);
+
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_indexed_heap_contains(tinygraph_indexed_heap_const_s heap, uint32_t value);
+
+// The priority of a value in the heap
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_indexed_heap_get_priority(tinygraph_indexed_heap_const_s heap, uint32_t value);
+
+// The priority of the item pop() returns next
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_indexed_heap_get_min_priority(tinygraph_indexed_heap_const_s heap);
+
+void tinygraph_indexed_heap_clear(tinygraph_indexed_heap_s heap);
+
+// Pushes a value not in the heap yet
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_indexed_heap_push(tinygraph_indexed_heap_s heap, uint32_t value, uint32_t priority);
+
+// Lowers the priority of a value in the heap
+void tinygraph_indexed_heap_decrease(tinygraph_indexed_heap_s heap, uint32_t value, uint32_t priority);
+
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_indexed_heap_pop(tinygraph_indexed_heap_s heap);
+
+void tinygraph_indexed_heap_print_internal(tinygraph_indexed_heap_const_s heap);
+
+
+#endif
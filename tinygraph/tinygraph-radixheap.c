@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tinygraph-utils.h"
+#include "tinygraph-bits.h"
+#include "tinygraph-radixheap.h"
+
+/*
+ * Radix heap for monotone priorities: items go
+ * into buckets by the highest bit in which their
+ * priority differs from the last popped priority.
+ * Bucket zero holds the items with exactly the
+ * last popped priority, bucket i > 0 the ones
+ * differing first in bit i - 1.
+ *
+ * Popping from bucket zero is trivial. If it is
+ * empty we take the first non-empty bucket, make
+ * its minimum priority the last popped one, and
+ * redistribute its items: they all end up in
+ * lower buckets, so that each item moves at most
+ * 32 times over its lifetime.
+ *
+ * Compared to the binary heap push and pop are
+ * appends to and removals from the end of flat
+ * arrays, without data dependent branches.
+ *
+ * Popping can run out of memory when moving
+ * items into lower buckets; in that case it
+ * returns false and leaves the heap as is.
+ *
+ * See
+ *
+ * - Faster Algorithms for the Shortest Path Problem,
+ *   Ahuja, Mehlhorn, Orlin, Tarjan, JACM 1990
+ */
+
+#define TINYGRAPH_RADIX_HEAP_BUCKETS 33
+
+typedef struct tinygraph_radix_heap_item {
+  uint32_t value;
+  uint32_t priority;
+} tinygraph_radix_heap_item;
+
+typedef struct tinygraph_radix_heap {
+  tinygraph_radix_heap_item *buckets[TINYGRAPH_RADIX_HEAP_BUCKETS];
+  uint32_t sizes[TINYGRAPH_RADIX_HEAP_BUCKETS];
+  uint32_t capacities[TINYGRAPH_RADIX_HEAP_BUCKETS];
+  uint32_t last;
+  uint32_t size;
+} tinygraph_radix_heap;
+
+
+TINYGRAPH_WARN_UNUSED
+static inline uint32_t tinygraph_radix_heap_bucket(uint32_t last, uint32_t priority) {
+  TINYGRAPH_ASSERT(priority >= last);
+
+  return priority == last ? 0 : 32 - tinygraph_bits_leading0_u32(priority ^ last);
+}
+
+
+TINYGRAPH_WARN_UNUSED
+static inline bool tinygraph_radix_heap_reserve(
+    tinygraph_radix_heap * const heap,
+    uint32_t bucket,
+    uint32_t capacity)
+{
+  if (capacity <= heap->capacities[bucket]) {
+    return true;
+  }
+
+  uint32_t grown = heap->capacities[bucket] == 0 ? 8 : heap->capacities[bucket];
+
+  while (grown < capacity) {
+    grown *= 2;
+  }
+
+  tinygraph_radix_heap_item *items = realloc(heap->buckets[bucket], grown * sizeof(tinygraph_radix_heap_item));
+
+  if (!items) {
+    return false;
+  }
+
+  heap->buckets[bucket] = items;
+  heap->capacities[bucket] = grown;
+
+  return true;
+}
+
+
+tinygraph_radix_heap* tinygraph_radix_heap_construct(void) {
+  tinygraph_radix_heap *out = malloc(sizeof(tinygraph_radix_heap));
+
+  if (!out) {
+    return NULL;
+  }
+
+  *out = (tinygraph_radix_heap) {
+    .buckets = {NULL},
+    .sizes = {0},
+    .capacities = {0},
+    .last = 0,
+    .size = 0,
+  };
+
+  return out;
+}
+
+
+void tinygraph_radix_heap_destruct(tinygraph_radix_heap * const heap) {
+  if (!heap) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < TINYGRAPH_RADIX_HEAP_BUCKETS; ++i) {
+    free(heap->buckets[i]);
+  }
+
+  free(heap);
+}
+
+
+uint32_t tinygraph_radix_heap_get_size(const tinygraph_radix_heap * const heap) {
+  TINYGRAPH_ASSERT(heap);
+
+  return heap->size;
+}
+
+
+bool tinygraph_radix_heap_is_empty(const tinygraph_radix_heap * const heap) {
+  TINYGRAPH_ASSERT(heap);
+
+  return heap->size == 0;
+}
+
+
+uint32_t tinygraph_radix_heap_get_last_priority(const tinygraph_radix_heap * const heap) {
+  TINYGRAPH_ASSERT(heap);
+
+  return heap->last;
+}
+
+
+void tinygraph_radix_heap_clear(tinygraph_radix_heap * const heap) {
+  TINYGRAPH_ASSERT(heap);
+
+  for (uint32_t i = 0; i < TINYGRAPH_RADIX_HEAP_BUCKETS; ++i) {
+    heap->sizes[i] = 0;
+  }
+
+  heap->last = 0;
+  heap->size = 0;
+}
+
+
+bool tinygraph_radix_heap_push(tinygraph_radix_heap * const heap, uint32_t value, uint32_t priority) {
+  TINYGRAPH_ASSERT(heap);
+
+  const uint32_t bucket = tinygraph_radix_heap_bucket(heap->last, priority);
+
+  if (!tinygraph_radix_heap_reserve(heap, bucket, heap->sizes[bucket] + 1)) {
+    return false;
+  }
+
+  heap->buckets[bucket][heap->sizes[bucket]++] = (tinygraph_radix_heap_item){
+    .value = value,
+    .priority = priority,
+  };
+
+  heap->size += 1;
+
+  return true;
+}
+
+
+bool tinygraph_radix_heap_pop(tinygraph_radix_heap * const heap, uint32_t *value) {
+  TINYGRAPH_ASSERT(heap);
+  TINYGRAPH_ASSERT(value);
+  TINYGRAPH_ASSERT(heap->size > 0);
+
+  if (heap->sizes[0] == 0) {
+    uint32_t i = 1;
+
+    while (heap->sizes[i] == 0) {
+      i += 1;
+    }
+
+    TINYGRAPH_ASSERT(i < TINYGRAPH_RADIX_HEAP_BUCKETS);
+
+    tinygraph_radix_heap_item * const items = heap->buckets[i];
+    const uint32_t size = heap->sizes[i];
+
+    uint32_t min = items[0].priority;
+
+    for (uint32_t j = 1; j < size; ++j) {
+      min = items[j].priority < min ? items[j].priority : min;
+    }
+
+    // All items move into the buckets below i which are
+    // empty; make room for them first so that running
+    // out of memory leaves the heap in a valid state
+
+    uint32_t counts[TINYGRAPH_RADIX_HEAP_BUCKETS] = {0};
+
+    for (uint32_t j = 0; j < size; ++j) {
+      counts[tinygraph_radix_heap_bucket(min, items[j].priority)] += 1;
+    }
+
+    for (uint32_t j = 0; j < i; ++j) {
+      if (!tinygraph_radix_heap_reserve(heap, j, counts[j])) {
+        return false;
+      }
+    }
+
+    for (uint32_t j = 0; j < size; ++j) {
+      const uint32_t bucket = tinygraph_radix_heap_bucket(min, items[j].priority);
+
+      TINYGRAPH_ASSERT(bucket < i);
+
+      heap->buckets[bucket][heap->sizes[bucket]++] = items[j];
+    }
+
+    heap->last = min;
+    heap->sizes[i] = 0;
+
+    TINYGRAPH_ASSERT(heap->sizes[0] > 0);
+  }
+
+  heap->size -= 1;
+
+  *value = heap->buckets[0][--heap->sizes[0]].value;
+
+  return true;
+}
+
+
+void tinygraph_radix_heap_print_internal(const tinygraph_radix_heap * const heap) {
+  TINYGRAPH_ASSERT(heap);
+
+  fprintf(stderr, "radix heap internals\n");
+
+  fprintf(stderr, "size: %ju, last: %ju\n",
+      (uintmax_t)heap->size, (uintmax_t)heap->last);
+
+  for (uint32_t i = 0; i < TINYGRAPH_RADIX_HEAP_BUCKETS; ++i) {
+    if (heap->sizes[i] == 0) {
+      continue;
+    }
+
+    fprintf(stderr, "bucket %ju:", (uintmax_t)i);
+
+    for (uint32_t j = 0; j < heap->sizes[i]; ++j) {
+      fprintf(stderr, " (%ju, %ju)",
+          (uintmax_t)heap->buckets[i][j].value,
+          (uintmax_t)heap->buckets[i][j].priority);
+    }
+
+    fprintf(stderr, "\n");
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef TINYGRAPH_RADIXHEAP_H
+#define TINYGRAPH_RADIXHEAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tinygraph-utils.h"
+
+/*
+ * Monotone min-heap for integer priorities:
+ * the priorities pushed must never be smaller
+ * than the priority popped last, as it is the
+ * case e.g. in Dijkstra's algorithm. After
+ * construction and clear() it starts at zero.
+ *
+ * Push is in O(1), pop in amortized O(log C)
+ * for the largest priority difference C.
+ */
+
+typedef struct tinygraph_radix_heap* tinygraph_radix_heap_s;
+typedef const struct tinygraph_radix_heap* tinygraph_radix_heap_const_s;
+
+
+TINYGRAPH_WARN_UNUSED
+tinygraph_radix_heap_s tinygraph_radix_heap_construct(void);
+
+void tinygraph_radix_heap_destruct(tinygraph_radix_heap_s heap);
+
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_radix_heap_get_size(tinygraph_radix_heap_const_s heap);
+
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_radix_heap_is_empty(tinygraph_radix_heap_const_s heap);
+
+// Returns the priority popped last, zero after
+// construction and clear(); pushes must not be
+// smaller than it
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_radix_heap_get_last_priority(tinygraph_radix_heap_const_s heap);
+
+void tinygraph_radix_heap_clear(tinygraph_radix_heap_s heap);
+
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_radix_heap_push(tinygraph_radix_heap_s heap, uint32_t value, uint32_t priority);
+
+// Writes the value with the smallest priority into
+// `value`, returns false if running out of memory
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_radix_heap_pop(tinygraph_radix_heap_s heap, uint32_t *value);
+
+void tinygraph_radix_heap_print_internal(tinygraph_radix_heap_const_s heap);
+
+
+#endif
@@ -0,0 +1,399 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tinygraph-utils.h"
+#include "tinygraph-bits.h"
+#include "tinygraph-bitset.h"
+#include "tinygraph-rankselect.h"
+
+/*
+ * Rank and select on top of the bitset's cache-line
+ * sized 512 bit blocks, following the Poppy design.
+ *
+ * We group four blocks into a 2048 bit superblock and
+ * store a single 64 bit entry per superblock: the lower
+ * 32 bits hold the number of set bits before the super
+ * block, the upper bits interleave the set bit counts
+ * of the superblock's first three blocks, 10 bits each.
+ * The counts before the superblock are relative to the
+ * 2^32 bit region the superblock is in, with a 64 bit
+ * absolute count per region. Rank then reads a single
+ * entry plus a rank within one 512 bit block.
+ *
+ * Select uses a sample per 8192 set (and unset) bits:
+ * the superblock the sampled bit is in. The superblock
+ * with the n-th set bit is then in between two samples
+ * where we binary search the entries, followed by a
+ * select within the superblock's 512 bit block.
+ *
+ * The entries cost 64 bits per 2048 bits, that is an
+ * overhead of 3.125% over the raw bitset. The samples
+ * cost 32 bits per 8192 set or unset bits, that is
+ * less than 0.4% for the set and the unset bits each.
+ *
+ * See
+ * - https://www.cs.cmu.edu/~dga/papers/zhou-sea2013.pdf
+ * - https://arxiv.org/abs/1706.00990
+ * - https://vigna.di.unimi.it/ftp/papers/Broadword.pdf
+ */
+
+#define TINYGRAPH_RANKSELECT_SUPERBLOCK_BITS UINT64_C(2048)
+#define TINYGRAPH_RANKSELECT_REGION_BITS (UINT64_C(1) << 32)
+#define TINYGRAPH_RANKSELECT_SAMPLE_RATE UINT64_C(8192)
+
+typedef struct tinygraph_rankselect {
+  tinygraph_bitset_const_s bitset;
+  uint64_t *entries;
+  uint64_t *regions;
+  uint32_t *samples1;
+  uint32_t *samples0;
+  uint64_t entries_len;
+  uint64_t regions_len;
+  uint64_t samples1_len;
+  uint64_t samples0_len;
+  uint64_t count;
+} tinygraph_rankselect;
+
+
+TINYGRAPH_WARN_UNUSED
+static inline uint64_t tinygraph_rankselect_super_rank(
+    const tinygraph_rankselect * const rs,
+    uint64_t s)
+{
+  const uint64_t region = (s * TINYGRAPH_RANKSELECT_SUPERBLOCK_BITS) / TINYGRAPH_RANKSELECT_REGION_BITS;
+
+  return rs->regions[region] + (rs->entries[s] & UINT64_C(0xffffffff));
+}
+
+TINYGRAPH_WARN_UNUSED
+static inline uint64_t tinygraph_rankselect_super_rank0(
+    const tinygraph_rankselect * const rs,
+    uint64_t s)
+{
+  return s * TINYGRAPH_RANKSELECT_SUPERBLOCK_BITS - tinygraph_rankselect_super_rank(rs, s);
+}
+
+// Returns the set bit count of block b < 3 in superblock s
+TINYGRAPH_WARN_UNUSED
+static inline uint32_t tinygraph_rankselect_block_count(
+    const tinygraph_rankselect * const rs,
+    uint64_t s,
+    uint32_t b)
+{
+  TINYGRAPH_ASSERT(b < 3);
+
+  return (rs->entries[s] >> (32 + b * 10)) & UINT64_C(0x3ff);
+}
+
+
+tinygraph_rankselect* tinygraph_rankselect_construct(tinygraph_bitset_const_s bitset) {
+  TINYGRAPH_ASSERT(bitset);
+
+  tinygraph_rankselect *out = malloc(sizeof(tinygraph_rankselect));
+
+  if (!out) {
+    return NULL;
+  }
+
+  const uint64_t size = tinygraph_bitset_get_size(bitset);
+
+  // The samples store superblock indices in 32 bits
+  TINYGRAPH_ASSERT(size / TINYGRAPH_RANKSELECT_SUPERBLOCK_BITS < UINT32_MAX);
+
+  const uint64_t num_blocks = (size + UINT64_C(511)) / UINT64_C(512);
+  const uint64_t num_supers = (num_blocks + 3) / 4;
+  const uint64_t num_regions = (num_supers * TINYGRAPH_RANKSELECT_SUPERBLOCK_BITS
+      + TINYGRAPH_RANKSELECT_REGION_BITS - 1) / TINYGRAPH_RANKSELECT_REGION_BITS;
+
+  uint64_t *entries = malloc((num_supers > 0 ? num_supers : 1) * sizeof(uint64_t));
+  uint64_t *regions = malloc((num_regions > 0 ? num_regions : 1) * sizeof(uint64_t));
+
+  if (!entries || !regions) {
+    free(entries);
+    free(regions);
+    free(out);
+
+    return NULL;
+  }
+
+  // We run once over the bits counting four blocks at a time
+  // with the bulk popcount; the samples are then computed from
+  // the much smaller superblock entries in a second run
+
+  const uint64_t *data = tinygraph_bitset_get_data(bitset);
+
+  uint64_t count = 0;
+
+  for (uint64_t s = 0; s < num_supers; ++s) {
+    const uint64_t first = s * TINYGRAPH_RANKSELECT_SUPERBLOCK_BITS;
+
+    if (first % TINYGRAPH_RANKSELECT_REGION_BITS == 0) {
+      regions[first / TINYGRAPH_RANKSELECT_REGION_BITS] = count;
+    }
+
+    const uint64_t relative = count - regions[first / TINYGRAPH_RANKSELECT_REGION_BITS];
+
+    TINYGRAPH_ASSERT(relative <= UINT32_MAX);
+
+    // The last superblock can have fewer blocks
+    const uint64_t num_super_blocks = num_blocks - s * 4 < 4 ? num_blocks - s * 4 : 4;
+
+    uint32_t counts[4] = {0, 0, 0, 0};
+
+    tinygraph_bits_count_512_n(data + s * 32, num_super_blocks, counts);
+
+    entries[s] = relative
+      | (uint64_t)counts[0] << 32
+      | (uint64_t)counts[1] << 42
+      | (uint64_t)counts[2] << 52;
+
+    count += counts[0] + counts[1] + counts[2] + counts[3];
+  }
+
+  const uint64_t samples1_len = (count + TINYGRAPH_RANKSELECT_SAMPLE_RATE - 1) / TINYGRAPH_RANKSELECT_SAMPLE_RATE;
+  const uint64_t samples0_len = (size - count + TINYGRAPH_RANKSELECT_SAMPLE_RATE - 1) / TINYGRAPH_RANKSELECT_SAMPLE_RATE;
+
+  uint32_t *samples1 = malloc((samples1_len > 0 ? samples1_len : 1) * sizeof(uint32_t));
+  uint32_t *samples0 = malloc((samples0_len > 0 ? samples0_len : 1) * sizeof(uint32_t));
+
+  if (!samples1 || !samples0) {
+    free(entries);
+    free(regions);
+    free(samples1);
+    free(samples0);
+    free(out);
+
+    return NULL;
+  }
+
+  *out = (tinygraph_rankselect){
+    .bitset = bitset,
+    .entries = entries,
+    .regions = regions,
+    .samples1 = samples1,
+    .samples0 = samples0,
+    .entries_len = num_supers,
+    .regions_len = num_regions,
+    .samples1_len = samples1_len,
+    .samples0_len = samples0_len,
+    .count = count,
+  };
+
+  uint64_t next1 = 0;
+  uint64_t next0 = 0;
+
+  for (uint64_t s = 0; s < num_supers; ++s) {
+    // The set and unset bits up to and including superblock s,
+    // the last superblock's bits can end before its 2048 bits
+
+    const uint64_t ones = s + 1 < num_supers ? tinygraph_rankselect_super_rank(out, s + 1) : count;
+    const uint64_t zeros = s + 1 < num_supers ? tinygraph_rankselect_super_rank0(out, s + 1) : size - count;
+
+    for (; next1 < samples1_len && next1 * TINYGRAPH_RANKSELECT_SAMPLE_RATE < ones; ++next1) {
+      samples1[next1] = s;
+    }
+
+    for (; next0 < samples0_len && next0 * TINYGRAPH_RANKSELECT_SAMPLE_RATE < zeros; ++next0) {
+      samples0[next0] = s;
+    }
+  }
+
+  TINYGRAPH_ASSERT(next1 == samples1_len);
+  TINYGRAPH_ASSERT(next0 == samples0_len);
+
+  return out;
+}
+
+
+void tinygraph_rankselect_destruct(tinygraph_rankselect * const rs) {
+  if (!rs) {
+    return;
+  }
+
+  free(rs->entries);
+  free(rs->regions);
+  free(rs->samples1);
+  free(rs->samples0);
+
+  rs->bitset = NULL;
+  rs->entries = NULL;
+  rs->regions = NULL;
+  rs->samples1 = NULL;
+  rs->samples0 = NULL;
+  rs->entries_len = 0;
+  rs->regions_len = 0;
+  rs->samples1_len = 0;
+  rs->samples0_len = 0;
+  rs->count = 0;
+
+  free(rs);
+}
+
+
+uint64_t tinygraph_rankselect_get_count(const tinygraph_rankselect * const rs) {
+  TINYGRAPH_ASSERT(rs);
+
+  return rs->count;
+}
+
+
+uint64_t tinygraph_rankselect_get_size_in_bytes(const tinygraph_rankselect * const rs) {
+  TINYGRAPH_ASSERT(rs);
+
+  return sizeof(tinygraph_rankselect)
+    + rs->entries_len * sizeof(uint64_t)
+    + rs->regions_len * sizeof(uint64_t)
+    + rs->samples1_len * sizeof(uint32_t)
+    + rs->samples0_len * sizeof(uint32_t);
+}
+
+
+uint64_t tinygraph_rankselect_rank(const tinygraph_rankselect * const rs, uint64_t n) {
+  TINYGRAPH_ASSERT(rs);
+  TINYGRAPH_ASSERT(n <= tinygraph_bitset_get_size(rs->bitset));
+
+  if (n == tinygraph_bitset_get_size(rs->bitset)) {
+    return rs->count;
+  }
+
+  const uint64_t s = n / TINYGRAPH_RANKSELECT_SUPERBLOCK_BITS;
+  const uint32_t b = (n % TINYGRAPH_RANKSELECT_SUPERBLOCK_BITS) / 512;
+  const uint32_t offset = n % UINT64_C(512);
+
+  uint64_t rank = tinygraph_rankselect_super_rank(rs, s);
+
+  for (uint32_t i = 0; i < b; ++i) {
+    rank += tinygraph_rankselect_block_count(rs, s, i);
+  }
+
+  const uint64_t *data = tinygraph_bitset_get_data(rs->bitset);
+
+  return rank + tinygraph_bits_rank_512(data + (s * 4 + b) * 8, offset);
+}
+
+
+uint64_t tinygraph_rankselect_select(const tinygraph_rankselect * const rs, uint64_t n) {
+  TINYGRAPH_ASSERT(rs);
+  TINYGRAPH_ASSERT(n < rs->count);
+
+  // The samples around n bound the superblocks to search,
+  // find the last superblock with rank <= n in between
+
+  const uint64_t k = n / TINYGRAPH_RANKSELECT_SAMPLE_RATE;
+
+  uint64_t first = rs->samples1[k];
+  uint64_t last = k + 1 < rs->samples1_len ? rs->samples1[k + 1] : rs->entries_len - 1;
+
+  while (first < last) {
+    const uint64_t mid = first + (last - first + 1) / 2;
+
+    if (tinygraph_rankselect_super_rank(rs, mid) <= n) {
+      first = mid;
+    } else {
+      last = mid - 1;
+    }
+  }
+
+  const uint64_t s = first;
+
+  uint32_t rest = n - tinygraph_rankselect_super_rank(rs, s);
+  uint32_t b = 0;
+
+  for (; b < 3; ++b) {
+    const uint32_t count = tinygraph_rankselect_block_count(rs, s, b);
+
+    if (rest < count) {
+      break;
+    }
+
+    rest -= count;
+  }
+
+  const uint64_t *data = tinygraph_bitset_get_data(rs->bitset);
+
+  return s * TINYGRAPH_RANKSELECT_SUPERBLOCK_BITS + b * UINT64_C(512)
+    + tinygraph_bits_select_512(data + (s * 4 + b) * 8, rest);
+}
+
+
+uint64_t tinygraph_rankselect_select0(const tinygraph_rankselect * const rs, uint64_t n) {
+  TINYGRAPH_ASSERT(rs);
+  TINYGRAPH_ASSERT(n < tinygraph_bitset_get_size(rs->bitset) - rs->count);
+
+  const uint64_t k = n / TINYGRAPH_RANKSELECT_SAMPLE_RATE;
+
+  uint64_t first = rs->samples0[k];
+  uint64_t last = k + 1 < rs->samples0_len ? rs->samples0[k + 1] : rs->entries_len - 1;
+
+  while (first < last) {
+    const uint64_t mid = first + (last - first + 1) / 2;
+
+    if (tinygraph_rankselect_super_rank0(rs, mid) <= n) {
+      first = mid;
+    } else {
+      last = mid - 1;
+    }
+  }
+
+  const uint64_t s = first;
+
+  uint32_t rest = n - tinygraph_rankselect_super_rank0(rs, s);
+  uint32_t b = 0;
+
+  for (; b < 3; ++b) {
+    const uint32_t count = 512 - tinygraph_rankselect_block_count(rs, s, b);
+
+    if (rest < count) {
+      break;
+    }
+
+    rest -= count;
+  }
+
+  const uint64_t *data = tinygraph_bitset_get_data(rs->bitset) + (s * 4 + b) * 8;
+
+  for (uint32_t i = 0; i < 8; ++i) {
+    const uint64_t word = ~data[i];
+    const uint32_t count = tinygraph_bits_count(word);
+
+    if (rest < count) {
+      return s * TINYGRAPH_RANKSELECT_SUPERBLOCK_BITS + b * UINT64_C(512)
+        + i * 64 + tinygraph_bits_select(word, rest);
+    }
+
+    rest -= count;
+  }
+
+  TINYGRAPH_UNREACHABLE();
+}
+
+
+void tinygraph_rankselect_print_internal(const tinygraph_rankselect * const rs) {
+  TINYGRAPH_ASSERT(rs);
+
+  fprintf(stderr, "rankselect internals\n");
+
+  fprintf(stderr, "count: %ju, superblock ranks:", (uintmax_t)rs->count);
+
+  for (uint64_t i = 0; i < rs->entries_len; ++i) {
+    fprintf(stderr, " %ju", (uintmax_t)tinygraph_rankselect_super_rank(rs, i));
+  }
+
+  fprintf(stderr, "\n");
+
+  fprintf(stderr, "samples1:");
+
+  for (uint64_t i = 0; i < rs->samples1_len; ++i) {
+    fprintf(stderr, " %ju", (uintmax_t)rs->samples1[i]);
+  }
+
+  fprintf(stderr, "\n");
+
+  fprintf(stderr, "samples0:");
+
+  for (uint64_t i = 0; i < rs->samples0_len; ++i) {
+    fprintf(stderr, " %ju", (uintmax_t)rs->samples0[i]);
+  }
+
+  fprintf(stderr, "\n");
+}
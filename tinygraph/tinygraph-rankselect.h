@@ -0,0 +1,48 @@
+#ifndef TINYGRAPH_RANKSELECT_H
+#define TINYGRAPH_RANKSELECT_H
+
+#include <stdint.h>
+
+#include "tinygraph-bitset.h"
+#include "tinygraph-utils.h"
+
+/*
+ * Succinct rank and select on top of a bitset.
+ *
+ * - rank(n): the number of set bits in [0, n)
+ * - select(n): the position of the n-th set bit
+ * - select0(n): the position of the n-th unset bit
+ *
+ * The rank/select structure does not own the
+ * bitset; the bitset must outlive it and must
+ * not change during the structure's lifetime.
+ */
+
+typedef struct tinygraph_rankselect* tinygraph_rankselect_s;
+typedef const struct tinygraph_rankselect* tinygraph_rankselect_const_s;
+
+
+TINYGRAPH_WARN_UNUSED
+tinygraph_rankselect_s tinygraph_rankselect_construct(tinygraph_bitset_const_s bitset);
+
+void tinygraph_rankselect_destruct(tinygraph_rankselect_s rs);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_rankselect_get_count(tinygraph_rankselect_const_s rs);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_rankselect_get_size_in_bytes(tinygraph_rankselect_const_s rs);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_rankselect_rank(tinygraph_rankselect_const_s rs, uint64_t n);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_rankselect_select(tinygraph_rankselect_const_s rs, uint64_t n);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_rankselect_select0(tinygraph_rankselect_const_s rs, uint64_t n);
+
+void tinygraph_rankselect_print_internal(tinygraph_rankselect_const_s rs);
+
+
+#endif
@@ -3,6 +3,10 @@
 
 #include "tinygraph-sort.h"
 
+#ifdef __AVX2__
+#include <x86intrin.h>
+#endif
+
 
 // This implementation is inspired by
 // https://justine.lol/sorting/
@@ -11,10 +15,6 @@
 // parameter to the comparator much like
 // the non-standard qsort_r function.
 //
-// There are two ideas for improvements
-// 1. AVX2 bitonic sort for small ranges
-// 2. trade-off space and use radix sort
-//
 // Note that sometimes we don't need a
 // full sorting but e.g. one use case
 // is knowing the first p elements are
@@ -84,6 +84,94 @@ void tinygraph_sort_u32(
 }
 
 
+TINYGRAPH_WARN_UNUSED
+static int tinygraph_sort_plain_u32_cmp(const void *lhs, const void *rhs) {
+  const uint32_t ilhs = *(const uint32_t *)lhs;
+  const uint32_t irhs = *(const uint32_t *)rhs;
+
+  return (ilhs > irhs) - (ilhs < irhs);
+}
+
+
+#ifdef __AVX2__
+
+// One step of the bitonic sorting network: compare each
+// item against the one at distance j, the blend mask's
+// set bits mark the items which take the maximum
+
+#define TINYGRAPH_SORT_STEP(v, perm, mask) do {                          \
+    const __m256i other = (perm);                                        \
+    v = _mm256_blend_epi32(_mm256_min_epu32(v, other),                   \
+                           _mm256_max_epu32(v, other), (mask));          \
+  } while (0)
+
+#define TINYGRAPH_SORT_J1(v) _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1))
+#define TINYGRAPH_SORT_J2(v) _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2))
+#define TINYGRAPH_SORT_J4(v) _mm256_permute4x64_epi64(v, _MM_SHUFFLE(1, 0, 3, 2))
+
+static inline void tinygraph_sort_network8_u32(uint32_t * restrict a, uint32_t n) {
+  TINYGRAPH_ASSERT(n <= 8);
+
+  // Masked load; the lanes past n are padded with the maximum
+  // value, sort to the back, and are not written back below
+
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32((int32_t)n), lanes);
+
+  __m256i v = _mm256_maskload_epi32((const int *)a, mask);
+  v = _mm256_blendv_epi8(_mm256_set1_epi32(-1), v, mask);
+
+  TINYGRAPH_SORT_STEP(v, TINYGRAPH_SORT_J1(v), 0x66);
+  TINYGRAPH_SORT_STEP(v, TINYGRAPH_SORT_J2(v), 0x3c);
+  TINYGRAPH_SORT_STEP(v, TINYGRAPH_SORT_J1(v), 0x5a);
+  TINYGRAPH_SORT_STEP(v, TINYGRAPH_SORT_J4(v), 0xf0);
+  TINYGRAPH_SORT_STEP(v, TINYGRAPH_SORT_J2(v), 0xcc);
+  TINYGRAPH_SORT_STEP(v, TINYGRAPH_SORT_J1(v), 0xaa);
+
+  _mm256_maskstore_epi32((int *)a, mask, v);
+}
+
+#undef TINYGRAPH_SORT_J4
+#undef TINYGRAPH_SORT_J2
+#undef TINYGRAPH_SORT_J1
+#undef TINYGRAPH_SORT_STEP
+
+#endif
+
+
+void tinygraph_sort_plain_u32(uint32_t * restrict a, uint32_t n) {
+  if (n < 2) {
+    return;
+  }
+
+  TINYGRAPH_ASSERT(a);
+
+#ifdef __AVX2__
+  if (n <= 8) {
+    tinygraph_sort_network8_u32(a, n);
+    return;
+  }
+#endif
+
+  if (n > 32) {
+    qsort(a, n, sizeof(uint32_t), tinygraph_sort_plain_u32_cmp);
+    return;
+  }
+
+  for (uint32_t i = 1; i < n; ++i) {
+    const uint32_t tmp = a[i];
+
+    uint32_t j = i;
+
+    for (; j > 0 && a[j - 1] > tmp; --j) {
+      a[j] = a[j - 1];
+    }
+
+    a[j] = tmp;
+  }
+}
+
+
 static inline void tinygraph_radix_sort_u32_with_mem(
     uint32_t * restrict a,
     uint32_t * restrict copy,
@@ -165,3 +253,190 @@ bool tinygraph_radix_sort_u32(
 
   return true;
 }
+
+
+#define TINYGRAPH_RADIX_BITS 11
+#define TINYGRAPH_RADIX_BUCKETS (UINT32_C(1) << TINYGRAPH_RADIX_BITS)
+#define TINYGRAPH_RADIX_DIGITS ((64 + TINYGRAPH_RADIX_BITS - 1) / TINYGRAPH_RADIX_BITS)
+
+static inline void tinygraph_radix_sort_u64_with_mem(
+    uint64_t * restrict a,
+    uint64_t * restrict copy,
+    uint32_t * restrict counts,
+    uint32_t n)
+{
+  // One pass over the keys for the histograms of all digits,
+  // then one scatter pass per digit; a digit for which all
+  // keys fall into the same bucket would scatter them in
+  // order as they are, and we skip its pass altogether.
+  //
+  // We use 11 bit digits: compared to bytes that is four
+  // instead of six scatter passes for keys of 44 bits, and
+  // the buckets' write positions still stay in the L1 cache
+
+  const uint64_t mask = TINYGRAPH_RADIX_BUCKETS - 1;
+
+  memset(counts, 0, TINYGRAPH_RADIX_DIGITS * TINYGRAPH_RADIX_BUCKETS * sizeof(uint32_t));
+
+  for (uint32_t i = 0; i < n; ++i) {
+    const uint64_t key = a[i];
+
+    for (uint32_t digit = 0; digit < TINYGRAPH_RADIX_DIGITS; ++digit) {
+      counts[digit * TINYGRAPH_RADIX_BUCKETS + ((key >> (digit * TINYGRAPH_RADIX_BITS)) & mask)]++;
+    }
+  }
+
+  uint64_t *from = a;
+  uint64_t *to = copy;
+
+  for (uint32_t digit = 0; digit < TINYGRAPH_RADIX_DIGITS; ++digit) {
+    uint32_t * const offsets = counts + digit * TINYGRAPH_RADIX_BUCKETS;
+    const uint32_t shift = digit * TINYGRAPH_RADIX_BITS;
+
+    if (offsets[(a[0] >> shift) & mask] == n) {
+      continue;
+    }
+
+    uint32_t sum = 0;
+
+    for (uint32_t i = 0; i < TINYGRAPH_RADIX_BUCKETS; ++i) {
+      const uint32_t tmp = offsets[i];
+      offsets[i] = sum;
+      sum += tmp;
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+      const uint64_t key = from[i];
+      to[offsets[(key >> shift) & mask]++] = key;
+    }
+
+    uint64_t * const tmp = from;
+    from = to;
+    to = tmp;
+  }
+
+  if (from != a) {
+    memcpy(a, from, n * sizeof(uint64_t));
+  }
+}
+
+bool tinygraph_radix_sort_u64(uint64_t * restrict a, uint32_t n) {
+  if (n < 2) {
+    return true;
+  }
+
+  uint64_t * const copy = malloc(n * sizeof(uint64_t));
+
+  if (!copy) {
+    return false;
+  }
+
+  uint32_t * const counts = malloc(TINYGRAPH_RADIX_DIGITS * TINYGRAPH_RADIX_BUCKETS * sizeof(uint32_t));
+
+  if (!counts) {
+    free(copy);
+
+    return false;
+  }
+
+  tinygraph_radix_sort_u64_with_mem(a, copy, counts, n);
+
+  free(counts);
+  free(copy);
+
+  return true;
+}
+
+bool tinygraph_radix_sort_u64_u32(
+    uint64_t * restrict keys,
+    uint32_t * restrict values,
+    uint32_t n,
+    uint32_t skip_bits)
+{
+  TINYGRAPH_ASSERT(skip_bits < 64);
+
+  if (n < 2) {
+    return true;
+  }
+
+  uint64_t * const keys_copy = malloc(n * sizeof(uint64_t));
+  uint32_t * const values_copy = malloc(n * sizeof(uint32_t));
+  uint32_t * const counts = malloc(TINYGRAPH_RADIX_DIGITS * TINYGRAPH_RADIX_BUCKETS * sizeof(uint32_t));
+
+  if (!keys_copy || !values_copy || !counts) {
+    free(counts);
+    free(values_copy);
+    free(keys_copy);
+
+    return false;
+  }
+
+  // As above, but the values move along with their keys
+  // and the digits start above the skipped low bits
+
+  const uint64_t mask = TINYGRAPH_RADIX_BUCKETS - 1;
+  const uint32_t num_digits = (64 - skip_bits + TINYGRAPH_RADIX_BITS - 1) / TINYGRAPH_RADIX_BITS;
+
+  memset(counts, 0, num_digits * TINYGRAPH_RADIX_BUCKETS * sizeof(uint32_t));
+
+  for (uint32_t i = 0; i < n; ++i) {
+    const uint64_t key = keys[i] >> skip_bits;
+
+    for (uint32_t digit = 0; digit < num_digits; ++digit) {
+      counts[digit * TINYGRAPH_RADIX_BUCKETS + ((key >> (digit * TINYGRAPH_RADIX_BITS)) & mask)]++;
+    }
+  }
+
+  uint64_t *keys_from = keys;
+  uint64_t *keys_to = keys_copy;
+  uint32_t *values_from = values;
+  uint32_t *values_to = values_copy;
+
+  for (uint32_t digit = 0; digit < num_digits; ++digit) {
+    uint32_t * const offsets = counts + digit * TINYGRAPH_RADIX_BUCKETS;
+    const uint32_t shift = skip_bits + digit * TINYGRAPH_RADIX_BITS;
+
+    if (offsets[(keys[0] >> shift) & mask] == n) {
+      continue;
+    }
+
+    uint32_t sum = 0;
+
+    for (uint32_t i = 0; i < TINYGRAPH_RADIX_BUCKETS; ++i) {
+      const uint32_t tmp = offsets[i];
+      offsets[i] = sum;
+      sum += tmp;
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+      const uint64_t key = keys_from[i];
+      const uint32_t pos = offsets[(key >> shift) & mask]++;
+
+      keys_to[pos] = key;
+      values_to[pos] = values_from[i];
+    }
+
+    uint64_t * const keys_tmp = keys_from;
+    keys_from = keys_to;
+    keys_to = keys_tmp;
+
+    uint32_t * const values_tmp = values_from;
+    values_from = values_to;
+    values_to = values_tmp;
+  }
+
+  if (keys_from != keys) {
+    memcpy(keys, keys_from, n * sizeof(uint64_t));
+    memcpy(values, values_from, n * sizeof(uint32_t));
+  }
+
+  free(counts);
+  free(values_copy);
+  free(keys_copy);
+
+  return true;
+}
+
+#undef TINYGRAPH_RADIX_DIGITS
+#undef TINYGRAPH_RADIX_BUCKETS
+#undef TINYGRAPH_RADIX_BITS
@@ -21,6 +21,14 @@ void tinygraph_sort_u32(
     int32_t (*cmp)(const uint32_t * restrict lhs, const uint32_t * restrict rhs, void * restrict arg),
     void * restrict arg);
 
+/*
+ * Sorts plain integers ascending, without
+ * a comparator. Meant for many short ranges
+ * such as a graph's adjacencies: up to eight
+ * items get sorted in a vector register.
+ */
+void tinygraph_sort_plain_u32(uint32_t * restrict a, uint32_t n);
+
 /*
  * Radix sort with a unary operation
  * as a key extractor to sort by and
@@ -38,5 +46,38 @@ bool tinygraph_radix_sort_u32(
     uint32_t (*op)(const uint32_t * restrict item, void * restrict arg),
     void * restrict arg);
 
+/*
+ * Radix sort for plain 64 bit keys, least
+ * significant digit first; skips the passes
+ * for digits which are the same in all keys.
+ *
+ * Creates a copy of the array to be
+ * sorted internally, trades off space
+ * vs runtime.
+ */
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_radix_sort_u64(uint64_t * restrict a, uint32_t n);
+
+/*
+ * Radix sort for 64 bit keys with 32 bit
+ * values moving along with their keys.
+ *
+ * Sorts by the keys without their lowest
+ * skip_bits bits only: keys equal in all
+ * other bits keep their input order. This
+ * saves the passes for the low digits if
+ * a coarse order is good enough.
+ *
+ * Creates copies of the arrays to be
+ * sorted internally, trades off space
+ * vs runtime.
+ */
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_radix_sort_u64_u32(
+    uint64_t * restrict keys,
+    uint32_t * restrict values,
+    uint32_t n,
+    uint32_t skip_bits);
+
 
 #endif
@@ -0,0 +1,420 @@
+#include <string.h>
+
+#ifdef __AVX2__
+#include <x86intrin.h>
+#include "tinygraph-align.h"
+#endif
+
+#include "tinygraph-streamvbyte.h"
+
+
+#ifdef __AVX2__
+
+// Per control byte the sum of the four lengths
+// i.e. the number of data bytes for the group
+static const uint8_t tinygraph_streamvbyte_lengths[256] = {
+  4, 5, 6, 7, 5, 6, 7, 8, 6, 7, 8, 9, 7, 8, 9, 10,
+  5, 6, 7, 8, 6, 7, 8, 9, 7, 8, 9, 10, 8, 9, 10, 11,
+  6, 7, 8, 9, 7, 8, 9, 10, 8, 9, 10, 11, 9, 10, 11, 12,
+  7, 8, 9, 10, 8, 9, 10, 11, 9, 10, 11, 12, 10, 11, 12, 13,
+  5, 6, 7, 8, 6, 7, 8, 9, 7, 8, 9, 10, 8, 9, 10, 11,
+  6, 7, 8, 9, 7, 8, 9, 10, 8, 9, 10, 11, 9, 10, 11, 12,
+  7, 8, 9, 10, 8, 9, 10, 11, 9, 10, 11, 12, 10, 11, 12, 13,
+  8, 9, 10, 11, 9, 10, 11, 12, 10, 11, 12, 13, 11, 12, 13, 14,
+  6, 7, 8, 9, 7, 8, 9, 10, 8, 9, 10, 11, 9, 10, 11, 12,
+  7, 8, 9, 10, 8, 9, 10, 11, 9, 10, 11, 12, 10, 11, 12, 13,
+  8, 9, 10, 11, 9, 10, 11, 12, 10, 11, 12, 13, 11, 12, 13, 14,
+  9, 10, 11, 12, 10, 11, 12, 13, 11, 12, 13, 14, 12, 13, 14, 15,
+  7, 8, 9, 10, 8, 9, 10, 11, 9, 10, 11, 12, 10, 11, 12, 13,
+  8, 9, 10, 11, 9, 10, 11, 12, 10, 11, 12, 13, 11, 12, 13, 14,
+  9, 10, 11, 12, 10, 11, 12, 13, 11, 12, 13, 14, 12, 13, 14, 15,
+  10, 11, 12, 13, 11, 12, 13, 14, 12, 13, 14, 15, 13, 14, 15, 16,
+};
+
+// Per control byte the shuffle mask moving the
+// group's data bytes into four 32 bit lanes; we
+// set the high bit (0xff) to zero unused bytes
+static const TINYGRAPH_ALIGN(16) uint8_t tinygraph_streamvbyte_shuffles[256][16] = {
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 0xff, 0xff, 0xff, 4, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 0xff, 0xff, 0xff, 5, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 0xff, 0xff, 0xff, 6, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 0xff, 0xff, 0xff, 4, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 0xff, 0xff, 0xff, 5, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 0xff, 0xff, 0xff, 6, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 0xff, 0xff, 0xff, 7, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 0xff, 0xff, 0xff, 5, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 0xff, 0xff, 0xff, 6, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 0xff, 0xff, 0xff, 7, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 0xff, 0xff, 0xff, 8, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 0xff, 0xff, 0xff, 6, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 0xff, 0xff, 0xff, 7, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 0xff, 0xff, 0xff, 8, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 0xff, 0xff, 0xff, 9, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 0xff, 0xff, 5, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 0xff, 0xff, 6, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 6, 0xff, 0xff, 7, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 4, 0xff, 0xff, 5, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 0xff, 0xff, 6, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 6, 0xff, 0xff, 7, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 7, 0xff, 0xff, 8, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 5, 0xff, 0xff, 6, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 0xff, 0xff, 7, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 7, 0xff, 0xff, 8, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 8, 0xff, 0xff, 9, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 6, 0xff, 0xff, 7, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 0xff, 0xff, 8, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 8, 0xff, 0xff, 9, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0xff, 0xff, 10, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 3, 4, 0xff, 5, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 5, 0xff, 6, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 6, 0xff, 7, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 6, 7, 0xff, 8, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 4, 5, 0xff, 6, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 6, 0xff, 7, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 6, 7, 0xff, 8, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 7, 8, 0xff, 9, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 5, 6, 0xff, 7, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 7, 0xff, 8, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 7, 8, 0xff, 9, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 8, 9, 0xff, 10, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 6, 7, 0xff, 8, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 8, 0xff, 9, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 8, 9, 0xff, 10, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0xff, 11, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 3, 4, 5, 6, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 5, 6, 7, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 6, 7, 8, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 6, 7, 8, 9, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 4, 5, 6, 7, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 6, 7, 8, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 6, 7, 8, 9, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 7, 8, 9, 10, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 5, 6, 7, 8, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 7, 8, 9, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 7, 8, 9, 10, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 8, 9, 10, 11, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0xff, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0xff, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0xff, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 0xff, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 0xff, 0xff, 0xff, 5, 6, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 0xff, 0xff, 0xff, 6, 7, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 0xff, 0xff, 0xff, 5, 6, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 0xff, 0xff, 0xff, 6, 7, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 0xff, 0xff, 0xff, 7, 8, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 0xff, 0xff, 0xff, 5, 6, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 0xff, 0xff, 0xff, 6, 7, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 0xff, 0xff, 0xff, 7, 8, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 0xff, 0xff, 0xff, 8, 9, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 0xff, 0xff, 0xff, 6, 7, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 0xff, 0xff, 0xff, 7, 8, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 0xff, 0xff, 0xff, 8, 9, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 0xff, 0xff, 0xff, 9, 10, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 0xff, 0xff, 5, 6, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 0xff, 0xff, 6, 7, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 6, 0xff, 0xff, 7, 8, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 4, 0xff, 0xff, 5, 6, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 0xff, 0xff, 6, 7, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 6, 0xff, 0xff, 7, 8, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 7, 0xff, 0xff, 8, 9, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 5, 0xff, 0xff, 6, 7, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 0xff, 0xff, 7, 8, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 7, 0xff, 0xff, 8, 9, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 8, 0xff, 0xff, 9, 10, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 6, 0xff, 0xff, 7, 8, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 0xff, 0xff, 8, 9, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 8, 0xff, 0xff, 9, 10, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0xff, 0xff, 10, 11, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 5, 0xff, 6, 7, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 6, 0xff, 7, 8, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 6, 7, 0xff, 8, 9, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 4, 5, 0xff, 6, 7, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 6, 0xff, 7, 8, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 6, 7, 0xff, 8, 9, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 7, 8, 0xff, 9, 10, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 5, 6, 0xff, 7, 8, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 7, 0xff, 8, 9, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 7, 8, 0xff, 9, 10, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 8, 9, 0xff, 10, 11, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 6, 7, 0xff, 8, 9, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 8, 0xff, 9, 10, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 8, 9, 0xff, 10, 11, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0xff, 11, 12, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 5, 6, 7, 8, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 6, 7, 8, 9, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 6, 7, 8, 9, 10, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 4, 5, 6, 7, 8, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 6, 7, 8, 9, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 6, 7, 8, 9, 10, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 7, 8, 9, 10, 11, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 5, 6, 7, 8, 9, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 7, 8, 9, 10, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 7, 8, 9, 10, 11, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 8, 9, 10, 11, 12, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0xff, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0xff, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 0xff, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 0xff, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 5, 0xff},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 6, 0xff},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 0xff, 0xff, 0xff, 5, 6, 7, 0xff},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 0xff, 0xff, 0xff, 6, 7, 8, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 6, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 0xff, 0xff, 0xff, 5, 6, 7, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 0xff, 0xff, 0xff, 6, 7, 8, 0xff},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 0xff, 0xff, 0xff, 7, 8, 9, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 0xff, 0xff, 0xff, 5, 6, 7, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 0xff, 0xff, 0xff, 6, 7, 8, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 0xff, 0xff, 0xff, 7, 8, 9, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 0xff, 0xff, 0xff, 8, 9, 10, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 0xff, 0xff, 0xff, 6, 7, 8, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 0xff, 0xff, 0xff, 7, 8, 9, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 0xff, 0xff, 0xff, 8, 9, 10, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 0xff, 0xff, 0xff, 9, 10, 11, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 6, 0xff},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 0xff, 0xff, 5, 6, 7, 0xff},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 0xff, 0xff, 6, 7, 8, 0xff},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 6, 0xff, 0xff, 7, 8, 9, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 4, 0xff, 0xff, 5, 6, 7, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 0xff, 0xff, 6, 7, 8, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 6, 0xff, 0xff, 7, 8, 9, 0xff},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 7, 0xff, 0xff, 8, 9, 10, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 5, 0xff, 0xff, 6, 7, 8, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 0xff, 0xff, 7, 8, 9, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 7, 0xff, 0xff, 8, 9, 10, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 8, 0xff, 0xff, 9, 10, 11, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 6, 0xff, 0xff, 7, 8, 9, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 0xff, 0xff, 8, 9, 10, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 8, 0xff, 0xff, 9, 10, 11, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0xff, 0xff, 10, 11, 12, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 7, 0xff},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 5, 0xff, 6, 7, 8, 0xff},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 6, 0xff, 7, 8, 9, 0xff},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 6, 7, 0xff, 8, 9, 10, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 4, 5, 0xff, 6, 7, 8, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 6, 0xff, 7, 8, 9, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 6, 7, 0xff, 8, 9, 10, 0xff},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 7, 8, 0xff, 9, 10, 11, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 5, 6, 0xff, 7, 8, 9, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 7, 0xff, 8, 9, 10, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 7, 8, 0xff, 9, 10, 11, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 8, 9, 0xff, 10, 11, 12, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 6, 7, 0xff, 8, 9, 10, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 8, 0xff, 9, 10, 11, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 8, 9, 0xff, 10, 11, 12, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0xff, 11, 12, 13, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 8, 0xff},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 5, 6, 7, 8, 9, 0xff},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 6, 7, 8, 9, 10, 0xff},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 6, 7, 8, 9, 10, 11, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 4, 5, 6, 7, 8, 9, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 6, 7, 8, 9, 10, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 6, 7, 8, 9, 10, 11, 0xff},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 7, 8, 9, 10, 11, 12, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 5, 6, 7, 8, 9, 10, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 7, 8, 9, 10, 11, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 7, 8, 9, 10, 11, 12, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 8, 9, 10, 11, 12, 13, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0xff},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 0xff},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 0xff},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 0xff},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 5, 6},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 6, 7},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 0xff, 0xff, 0xff, 5, 6, 7, 8},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 0xff, 0xff, 0xff, 6, 7, 8, 9},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 6, 7},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 0xff, 0xff, 0xff, 5, 6, 7, 8},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 0xff, 0xff, 0xff, 6, 7, 8, 9},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 0xff, 0xff, 0xff, 7, 8, 9, 10},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 0xff, 0xff, 0xff, 5, 6, 7, 8},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 0xff, 0xff, 0xff, 6, 7, 8, 9},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 0xff, 0xff, 0xff, 7, 8, 9, 10},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 0xff, 0xff, 0xff, 8, 9, 10, 11},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 0xff, 0xff, 0xff, 6, 7, 8, 9},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 0xff, 0xff, 0xff, 7, 8, 9, 10},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 0xff, 0xff, 0xff, 8, 9, 10, 11},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 0xff, 0xff, 0xff, 9, 10, 11, 12},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 6, 7},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 0xff, 0xff, 5, 6, 7, 8},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 0xff, 0xff, 6, 7, 8, 9},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 6, 0xff, 0xff, 7, 8, 9, 10},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 4, 0xff, 0xff, 5, 6, 7, 8},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 0xff, 0xff, 6, 7, 8, 9},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 6, 0xff, 0xff, 7, 8, 9, 10},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 7, 0xff, 0xff, 8, 9, 10, 11},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 5, 0xff, 0xff, 6, 7, 8, 9},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 0xff, 0xff, 7, 8, 9, 10},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 7, 0xff, 0xff, 8, 9, 10, 11},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 8, 0xff, 0xff, 9, 10, 11, 12},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 6, 0xff, 0xff, 7, 8, 9, 10},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 0xff, 0xff, 8, 9, 10, 11},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 8, 0xff, 0xff, 9, 10, 11, 12},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0xff, 0xff, 10, 11, 12, 13},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 7, 8},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 5, 0xff, 6, 7, 8, 9},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 6, 0xff, 7, 8, 9, 10},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 6, 7, 0xff, 8, 9, 10, 11},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 4, 5, 0xff, 6, 7, 8, 9},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 6, 0xff, 7, 8, 9, 10},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 6, 7, 0xff, 8, 9, 10, 11},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 7, 8, 0xff, 9, 10, 11, 12},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 5, 6, 0xff, 7, 8, 9, 10},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 7, 0xff, 8, 9, 10, 11},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 7, 8, 0xff, 9, 10, 11, 12},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 8, 9, 0xff, 10, 11, 12, 13},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 6, 7, 0xff, 8, 9, 10, 11},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 8, 0xff, 9, 10, 11, 12},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 8, 9, 0xff, 10, 11, 12, 13},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0xff, 11, 12, 13, 14},
+  {0, 0xff, 0xff, 0xff, 1, 0xff, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 8, 9},
+  {0, 1, 0xff, 0xff, 2, 0xff, 0xff, 0xff, 3, 4, 5, 6, 7, 8, 9, 10},
+  {0, 1, 2, 0xff, 3, 0xff, 0xff, 0xff, 4, 5, 6, 7, 8, 9, 10, 11},
+  {0, 1, 2, 3, 4, 0xff, 0xff, 0xff, 5, 6, 7, 8, 9, 10, 11, 12},
+  {0, 0xff, 0xff, 0xff, 1, 2, 0xff, 0xff, 3, 4, 5, 6, 7, 8, 9, 10},
+  {0, 1, 0xff, 0xff, 2, 3, 0xff, 0xff, 4, 5, 6, 7, 8, 9, 10, 11},
+  {0, 1, 2, 0xff, 3, 4, 0xff, 0xff, 5, 6, 7, 8, 9, 10, 11, 12},
+  {0, 1, 2, 3, 4, 5, 0xff, 0xff, 6, 7, 8, 9, 10, 11, 12, 13},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 0xff, 4, 5, 6, 7, 8, 9, 10, 11},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 0xff, 5, 6, 7, 8, 9, 10, 11, 12},
+  {0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 7, 8, 9, 10, 11, 12, 13},
+  {0, 1, 2, 3, 4, 5, 6, 0xff, 7, 8, 9, 10, 11, 12, 13, 14},
+  {0, 0xff, 0xff, 0xff, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12},
+  {0, 1, 0xff, 0xff, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13},
+  {0, 1, 2, 0xff, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+};
+
+#endif
+
+
+static inline uint32_t tinygraph_streamvbyte_length(uint32_t value) {
+  return 1 + (value > UINT32_C(0xff)) + (value > UINT32_C(0xffff)) + (value > UINT32_C(0xffffff));
+}
+
+
+uint32_t tinygraph_streamvbyte_max_bytes(uint32_t n) {
+  return (n + 3) / 4 + n * sizeof(uint32_t);
+}
+
+
+uint32_t tinygraph_streamvbyte_encode(const uint32_t * restrict data, uint8_t * restrict out, uint32_t n) {
+  if (n == 0) {
+    return 0;
+  }
+
+  TINYGRAPH_ASSERT(data);
+  TINYGRAPH_ASSERT(out);
+
+  uint8_t *control = out;
+  uint8_t *it = out + (n + 3) / 4;
+
+  memset(control, 0, (n + 3) / 4);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    const uint32_t value = data[i];
+    const uint32_t len = tinygraph_streamvbyte_length(value);
+
+    control[i / 4] |= (len - 1) << ((i % 4) * 2);
+
+    for (uint32_t j = 0; j < len; ++j) {
+      it[j] = value >> (j * 8);
+    }
+
+    it += len;
+  }
+
+  const uint32_t len = it - out;
+
+  TINYGRAPH_ASSERT(len <= tinygraph_streamvbyte_max_bytes(n));
+
+  return len;
+}
+
+
+static inline const uint8_t* tinygraph_streamvbyte_decode_group(
+    const uint8_t * restrict data,
+    uint32_t * restrict out,
+    uint8_t control,
+    uint32_t n)
+{
+  TINYGRAPH_ASSERT(n <= 4);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    const uint32_t len = ((control >> (i * 2)) & 3) + 1;
+
+    uint32_t value = 0;
+
+    for (uint32_t j = 0; j < len; ++j) {
+      value |= (uint32_t)data[j] << (j * 8);
+    }
+
+    out[i] = value;
+    data += len;
+  }
+
+  return data;
+}
+
+
+uint32_t tinygraph_streamvbyte_decode(const uint8_t * restrict data, uint32_t * restrict out, uint32_t n) {
+  if (n == 0) {
+    return 0;
+  }
+
+  TINYGRAPH_ASSERT(data);
+  TINYGRAPH_ASSERT(out);
+
+  const uint8_t *control = data;
+  const uint8_t *it = data + (n + 3) / 4;
+
+  uint32_t i = 0;
+
+#ifdef __AVX2__
+  // We decode two groups of four integers per step with
+  // one unaligned 16 byte load per group. These loads may
+  // read past the two groups' data bytes. Each integer is
+  // stored in at least one byte, therefore with twelve more
+  // integers after the two groups we never read past the
+  // end of the encoded data, and we decode the tail below.
+
+  for (; i + 20 <= n; i += 8) {
+    const uint8_t c0 = control[i / 4 + 0];
+    const uint8_t c1 = control[i / 4 + 1];
+
+    const uint32_t len0 = tinygraph_streamvbyte_lengths[c0];
+    const uint32_t len1 = tinygraph_streamvbyte_lengths[c1];
+
+    const __m256i bytes = _mm256_loadu2_m128i(
+        (const __m128i *)(it + len0), (const __m128i *)it);
+
+    const __m256i shuffle = _mm256_set_m128i(
+        _mm_load_si128((const __m128i *)tinygraph_streamvbyte_shuffles[c1]),
+        _mm_load_si128((const __m128i *)tinygraph_streamvbyte_shuffles[c0]));
+
+    _mm256_storeu_si256((__m256i *)(out + i), _mm256_shuffle_epi8(bytes, shuffle));
+
+    it += len0 + len1;
+  }
+#endif
+
+  for (; i < n; i += 4) {
+    const uint32_t m = n - i < 4 ? n - i : 4;
+
+    it = tinygraph_streamvbyte_decode_group(it, out + i, control[i / 4], m);
+  }
+
+  const uint32_t len = it - data;
+
+  TINYGRAPH_ASSERT(len <= tinygraph_streamvbyte_max_bytes(n));
+
+  return len;
+}
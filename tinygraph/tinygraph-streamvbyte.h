@@ -0,0 +1,39 @@
+#ifndef TINYGRAPH_STREAMVBYTE_H
+#define TINYGRAPH_STREAMVBYTE_H
+
+#include <stdint.h>
+
+#include "tinygraph-utils.h"
+
+/*
+ * Stream VByte coding to store 32 bit integers
+ * in 1-4 bytes, depending on their value. Other
+ * than the classic vbyte coding the lengths are
+ * stored as 2 bit codes in separate control bytes
+ * up front, one control byte for four integers,
+ * followed by the data bytes. Decoding then does
+ * not need a data-dependent branch per byte and
+ * with AVX2 decodes eight integers per step with
+ * a shuffle looked up from the control bytes.
+ *
+ * The encoded layout for n integers is
+ *
+ *   [ (n + 3) / 4 control bytes | data bytes ]
+ *
+ * See
+ *
+ * - https://arxiv.org/abs/1709.08990
+ */
+
+
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_streamvbyte_max_bytes(uint32_t n);
+
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_streamvbyte_encode(const uint32_t * restrict data, uint8_t * restrict out, uint32_t n);
+
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_streamvbyte_decode(const uint8_t * restrict data, uint32_t * restrict out, uint32_t n);
+
+
+#endif
@@ -1,3 +1,4 @@
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -17,14 +18,22 @@
 #include "tinygraph-delta.h"
 #include "tinygraph-zigzag.h"
 #include "tinygraph-zorder.h"
+#include "tinygraph-hilbert.h"
 #include "tinygraph-bits.h"
+#include "tinygraph-cpu.h"
 #include "tinygraph-eliasfano.h"
+#include "tinygraph-elias.h"
 #include "tinygraph-align.h"
 #include "tinygraph-heap.h"
+#include "tinygraph-radixheap.h"
+#include "tinygraph-bucketqueue.h"
+#include "tinygraph-indexedheap.h"
 #include "tinygraph-hash.h"
 #include "tinygraph-rng.h"
 #include "tinygraph-sort.h"
 #include "tinygraph-index.h"
+#include "tinygraph-rankselect.h"
+#include "tinygraph-streamvbyte.h"
 
 
 void test1(void) {
@@ -113,6 +122,8 @@ void test5(void) {
   assert(bitset2);
   tinygraph_bitset_set_at(bitset2, 0);
   assert(tinygraph_bitset_get_at(bitset2, 0) == true);
+  tinygraph_bitset_clear_at(bitset2, 0);
+  assert(tinygraph_bitset_get_at(bitset2, 0) == false);
   tinygraph_bitset_destruct(bitset2);
 
   tinygraph_bitset_s bitset3 = tinygraph_bitset_construct(9);
@@ -222,6 +233,13 @@ void test7(void) {
   assert(tinygraph_array_resize(array2, 8));
   assert(tinygraph_array_get_at(array2, 0) == 1);
   assert(tinygraph_array_get_at(array2, 7) == 0);
+  assert(tinygraph_array_resize(array2, 100));
+  assert(tinygraph_array_get_capacity(array2) >= 100);
+  tinygraph_array_clear(array2);
+  for (uint32_t i = 0; i < 1000; ++i) {
+    assert(tinygraph_array_push(array2, i));
+  }
+  assert(tinygraph_array_get_capacity(array2) < 2000);
   tinygraph_array_destruct(array2);
 
   tinygraph_array_s array3 = tinygraph_array_construct(8);
@@ -649,13 +667,72 @@ void test17(void) {
 
 
 void test18(void) {
-  uint32_t data[] = {1, 2, 10, 19, 147};
+  const uint32_t data[5] = {1, 2, 10, 19, 147};
 
-  tinygraph_bitset_s bits = tinygraph_eliasfano_encode(data, 5);
+  uint64_t words[3];
+  uint32_t decoded[5];
 
-  tinygraph_bitset_print_internal(bits);
+  // gamma: 1 + 3 + 7 + 9 + 15 bits, delta: 1 + 4 + 8 + 9 + 14 bits
 
-  tinygraph_bitset_destruct(bits);
+  assert(tinygraph_elias_gamma_num_bits(data, 5) == 35);
+  assert(tinygraph_elias_num_words(35) == 2);
+  assert(tinygraph_elias_gamma_encode(data, words, 5) == 35);
+
+  // Bits from the least significant bit: 1 = 1, 2 = 010, 10 = 0001010
+  assert((words[0] & 0x7ff) == 0x285);
+
+  assert(tinygraph_elias_gamma_decode(words, decoded, 5) == 35);
+
+  for (uint32_t i = 0; i < 5; ++i) {
+    assert(decoded[i] == data[i]);
+  }
+
+  assert(tinygraph_elias_delta_num_bits(data, 5) == 36);
+  assert(tinygraph_elias_delta_encode(data, words, 5) == 36);
+  assert(tinygraph_elias_delta_decode(words, decoded, 5) == 36);
+
+  for (uint32_t i = 0; i < 5; ++i) {
+    assert(decoded[i] == data[i]);
+  }
+
+  // Round trip mixed widths, crossing word boundaries
+
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint32_t n = 1000;
+
+  uint32_t *values = malloc(n * sizeof(uint32_t));
+  uint32_t *out = malloc(n * sizeof(uint32_t));
+  uint64_t *bits = malloc(tinygraph_elias_num_words(n * UINT64_C(63)) * sizeof(uint64_t));
+  assert(values && out && bits);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    values[i] = (tinygraph_rng_random(rng) >> tinygraph_rng_bounded(rng, 32)) | 1;
+  }
+
+  values[0] = UINT32_MAX;
+
+  const uint64_t gamma = tinygraph_elias_gamma_encode(values, bits, n);
+  assert(gamma == tinygraph_elias_gamma_num_bits(values, n));
+  assert(tinygraph_elias_gamma_decode(bits, out, n) == gamma);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    assert(out[i] == values[i]);
+  }
+
+  const uint64_t delta = tinygraph_elias_delta_encode(values, bits, n);
+  assert(delta == tinygraph_elias_delta_num_bits(values, n));
+  assert(tinygraph_elias_delta_decode(bits, out, n) == delta);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    assert(out[i] == values[i]);
+  }
+
+  free(bits);
+  free(out);
+  free(values);
+  tinygraph_rng_destruct(rng);
 }
 
 
@@ -1763,6 +1840,2699 @@ void test44(void) {
 }
 
 
+
+void test45(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint64_t n = 10000;
+
+  tinygraph_bitset_s bits = tinygraph_bitset_construct(n);
+  assert(bits);
+
+  for (uint64_t i = 0; i < n; ++i) {
+    if (tinygraph_rng_bounded(rng, 3) == 0) {
+      tinygraph_bitset_set_at(bits, i);
+    }
+  }
+
+  tinygraph_rankselect_s rs = tinygraph_rankselect_construct(bits);
+  assert(rs);
+
+  uint64_t count = 0;
+
+  for (uint64_t i = 0; i < n; ++i) {
+    assert(tinygraph_rankselect_rank(rs, i) == count);
+
+    if (tinygraph_bitset_get_at(bits, i)) {
+      assert(tinygraph_rankselect_select(rs, count) == i);
+      assert(tinygraph_bitset_find_next(bits, i) == i);
+
+      count += 1;
+    } else {
+      assert(tinygraph_rankselect_select0(rs, i - count) == i);
+    }
+  }
+
+  assert(tinygraph_rankselect_rank(rs, n) == count);
+  assert(tinygraph_rankselect_get_count(rs) == count);
+
+  tinygraph_rankselect_destruct(rs);
+  tinygraph_bitset_destruct(bits);
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test46(void) {
+  const uint32_t sources[5] = {1, 1, 3, 3, 3};
+  const uint32_t targets[5] = {0, 5, 1, 2, 6};
+
+  const tinygraph_s graph = tinygraph_construct_from_sorted_edges(
+      sources, targets, 5);
+
+  assert(graph);
+  assert(tinygraph_get_num_nodes(graph) == 7);
+  assert(tinygraph_get_num_edges(graph) == 5);
+
+  const uint32_t degrees[7] = {0, 2, 0, 3, 0, 0, 0};
+
+  const tinygraph_s copy = tinygraph_copy(graph);
+  assert(copy);
+
+  uint32_t e = 0;
+
+  for (uint32_t v = 0; v < 7; ++v) {
+    uint32_t first, last;
+
+    tinygraph_get_out_edges(graph, v, &first, &last);
+
+    assert(first == e);
+    assert(last == e + degrees[v]);
+    assert(tinygraph_get_out_degree(copy, v) == degrees[v]);
+
+    e = last;
+  }
+
+  assert(tinygraph_has_edge_from_to(copy, 1, 5));
+  assert(tinygraph_has_edge_from_to(copy, 3, 6));
+  assert(!tinygraph_has_edge_from_to(copy, 3, 0));
+
+  tinygraph_destruct(copy);
+  tinygraph_destruct(graph);
+
+  // Degrees around and above the offsets' 64 bit blocks,
+  // where the edge range's end is in the same block, in
+  // the next one, or further away
+
+  const uint32_t hub_degrees[8] = {0, 62, 63, 64, 65, 127, 128, 1000};
+  const uint32_t hub_num_edges = 62 + 63 + 64 + 65 + 127 + 128 + 1000;
+
+  uint32_t *hub_sources = malloc(hub_num_edges * sizeof(uint32_t));
+  uint32_t *hub_targets = malloc(hub_num_edges * sizeof(uint32_t));
+  assert(hub_sources && hub_targets);
+
+  uint32_t m = 0;
+
+  for (uint32_t v = 0; v < 8; ++v) {
+    for (uint32_t i = 0; i < hub_degrees[v]; ++i) {
+      hub_sources[m] = v;
+      hub_targets[m] = i;
+      m += 1;
+    }
+  }
+
+  const tinygraph_s hubs = tinygraph_construct_from_sorted_edges(
+      hub_sources, hub_targets, hub_num_edges);
+
+  assert(hubs);
+
+  e = 0;
+
+  for (uint32_t v = 0; v < 8; ++v) {
+    uint32_t first, last;
+
+    tinygraph_get_out_edges(hubs, v, &first, &last);
+
+    assert(first == e);
+    assert(last == e + hub_degrees[v]);
+
+    e = last;
+  }
+
+  assert(e == hub_num_edges);
+
+  tinygraph_destruct(hubs);
+  free(hub_sources);
+  free(hub_targets);
+}
+
+
+void test47(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint32_t n = 100000;
+
+  tinygraph_s graph = construct_embedded_graph(rng, n, 3);
+  assert(graph);
+
+  // Succinct offsets take a few bits per node instead
+  // of a 32 bit offset per node; targets stay 32 bit
+  const uint32_t flat = sizeof(uint32_t) * ((n + 1) + (n * 3));
+
+  assert(tinygraph_size_in_bytes(graph) < flat);
+  assert(tinygraph_size_in_bytes(graph) - sizeof(uint32_t) * (n * 3) < n);
+
+  tinygraph_destruct(graph);
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test48(void) {
+  const uint32_t sources[6] = {0, 0, 1, 3, 3, 3};
+  const uint32_t targets[6] = {1, 2, 0, 0, 3, 3};
+
+  const tinygraph_s graph = tinygraph_construct_from_sorted_edges(
+      sources, targets, 6);
+  assert(graph);
+  assert(!tinygraph_is_compressed(graph));
+
+  const tinygraph_s cgraph = tinygraph_copy_compressed(graph);
+  assert(cgraph);
+  assert(tinygraph_is_compressed(cgraph));
+
+  assert(tinygraph_get_num_nodes(cgraph) == 4);
+  assert(tinygraph_get_num_edges(cgraph) == 6);
+
+  for (uint32_t e = 0; e < 6; ++e) {
+    assert(tinygraph_get_edge_target(cgraph, e) == targets[e]);
+  }
+
+  assert(tinygraph_get_out_degree(cgraph, 2) == 0);
+  assert(tinygraph_get_out_degree(cgraph, 3) == 3);
+
+  tinygraph_neighbors_it it;
+  uint32_t t;
+
+  tinygraph_neighbors_begin(cgraph, &it, 3);
+  assert(tinygraph_neighbors_next(&it, &t) && t == 0);
+  assert(tinygraph_neighbors_next(&it, &t) && t == 3);
+  assert(tinygraph_neighbors_next(&it, &t) && t == 3);
+  assert(!tinygraph_neighbors_next(&it, &t));
+
+  tinygraph_neighbors_begin(cgraph, &it, 2);
+  assert(!tinygraph_neighbors_next(&it, &t));
+
+  assert(tinygraph_has_edge_from_to(cgraph, 1, 0));
+  assert(!tinygraph_has_edge_from_to(cgraph, 1, 2));
+
+  const tinygraph_s ccopy = tinygraph_copy(cgraph);
+  assert(ccopy);
+  assert(tinygraph_is_compressed(ccopy));
+  assert(tinygraph_has_edge_from_to(ccopy, 3, 3));
+
+  const tinygraph_s rgraph = tinygraph_copy_reversed(cgraph);
+  assert(rgraph);
+  assert(tinygraph_has_edge_from_to(rgraph, 0, 3));
+  assert(tinygraph_has_edge_from_to(rgraph, 2, 0));
+
+  tinygraph_destruct(rgraph);
+  tinygraph_destruct(ccopy);
+  tinygraph_destruct(cgraph);
+  tinygraph_destruct(graph);
+}
+
+
+void test49(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint32_t n = 10000;
+
+  tinygraph_s graph = construct_embedded_graph(rng, n, 3);
+  assert(graph);
+
+  tinygraph_s cgraph = tinygraph_copy_compressed(graph);
+  assert(cgraph);
+
+  // The embedded graph has small gaps, these take one byte
+  assert(tinygraph_size_in_bytes(cgraph) * 2 < tinygraph_size_in_bytes(graph));
+
+  TINYGRAPH_FOR_EACH_NODE(s, graph) {
+    const uint32_t *first, *last;
+
+    tinygraph_get_neighbors(graph, &first, &last, s);
+
+    tinygraph_neighbors_it it;
+    uint32_t t;
+
+    tinygraph_neighbors_begin(cgraph, &it, s);
+
+    for (; first != last; ++first) {
+      assert(tinygraph_neighbors_next(&it, &t));
+      assert(t == *first);
+    }
+
+    assert(!tinygraph_neighbors_next(&it, &t));
+  }
+
+  uint16_t* weights = malloc(n * 3 * sizeof(uint16_t));
+  assert(weights);
+
+  for (uint32_t i = 0; i < (n * 3); ++i) {
+    weights[i] = tinygraph_rng_bounded(rng, 100);
+  }
+
+  tinygraph_dijkstra_s ctx = tinygraph_dijkstra_construct(graph, weights);
+  tinygraph_dijkstra_s cctx = tinygraph_dijkstra_construct(cgraph, weights);
+  assert(ctx);
+  assert(cctx);
+
+  for (uint32_t i = 0; i < 10; ++i) {
+    const uint32_t s = tinygraph_rng_bounded(rng, n);
+    const uint32_t t = tinygraph_rng_bounded(rng, n);
+
+    const bool ok = tinygraph_dijkstra_shortest_path(ctx, s, t);
+    assert(ok == tinygraph_dijkstra_shortest_path(cctx, s, t));
+
+    if (ok) {
+      assert(tinygraph_dijkstra_get_distance(ctx)
+          == tinygraph_dijkstra_get_distance(cctx));
+    }
+  }
+
+  tinygraph_dijkstra_destruct(cctx);
+  tinygraph_dijkstra_destruct(ctx);
+  free(weights);
+  tinygraph_destruct(cgraph);
+  tinygraph_destruct(graph);
+  tinygraph_rng_destruct(rng);
+}
+
+void test50(void) {
+  const uint32_t original[5] = {0, 256+1, 65536+1, 16777216+1, 4294967295};
+
+  const uint8_t expected[2 + 1 + 2 + 3 + 4 + 4] = {
+    0xe4, 0x03,
+    0,
+    1, 1,
+    1, 0, 1,
+    1, 0, 0, 1,
+    255, 255, 255, 255,
+  };
+
+  uint8_t encoded[2 + 5 * 4];
+
+  const uint32_t n = tinygraph_streamvbyte_encode(original, encoded, 5);
+  assert(n == 16);
+  assert(n <= tinygraph_streamvbyte_max_bytes(5));
+
+  for (uint32_t i = 0; i < n; ++i) {
+    assert(encoded[i] == expected[i]);
+  }
+
+  uint32_t decoded[5];
+
+  const uint32_t m = tinygraph_streamvbyte_decode(expected, decoded, 5);
+  assert(m == n);
+
+  for (uint32_t i = 0; i < 5; ++i) {
+    assert(decoded[i] == original[i]);
+  }
+
+  // Round trip mixed widths for all lengths around
+  // the vectorized decoding steps and scalar tails
+
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  uint32_t data[100];
+  uint8_t bytes[25 + 100 * 4];
+  uint32_t out[100];
+
+  for (uint32_t len = 0; len <= 100; ++len) {
+    for (uint32_t i = 0; i < len; ++i) {
+      data[i] = tinygraph_rng_random(rng) >> (tinygraph_rng_bounded(rng, 4) * 8);
+    }
+
+    const uint32_t k = tinygraph_streamvbyte_encode(data, bytes, len);
+    assert(k <= tinygraph_streamvbyte_max_bytes(len));
+
+    assert(tinygraph_streamvbyte_decode(bytes, out, len) == k);
+
+    for (uint32_t i = 0; i < len; ++i) {
+      assert(out[i] == data[i]);
+    }
+  }
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test51(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint32_t n = 1000;
+
+  uint32_t data[1000];
+  uint32_t decoded[1000];
+
+  // Dense with duplicates, sparse, and very sparse sequences
+  const uint32_t bounds[3] = {3, 1000, UINT32_C(1) << 22};
+
+  for (uint32_t b = 0; b < 3; ++b) {
+    uint32_t value = 0;
+
+    for (uint32_t i = 0; i < n; ++i) {
+      value += tinygraph_rng_bounded(rng, bounds[b]);
+      data[i] = value;
+    }
+
+    tinygraph_eliasfano_s ef = tinygraph_eliasfano_construct(data, n);
+    assert(ef);
+
+    assert(tinygraph_eliasfano_get_size(ef) == n);
+
+    uint64_t pos = 0;
+
+    for (uint32_t i = 0; i < n; ++i) {
+      assert(tinygraph_eliasfano_access(ef, i) == data[i]);
+      assert(tinygraph_eliasfano_decode_next(ef, i, &pos) == data[i]);
+    }
+
+    tinygraph_eliasfano_decode(ef, decoded);
+
+    for (uint32_t i = 0; i < n; ++i) {
+      assert(decoded[i] == data[i]);
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+      const uint32_t x = data[i] - (i % 2);
+
+      const uint32_t *it = tinygraph_binary_search_u32(data, data + n, x);
+
+      assert(tinygraph_eliasfano_rank(ef, x) == (uint32_t)(it - data));
+
+      uint32_t geq;
+      assert(tinygraph_eliasfano_next_geq(ef, x, &geq));
+      assert(geq == *it);
+    }
+
+    uint32_t geq;
+    assert(!tinygraph_eliasfano_next_geq(ef, data[n - 1] + 1, &geq));
+    assert(tinygraph_eliasfano_rank(ef, data[n - 1] + 1) == n);
+
+    tinygraph_eliasfano_destruct(ef);
+  }
+
+  const uint32_t edges[2] = {0, UINT32_MAX};
+
+  tinygraph_eliasfano_s ef = tinygraph_eliasfano_construct(edges + 1, 1);
+  assert(ef);
+  assert(tinygraph_eliasfano_access(ef, 0) == UINT32_MAX);
+  assert(tinygraph_eliasfano_rank(ef, 0) == 0);
+  assert(tinygraph_eliasfano_rank(ef, UINT32_MAX) == 0);
+  tinygraph_eliasfano_destruct(ef);
+
+  ef = tinygraph_eliasfano_construct(edges, 2);
+  assert(ef);
+  assert(tinygraph_eliasfano_access(ef, 0) == 0);
+  assert(tinygraph_eliasfano_access(ef, 1) == UINT32_MAX);
+  assert(tinygraph_eliasfano_rank(ef, 1) == 1);
+  tinygraph_eliasfano_destruct(ef);
+
+  ef = tinygraph_eliasfano_construct(NULL, 0);
+  assert(ef);
+  assert(tinygraph_eliasfano_get_size(ef) == 0);
+  assert(tinygraph_eliasfano_rank(ef, 7) == 0);
+  tinygraph_eliasfano_destruct(ef);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test52(void) {
+  // Node 0 is a hub connected to every other second node,
+  // all other nodes have a single edge to their successor
+
+  const uint32_t n = 1000;
+  const uint32_t m = (n - 1) + n / 2;
+
+  uint32_t *sources = malloc(m * sizeof(uint32_t));
+  uint32_t *targets = malloc(m * sizeof(uint32_t));
+  assert(sources && targets);
+
+  uint32_t e = 0;
+
+  for (uint32_t t = 0; t < n; t += 2) {
+    sources[e] = 0;
+    targets[e] = t;
+    e += 1;
+  }
+
+  for (uint32_t s = 1; s < n; ++s) {
+    sources[e] = s;
+    targets[e] = (s + 1) % n;
+    e += 1;
+  }
+
+  assert(e == m);
+
+  const tinygraph_s graph = tinygraph_construct_from_sorted_edges(
+      sources, targets, m);
+  assert(graph);
+  assert(tinygraph_get_out_degree(graph, 0) >= TINYGRAPH_HUB_DEGREE);
+
+  const tinygraph_s cgraph = tinygraph_copy_compressed(graph);
+  assert(cgraph);
+
+  for (uint32_t i = 0; i < m; ++i) {
+    assert(tinygraph_get_edge_target(cgraph, i) == targets[i]);
+  }
+
+  TINYGRAPH_FOR_EACH_NODE(s, graph) {
+    uint32_t efirst, elast;
+
+    tinygraph_get_out_edges(graph, s, &efirst, &elast);
+
+    tinygraph_neighbors_it it;
+    uint32_t t;
+
+    tinygraph_neighbors_begin(cgraph, &it, s);
+
+    for (; tinygraph_neighbors_next(&it, &t); ++efirst) {
+      assert(t == targets[efirst]);
+    }
+
+    assert(efirst == elast);
+  }
+
+  for (uint32_t t = 0; t < n; ++t) {
+    assert(tinygraph_has_edge_from_to(graph, 0, t) == (t % 2 == 0));
+    assert(tinygraph_has_edge_from_to(cgraph, 0, t) == (t % 2 == 0));
+  }
+
+  const tinygraph_s ccopy = tinygraph_copy(cgraph);
+  assert(ccopy);
+  assert(tinygraph_has_edge_from_to(ccopy, 0, n - 2));
+  assert(!tinygraph_has_edge_from_to(ccopy, 0, n - 1));
+
+  tinygraph_destruct(ccopy);
+  tinygraph_destruct(cgraph);
+  tinygraph_destruct(graph);
+
+  free(sources);
+  free(targets);
+}
+
+
+void test53(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint64_t n = 1000000;
+
+  // Dense, sparse, and very sparse bits spanning many
+  // superblocks and select samples in between
+  const uint32_t densities[3] = {2, 64, 5000};
+
+  for (uint32_t d = 0; d < 3; ++d) {
+    tinygraph_bitset_s bits = tinygraph_bitset_construct(n);
+    assert(bits);
+
+    for (uint64_t i = 0; i < n; ++i) {
+      if (tinygraph_rng_bounded(rng, densities[d]) == 0) {
+        tinygraph_bitset_set_at(bits, i);
+      }
+    }
+
+    tinygraph_rankselect_s rs = tinygraph_rankselect_construct(bits);
+    assert(rs);
+
+    uint64_t count = 0;
+
+    for (uint64_t i = 0; i < n; ++i) {
+      assert(tinygraph_rankselect_rank(rs, i) == count);
+
+      if (tinygraph_bitset_get_at(bits, i)) {
+        assert(tinygraph_rankselect_select(rs, count) == i);
+        count += 1;
+      } else {
+        assert(tinygraph_rankselect_select0(rs, i - count) == i);
+      }
+    }
+
+    assert(tinygraph_rankselect_rank(rs, n) == count);
+    assert(tinygraph_rankselect_get_count(rs) == count);
+
+    // Overhead over the raw bits stays below 6%
+    const uint64_t overhead = tinygraph_rankselect_get_size_in_bytes(rs) * 8;
+    assert(overhead * 100 < n * 6);
+
+    tinygraph_rankselect_destruct(rs);
+    tinygraph_bitset_destruct(bits);
+  }
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test54(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  uint64_t words[200 * 8];
+  uint32_t counts[200];
+
+  for (uint32_t i = 0; i < 200 * 8; ++i) {
+    words[i] = (uint64_t)tinygraph_rng_random(rng) << 32 | tinygraph_rng_random(rng);
+  }
+
+  // Lengths around the bulk kernels' steps and tails
+
+  uint64_t count = 0;
+
+  for (uint32_t n = 0; n <= 200 * 8; ++n) {
+    assert(tinygraph_bits_count_n(words, n) == count);
+
+    if (n < 200 * 8) {
+      for (uint32_t k = 0; k < 64; k += 13) {
+        assert(tinygraph_bits_rank_n(words, n * UINT64_C(64) + k) == count + tinygraph_bits_rank(words[n], k));
+      }
+
+      count += tinygraph_bits_count(words[n]);
+    }
+  }
+
+  for (uint32_t n = 0; n <= 200; n += 7) {
+    tinygraph_bits_count_512_n(words, n, counts);
+
+    for (uint32_t i = 0; i < n; ++i) {
+      assert(counts[i] == tinygraph_bits_count_512(words + i * 8));
+    }
+  }
+
+  tinygraph_bitset_s bits = tinygraph_bitset_construct(100000);
+  assert(bits);
+
+  assert(tinygraph_bitset_count(bits) == 0);
+
+  for (uint64_t i = 0; i < 100000; i += 3) {
+    tinygraph_bitset_set_at(bits, i);
+  }
+
+  assert(tinygraph_bitset_count(bits) == 33334);
+
+  tinygraph_bitset_not(bits);
+  assert(tinygraph_bitset_count(bits) == 100000 - 33334);
+
+  tinygraph_bitset_destruct(bits);
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test55(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  // The dispatched and the fallback implementations have to agree
+
+  for (uint32_t i = 0; i < 1000; ++i) {
+    uint64_t v = (uint64_t)tinygraph_rng_random(rng) << 32 | tinygraph_rng_random(rng);
+
+    // Sparse and dense words, too
+    if (i % 3 == 1) {
+      v &= (uint64_t)tinygraph_rng_random(rng) << 32 | tinygraph_rng_random(rng);
+    } else if (i % 3 == 2) {
+      v |= (uint64_t)tinygraph_rng_random(rng) << 32 | tinygraph_rng_random(rng);
+    }
+
+    const uint32_t count = tinygraph_bits_count(v);
+
+    for (uint32_t n = 0; n < count; ++n) {
+      const uint32_t pos = tinygraph_bits_select_broadword(v, n);
+
+      assert((v >> pos) & 1);
+      assert(tinygraph_bits_rank(v, pos) == n);
+      assert(tinygraph_bits_select(v, n) == pos);
+
+      if (tinygraph_cpu_has_bmi2()) {
+        assert(tinygraph_bits_select_pdep(v, n) == pos);
+      }
+    }
+
+    const uint32_t x = (uint32_t)v;
+    const uint32_t y = (uint32_t)(v >> 32);
+
+    const uint64_t z = tinygraph_zorder_encode64_lut(x, y);
+    assert(tinygraph_zorder_encode64(x, y) == z);
+
+    uint32_t xx, yy;
+    tinygraph_zorder_decode64_lut(z, &xx, &yy);
+    assert(xx == x && yy == y);
+
+    const uint32_t z32 = tinygraph_zorder_encode32_lut((uint16_t)x, (uint16_t)y);
+    assert(tinygraph_zorder_encode32((uint16_t)x, (uint16_t)y) == z32);
+
+    uint16_t x16, y16;
+    tinygraph_zorder_decode32_lut(z32, &x16, &y16);
+    assert(x16 == (uint16_t)x && y16 == (uint16_t)y);
+
+    if (tinygraph_cpu_has_bmi2()) {
+      assert(tinygraph_zorder_encode64_pdep(x, y) == z);
+      assert(tinygraph_zorder_encode32_pdep((uint16_t)x, (uint16_t)y) == z32);
+    }
+  }
+
+  assert(tinygraph_bits_select_broadword(UINT64_C(0x8000000000000000), 0) == 63);
+  assert(tinygraph_bits_select_broadword(UINT64_C(-1), 63) == 63);
+  assert(tinygraph_bits_select_broadword(UINT64_C(0xd84c8a0), 9) == 27);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test56(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  // The block kernels against plain word popcounts; on
+  // AVX-512 hosts these go through the zmm kernels
+
+  uint64_t words[16 * 8];
+  uint32_t counts[16];
+
+  for (uint32_t i = 0; i < 16 * 8; ++i) {
+    words[i] = (uint64_t)tinygraph_rng_random(rng) << 32 | tinygraph_rng_random(rng);
+  }
+
+  tinygraph_bits_count_512_n(words, 16, counts);
+
+  for (uint32_t b = 0; b < 16; ++b) {
+    const uint64_t *block = words + b * 8;
+
+    uint32_t rank = 0;
+
+    for (uint32_t n = 0; n <= 512; ++n) {
+      assert(tinygraph_bits_rank_512(block, n) == rank);
+
+      if (n < 512) {
+        rank += (block[n / 64] >> (n % 64)) & 1;
+      }
+    }
+
+    assert(tinygraph_bits_count_512(block) == rank);
+    assert(counts[b] == rank);
+  }
+
+  // Bulk z-order encoding around the kernel's step and tail
+
+  uint32_t xs[21], ys[21];
+  uint64_t zs[21];
+
+  for (uint32_t i = 0; i < 21; ++i) {
+    xs[i] = tinygraph_rng_random(rng);
+    ys[i] = tinygraph_rng_random(rng);
+  }
+
+  for (uint32_t n = 0; n <= 21; ++n) {
+    memset(zs, 0xff, sizeof(zs));
+
+    tinygraph_zorder_encode64_n(xs, ys, zs, n);
+
+    for (uint32_t i = 0; i < n; ++i) {
+      assert(zs[i] == tinygraph_zorder_encode64_lut(xs[i], ys[i]));
+    }
+
+    for (uint32_t i = n; i < 21; ++i) {
+      assert(zs[i] == UINT64_MAX);
+    }
+  }
+
+  // Bitwise operations, with sizes off the cache-line
+
+  tinygraph_bitset_s lhs = tinygraph_bitset_construct(1000);
+  tinygraph_bitset_s rhs = tinygraph_bitset_construct(1000);
+  assert(lhs && rhs);
+
+  for (uint64_t i = 0; i < 1000; ++i) {
+    if (i % 2 == 0) {
+      tinygraph_bitset_set_at(lhs, i);
+    }
+
+    if (i % 3 == 0) {
+      tinygraph_bitset_set_at(rhs, i);
+    }
+  }
+
+  tinygraph_bitset_s both = tinygraph_bitset_copy(lhs);
+  tinygraph_bitset_s either = tinygraph_bitset_copy(lhs);
+  tinygraph_bitset_s one = tinygraph_bitset_copy(lhs);
+  assert(both && either && one);
+
+  tinygraph_bitset_and(both, rhs);
+  tinygraph_bitset_or(either, rhs);
+  tinygraph_bitset_xor(one, rhs);
+
+  for (uint64_t i = 0; i < 1000; ++i) {
+    assert(tinygraph_bitset_get_at(both, i) == (i % 2 == 0 && i % 3 == 0));
+    assert(tinygraph_bitset_get_at(either, i) == (i % 2 == 0 || i % 3 == 0));
+    assert(tinygraph_bitset_get_at(one, i) == ((i % 2 == 0) != (i % 3 == 0)));
+  }
+
+  assert(tinygraph_bitset_count(both) == 167);
+  assert(tinygraph_bitset_count(either) == 667);
+  assert(tinygraph_bitset_count(one) == 500);
+
+  tinygraph_bitset_destruct(one);
+  tinygraph_bitset_destruct(either);
+  tinygraph_bitset_destruct(both);
+  tinygraph_bitset_destruct(rhs);
+  tinygraph_bitset_destruct(lhs);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test57(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint32_t n = 5000;
+
+  uint64_t *keys = malloc(n * sizeof(uint64_t));
+  assert(keys);
+
+  // Random keys, keys with constant bytes, and keys
+  // with a single varying byte to exercise pass skipping
+
+  const uint64_t masks[4] = {
+    UINT64_MAX,
+    UINT64_C(0x000fffff0000ffff),
+    UINT64_C(0x0000ff0000000000),
+    UINT64_C(0),
+  };
+
+  for (uint32_t m = 0; m < 4; ++m) {
+    uint64_t sum = 0;
+
+    for (uint32_t i = 0; i < n; ++i) {
+      keys[i] = ((uint64_t)tinygraph_rng_random(rng) << 32 | tinygraph_rng_random(rng)) & masks[m];
+      keys[i] |= UINT64_C(0x1000000000000000);
+      sum += keys[i];
+    }
+
+    assert(tinygraph_radix_sort_u64(keys, n));
+
+    for (uint32_t i = 1; i < n; ++i) {
+      assert(keys[i - 1] <= keys[i]);
+      sum -= keys[i];
+    }
+
+    assert(sum == keys[0]);
+  }
+
+  assert(tinygraph_radix_sort_u64(keys, 0));
+  assert(tinygraph_radix_sort_u64(keys, 1));
+
+  free(keys);
+
+  uint32_t *sources = malloc(n * sizeof(uint32_t));
+  uint32_t *targets = malloc(n * sizeof(uint32_t));
+  assert(sources && targets);
+
+  uint64_t checksum = 0;
+
+  for (uint32_t i = 0; i < n; ++i) {
+    sources[i] = tinygraph_rng_bounded(rng, 100);
+    targets[i] = tinygraph_rng_random(rng);
+    checksum += (uint64_t)sources[i] * 31 + targets[i];
+  }
+
+  assert(tinygraph_sort_sources_targets(sources, targets, n));
+  assert(tinygraph_is_sorted_sources_targets(sources, targets, n));
+
+  for (uint32_t i = 0; i < n; ++i) {
+    checksum -= (uint64_t)sources[i] * 31 + targets[i];
+  }
+
+  assert(checksum == 0);
+
+  free(targets);
+  free(sources);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test58(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  // Plain sorting around the sorting network's and the
+  // insertion sort's sizes, with duplicates and extremes
+
+  uint32_t items[50];
+  uint32_t sorted[50];
+
+  for (uint32_t n = 0; n <= 50; ++n) {
+    for (uint32_t i = 0; i < n; ++i) {
+      items[i] = i % 3 == 0 ? tinygraph_rng_bounded(rng, 4) : tinygraph_rng_random(rng);
+    }
+
+    if (n > 1) {
+      items[n - 1] = UINT32_MAX;
+    }
+
+    memcpy(sorted, items, n * sizeof(uint32_t));
+
+    tinygraph_sort_plain_u32(sorted, n);
+
+    assert(tinygraph_is_sorted_u32(sorted, n));
+
+    for (uint32_t i = 0; i < n; ++i) {
+      uint32_t count = 0;
+
+      for (uint32_t j = 0; j < n; ++j) {
+        count += (items[j] == items[i]) - (sorted[j] == items[i]);
+      }
+
+      assert(count == 0);
+    }
+  }
+
+  // The counting sort construction has to result in the very
+  // same graph as sorting all edges first, including nodes
+  // without out edges, duplicate edges, and high degree nodes
+
+  const uint32_t n = 3000;
+
+  uint32_t *sources = malloc(n * sizeof(uint32_t));
+  uint32_t *targets = malloc(n * sizeof(uint32_t));
+  assert(sources && targets);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    sources[i] = i % 5 == 0 ? 7 : tinygraph_rng_bounded(rng, 500) * 2;
+    targets[i] = tinygraph_rng_bounded(rng, 1200);
+  }
+
+  sources[0] = 1200;
+  targets[1] = targets[2];
+  sources[1] = sources[2];
+
+  tinygraph_s graph = tinygraph_construct_from_unsorted_edges(sources, targets, n);
+  assert(graph);
+
+  assert(tinygraph_sort_sources_targets(sources, targets, n));
+
+  tinygraph_s expected = tinygraph_construct_from_sorted_edges(sources, targets, n);
+  assert(expected);
+
+  assert(tinygraph_get_num_nodes(graph) == tinygraph_get_num_nodes(expected));
+  assert(tinygraph_get_num_edges(graph) == tinygraph_get_num_edges(expected));
+  assert(tinygraph_get_num_nodes(graph) == 1201);
+
+  TINYGRAPH_FOR_EACH_NODE(v, graph) {
+    tinygraph_neighbors_it it, eit;
+    uint32_t t, et;
+
+    tinygraph_neighbors_begin(graph, &it, v);
+    tinygraph_neighbors_begin(expected, &eit, v);
+
+    while (tinygraph_neighbors_next(&eit, &et)) {
+      assert(tinygraph_neighbors_next(&it, &t));
+      assert(t == et);
+    }
+
+    assert(!tinygraph_neighbors_next(&it, &t));
+  }
+
+  tinygraph_destruct(expected);
+  tinygraph_destruct(graph);
+
+  free(targets);
+  free(sources);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test59(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  // The parallel construction has to result in the very same
+  // graph as the serial one, for any number of threads, also
+  // more threads than edges and skewed graphs with a hub
+
+  const uint32_t n = 20000;
+
+  uint32_t *sources = malloc(n * sizeof(uint32_t));
+  uint32_t *targets = malloc(n * sizeof(uint32_t));
+  assert(sources && targets);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    sources[i] = i % 4 == 0 ? 1234 : tinygraph_rng_bounded(rng, 3000);
+    targets[i] = tinygraph_rng_bounded(rng, 4000);
+  }
+
+  const uint32_t sizes[4] = {n, 1000, 3, 1};
+  const uint32_t threads[5] = {0, 2, 3, 8, 64};
+
+  for (uint32_t k = 0; k < 4; ++k) {
+    tinygraph_s expected = tinygraph_construct_from_unsorted_edges(sources, targets, sizes[k]);
+    assert(expected);
+
+    for (uint32_t j = 0; j < 5; ++j) {
+      tinygraph_s graph = tinygraph_construct_from_unsorted_edges_parallel(sources, targets, sizes[k], threads[j]);
+      assert(graph);
+
+      assert(graph->num_nodes == expected->num_nodes);
+      assert(graph->targets_len == expected->targets_len);
+      assert(memcmp(graph->targets, expected->targets, graph->targets_len * sizeof(uint32_t)) == 0);
+
+      const uint64_t num_bits = tinygraph_bitset_get_size(expected->offsets);
+
+      assert(tinygraph_bitset_get_size(graph->offsets) == num_bits);
+
+      for (uint64_t i = 0; i < num_bits; ++i) {
+        assert(tinygraph_bitset_get_at(graph->offsets, i) == tinygraph_bitset_get_at(expected->offsets, i));
+      }
+
+      tinygraph_destruct(graph);
+    }
+
+    tinygraph_destruct(expected);
+  }
+
+  tinygraph_s empty = tinygraph_construct_from_unsorted_edges_parallel(sources, targets, 0, 4);
+  assert(empty);
+  assert(tinygraph_is_empty(empty));
+  tinygraph_destruct(empty);
+
+  free(targets);
+  free(sources);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test60(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint32_t n = 20000;
+
+  uint32_t *sources = malloc(n * sizeof(uint32_t));
+  uint32_t *targets = malloc(n * sizeof(uint32_t));
+  assert(sources && targets);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    sources[i] = tinygraph_rng_bounded(rng, 3000);
+    targets[i] = i % 4 == 0 ? 42 : tinygraph_rng_bounded(rng, 3000);
+  }
+
+  tinygraph_s graph = tinygraph_construct_from_unsorted_edges(sources, targets, n);
+  assert(graph);
+
+  tinygraph_s compressed = tinygraph_copy_compressed(graph);
+  assert(compressed);
+
+  // The transposition has to be the graph from the swapped edges
+
+  tinygraph_s expected = tinygraph_construct_from_unsorted_edges(targets, sources, n);
+  assert(expected);
+
+  tinygraph_s reversed[4] = {
+    tinygraph_copy_reversed(graph),
+    tinygraph_copy_reversed(compressed),
+    tinygraph_copy_reversed_parallel(graph, 4),
+    tinygraph_copy_reversed_parallel(compressed, 3),
+  };
+
+  for (uint32_t k = 0; k < 4; ++k) {
+    assert(reversed[k]);
+
+    assert(reversed[k]->num_nodes == expected->num_nodes);
+    assert(reversed[k]->targets_len == expected->targets_len);
+    assert(memcmp(reversed[k]->targets, expected->targets, n * sizeof(uint32_t)) == 0);
+
+    for (uint64_t i = 0; i < tinygraph_bitset_get_size(expected->offsets); ++i) {
+      assert(tinygraph_bitset_get_at(reversed[k]->offsets, i) == tinygraph_bitset_get_at(expected->offsets, i));
+    }
+
+    tinygraph_destruct(reversed[k]);
+  }
+
+  tinygraph_destruct(expected);
+  tinygraph_destruct(compressed);
+  tinygraph_destruct(graph);
+
+  free(targets);
+  free(sources);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test61(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint32_t n = 20000;
+
+  uint32_t *sources = malloc(n * sizeof(uint32_t));
+  uint32_t *targets = malloc(n * sizeof(uint32_t));
+  assert(sources && targets);
+
+  // Node 7 is a hub with ranks beyond a byte
+
+  for (uint32_t i = 0; i < n; ++i) {
+    sources[i] = i % 8 == 0 ? 7 : tinygraph_rng_bounded(rng, 3000);
+    targets[i] = tinygraph_rng_bounded(rng, 3000);
+  }
+
+  tinygraph_s graph = tinygraph_construct_from_unsorted_edges(sources, targets, n);
+  assert(graph);
+
+  tinygraph_s compressed = tinygraph_copy_compressed(graph);
+  assert(compressed);
+
+  tinygraph_const_s graphs[2] = {graph, compressed};
+
+  for (uint32_t k = 0; k < 2; ++k) {
+    tinygraph_bidirectional_s bidir = tinygraph_bidirectional_construct(graphs[k]);
+    assert(bidir);
+
+    assert(tinygraph_bidirectional_get_graph(bidir) == graphs[k]);
+    assert(tinygraph_bidirectional_size_in_bytes(bidir) > 0);
+
+    bool *seen = calloc(n, sizeof(bool));
+    assert(seen);
+
+    for (uint32_t v = 0; v < tinygraph_get_num_nodes(graphs[k]); ++v) {
+      uint32_t first, last;
+      tinygraph_bidirectional_get_in_edges(bidir, v, &first, &last);
+
+      assert(last - first == tinygraph_bidirectional_get_in_degree(bidir, v));
+
+      const uint32_t *nfirst, *nlast;
+      tinygraph_bidirectional_get_in_neighbors(bidir, &nfirst, &nlast, v);
+      assert(nlast - nfirst == last - first);
+
+      for (uint32_t e = first; e < last; ++e) {
+        const uint32_t s = tinygraph_bidirectional_get_edge_source(bidir, e);
+        assert(s == nfirst[e - first]);
+
+        const uint32_t f = tinygraph_bidirectional_get_forward_edge(bidir, e);
+        assert(f < n);
+        assert(!seen[f]);
+        seen[f] = true;
+
+        uint32_t ffirst, flast;
+        tinygraph_get_out_edges(graphs[k], s, &ffirst, &flast);
+        assert(ffirst <= f && f < flast);
+        assert(tinygraph_bidirectional_get_forward_edge_in(bidir, e, ffirst, flast) == f);
+
+        assert(tinygraph_get_edge_target(graphs[k], f) == v);
+      }
+    }
+
+    for (uint32_t e = 0; e < n; ++e) {
+      assert(seen[e]);
+    }
+
+    free(seen);
+
+    tinygraph_bidirectional_destruct(bidir);
+  }
+
+  tinygraph_s empty = tinygraph_construct_empty();
+  assert(empty);
+
+  tinygraph_bidirectional_s bidir = tinygraph_bidirectional_construct(empty);
+  assert(bidir);
+  assert(tinygraph_get_num_nodes(tinygraph_bidirectional_get_reversed(bidir)) == 0);
+
+  tinygraph_bidirectional_destruct(bidir);
+  tinygraph_destruct(empty);
+
+  tinygraph_destruct(compressed);
+  tinygraph_destruct(graph);
+
+  free(targets);
+  free(sources);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test62(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint32_t n = 20000;
+
+  uint32_t *sources = malloc(n * sizeof(uint32_t));
+  uint32_t *targets = malloc(n * sizeof(uint32_t));
+  uint32_t *permutation = malloc(n * sizeof(uint32_t));
+  assert(sources && targets && permutation);
+
+  // Few nodes for plenty of duplicate edges
+
+  for (uint32_t i = 0; i < n; ++i) {
+    sources[i] = tinygraph_rng_bounded(rng, 100);
+    targets[i] = tinygraph_rng_bounded(rng, 100);
+  }
+
+  tinygraph_s expected = tinygraph_construct_from_unsorted_edges(sources, targets, n);
+  assert(expected);
+
+  tinygraph_s graph = tinygraph_construct_from_unsorted_edges_permutation(sources, targets, n, permutation);
+  assert(graph);
+
+  assert(graph->num_nodes == expected->num_nodes);
+  assert(memcmp(graph->targets, expected->targets, n * sizeof(uint32_t)) == 0);
+
+  for (uint64_t i = 0; i < tinygraph_bitset_get_size(expected->offsets); ++i) {
+    assert(tinygraph_bitset_get_at(graph->offsets, i) == tinygraph_bitset_get_at(expected->offsets, i));
+  }
+
+  bool *seen = calloc(n, sizeof(bool));
+  assert(seen);
+
+  for (uint32_t v = 0; v < graph->num_nodes; ++v) {
+    uint32_t first, last;
+    tinygraph_get_out_edges(graph, v, &first, &last);
+
+    for (uint32_t e = first; e < last; ++e) {
+      const uint32_t i = permutation[e];
+
+      assert(!seen[i]);
+      seen[i] = true;
+
+      assert(sources[i] == v);
+      assert(targets[i] == tinygraph_get_edge_target(graph, e));
+
+      // Duplicate edges stay in their input order
+
+      if (e > first && targets[permutation[e - 1]] == targets[i]) {
+        assert(permutation[e - 1] < i);
+      }
+    }
+  }
+
+  free(seen);
+
+  // Records of a struct as two payload columns
+
+  struct record { uint32_t index; uint16_t weight; };
+
+  struct record *records = malloc(n * sizeof(struct record));
+  struct record *records_out = malloc(n * sizeof(struct record));
+  uint16_t *weights = malloc(n * sizeof(uint16_t));
+  uint16_t *weights_out = malloc(n * sizeof(uint16_t));
+  assert(records && records_out && weights && weights_out);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    records[i] = (struct record){ .index = i, .weight = (uint16_t)(i * 7) };
+    weights[i] = (uint16_t)(i * 7);
+  }
+
+  tinygraph_s with_records = tinygraph_construct_from_unsorted_edges_payload(sources, targets, n, records, records_out, sizeof(struct record));
+  assert(with_records);
+
+  tinygraph_s with_weights = tinygraph_construct_from_unsorted_edges_payload(sources, targets, n, weights, weights_out, sizeof(uint16_t));
+  assert(with_weights);
+
+  assert(memcmp(with_records->targets, expected->targets, n * sizeof(uint32_t)) == 0);
+  assert(memcmp(with_weights->targets, expected->targets, n * sizeof(uint32_t)) == 0);
+
+  for (uint32_t e = 0; e < n; ++e) {
+    assert(records_out[e].index == permutation[e]);
+    assert(records_out[e].weight == weights[permutation[e]]);
+    assert(weights_out[e] == weights[permutation[e]]);
+  }
+
+  tinygraph_s empty = tinygraph_construct_from_unsorted_edges_permutation(NULL, NULL, 0, NULL);
+  assert(empty);
+  assert(tinygraph_is_empty(empty));
+
+  tinygraph_destruct(empty);
+  tinygraph_destruct(with_weights);
+  tinygraph_destruct(with_records);
+  tinygraph_destruct(graph);
+  tinygraph_destruct(expected);
+
+  free(weights_out);
+  free(weights);
+  free(records_out);
+  free(records);
+  free(permutation);
+  free(targets);
+  free(sources);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test63(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint32_t n = 20000;
+  const uint32_t num_nodes = 3000;
+
+  uint32_t *sources = malloc(n * sizeof(uint32_t));
+  uint32_t *targets = malloc(n * sizeof(uint32_t));
+  assert(sources && targets);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    sources[i] = i % 8 == 0 ? 7 : tinygraph_rng_bounded(rng, num_nodes);
+    targets[i] = i == 0 ? num_nodes - 1 : tinygraph_rng_bounded(rng, num_nodes);
+  }
+
+  tinygraph_s graph = tinygraph_construct_from_unsorted_edges(sources, targets, n);
+  assert(graph);
+  assert(tinygraph_get_num_nodes(graph) == num_nodes);
+
+  tinygraph_s compressed = tinygraph_copy_compressed(graph);
+  assert(compressed);
+
+  uint32_t *nodes = malloc(num_nodes * sizeof(uint32_t));
+  uint32_t *inverse = malloc(num_nodes * sizeof(uint32_t));
+  uint32_t *edges = malloc(n * sizeof(uint32_t));
+  uint32_t *attrs = malloc(num_nodes * sizeof(uint32_t));
+  uint16_t *weights = malloc(n * sizeof(uint16_t));
+  assert(nodes && inverse && edges && attrs && weights);
+
+  for (uint32_t i = 0; i < num_nodes; ++i) {
+    nodes[i] = i;
+  }
+
+  for (uint32_t i = num_nodes - 1; i > 0; --i) {
+    const uint32_t j = tinygraph_rng_bounded(rng, i + 1);
+    const uint32_t tmp = nodes[i];
+    nodes[i] = nodes[j];
+    nodes[j] = tmp;
+  }
+
+  tinygraph_const_s graphs[2] = {graph, compressed};
+
+  for (uint32_t k = 0; k < 2; ++k) {
+    tinygraph_s permuted = tinygraph_permute(graphs[k], nodes, inverse, edges);
+    assert(permuted);
+
+    assert(tinygraph_get_num_nodes(permuted) == num_nodes);
+    assert(tinygraph_get_num_edges(permuted) == n);
+
+    for (uint32_t v = 0; v < num_nodes; ++v) {
+      assert(nodes[inverse[v]] == v);
+    }
+
+    // Node and edge attributes follow the nodes and edges
+
+    for (uint32_t v = 0; v < num_nodes; ++v) {
+      attrs[v] = v * 3;
+    }
+
+    for (uint32_t e = 0; e < n; ++e) {
+      weights[e] = (uint16_t)tinygraph_get_edge_target(graphs[k], e);
+    }
+
+    assert(tinygraph_permute_inplace(attrs, sizeof(uint32_t), nodes, num_nodes));
+    assert(tinygraph_permute_inplace(weights, sizeof(uint16_t), edges, n));
+
+    for (uint32_t u = 0; u < num_nodes; ++u) {
+      assert(attrs[u] == nodes[u] * 3);
+
+      uint32_t first, last;
+      tinygraph_get_out_edges(permuted, u, &first, &last);
+      assert(last - first == tinygraph_get_out_degree(graphs[k], nodes[u]));
+
+      for (uint32_t e = first; e < last; ++e) {
+        const uint32_t t = tinygraph_get_edge_target(permuted, e);
+
+        assert(e == first || tinygraph_get_edge_target(permuted, e - 1) <= t);
+        assert(weights[e] == nodes[t]);
+
+        uint32_t ofirst, olast;
+        tinygraph_get_out_edges(graphs[k], nodes[u], &ofirst, &olast);
+        assert(ofirst <= edges[e] && edges[e] < olast);
+      }
+    }
+
+    // The inverse permutation restores the graph
+
+    tinygraph_s restored = tinygraph_permute(permuted, inverse, NULL, NULL);
+    assert(restored);
+
+    assert(memcmp(restored->targets, graph->targets, n * sizeof(uint32_t)) == 0);
+
+    for (uint64_t i = 0; i < tinygraph_bitset_get_size(graph->offsets); ++i) {
+      assert(tinygraph_bitset_get_at(restored->offsets, i) == tinygraph_bitset_get_at(graph->offsets, i));
+    }
+
+    tinygraph_destruct(restored);
+    tinygraph_destruct(permuted);
+  }
+
+  tinygraph_s empty = tinygraph_construct_empty();
+  assert(empty);
+
+  tinygraph_s permuted = tinygraph_permute(empty, NULL, NULL, NULL);
+  assert(permuted);
+  assert(tinygraph_is_empty(permuted));
+  assert(tinygraph_permute_inplace(NULL, 4, NULL, 0));
+
+  tinygraph_destruct(permuted);
+  tinygraph_destruct(empty);
+
+  free(weights);
+  free(attrs);
+  free(edges);
+  free(inverse);
+  free(nodes);
+
+  tinygraph_destruct(compressed);
+  tinygraph_destruct(graph);
+
+  free(targets);
+  free(sources);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test64(void) {
+  // The first 256x256 cells are the curve's first 2^16
+  // positions, with every step moving to a neighbor cell
+
+  const uint32_t side = 256;
+
+  bool *seen = calloc(side * side, sizeof(bool));
+  assert(seen);
+
+  for (uint32_t x = 0; x < side; ++x) {
+    for (uint32_t y = 0; y < side; ++y) {
+      const uint32_t h = tinygraph_hilbert_encode32((uint16_t)x, (uint16_t)y);
+      assert(h < side * side);
+      assert(!seen[h]);
+      seen[h] = true;
+
+      assert(tinygraph_hilbert_encode64(x, y) == h);
+    }
+  }
+
+  free(seen);
+
+  for (uint32_t h = 0; h + 1 < side * side; ++h) {
+    uint16_t x0, y0, x1, y1;
+    tinygraph_hilbert_decode32(h, &x0, &y0);
+    tinygraph_hilbert_decode32(h + 1, &x1, &y1);
+
+    assert(tinygraph_hilbert_encode32(x0, y0) == h);
+
+    const uint32_t dx = x0 > x1 ? x0 - x1 : x1 - x0;
+    const uint32_t dy = y0 > y1 ? y0 - y1 : y1 - y0;
+    assert(dx + dy == 1);
+  }
+
+  // Against walking the curve's quadrants bit by bit
+
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  for (uint32_t i = 0; i < 100000; ++i) {
+    const uint32_t x = tinygraph_rng_random(rng);
+    const uint32_t y = tinygraph_rng_random(rng);
+
+    uint64_t expected = 0;
+    uint32_t swap = 0, flip = 0;
+
+    for (uint32_t k = 32; k > 0; --k) {
+      uint32_t bx = ((x >> (k - 1)) & 1) ^ flip;
+      uint32_t by = ((y >> (k - 1)) & 1) ^ flip;
+
+      if (swap) {
+        const uint32_t tmp = bx;
+        bx = by;
+        by = tmp;
+      }
+
+      expected = (expected << 2) | ((3 * bx) ^ by);
+
+      if (by == 0) {
+        flip ^= bx;
+        swap ^= 1;
+      }
+    }
+
+    const uint64_t h = tinygraph_hilbert_encode64(x, y);
+    assert(h == expected);
+
+    uint32_t xx, yy;
+    tinygraph_hilbert_decode64(h, &xx, &yy);
+    assert(xx == x && yy == y);
+
+    const uint32_t h32 = tinygraph_hilbert_encode32((uint16_t)x, (uint16_t)y);
+
+    uint16_t x16, y16;
+    tinygraph_hilbert_decode32(h32, &x16, &y16);
+    assert(x16 == (uint16_t)x && y16 == (uint16_t)y);
+  }
+
+  // Reordering along the Hilbert curve
+
+  const uint32_t n = 1000;
+
+  uint32_t *nodes = malloc(n * sizeof(uint32_t));
+  uint16_t *lngs = malloc(n * sizeof(uint16_t));
+  uint16_t *lats = malloc(n * sizeof(uint16_t));
+  assert(nodes && lngs && lats);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    nodes[i] = i;
+    lngs[i] = (uint16_t)tinygraph_rng_random(rng);
+    lats[i] = (uint16_t)tinygraph_rng_random(rng);
+  }
+
+  assert(tinygraph_reorder_curve(nodes, lngs, lats, n, TINYGRAPH_CURVE_HILBERT));
+
+  for (uint32_t i = 1; i < n; ++i) {
+    const uint32_t l = tinygraph_hilbert_encode32(lngs[nodes[i - 1]], lats[nodes[i - 1]]);
+    const uint32_t r = tinygraph_hilbert_encode32(lngs[nodes[i]], lats[nodes[i]]);
+    assert(l <= r);
+  }
+
+  free(lats);
+  free(lngs);
+  free(nodes);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test65(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint32_t n = 100000;
+
+  uint32_t *nodes = malloc(n * sizeof(uint32_t));
+  uint32_t *lngs = malloc(n * sizeof(uint32_t));
+  uint32_t *lats = malloc(n * sizeof(uint32_t));
+  uint64_t *keys = malloc(n * sizeof(uint64_t));
+  uint32_t *values = malloc(n * sizeof(uint32_t));
+  bool *seen = malloc(n * sizeof(bool));
+  assert(nodes && lngs && lats && keys && values && seen);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    lngs[i] = tinygraph_rng_random(rng);
+    lats[i] = i % 2 == 0 ? tinygraph_rng_random(rng) : lats[i - 1] + 1;
+  }
+
+  // The key-value radix sort is stable and ignores the skipped bits
+
+  for (uint32_t i = 0; i < n; ++i) {
+    keys[i] = (uint64_t)tinygraph_rng_random(rng) << 20 | tinygraph_rng_bounded(rng, 1 << 20);
+    values[i] = i;
+  }
+
+  assert(tinygraph_radix_sort_u64_u32(keys, values, n, 24));
+
+  for (uint32_t i = 1; i < n; ++i) {
+    assert(keys[i - 1] >> 24 <= keys[i] >> 24);
+
+    if (keys[i - 1] >> 24 == keys[i] >> 24) {
+      assert(values[i - 1] < values[i]);
+    }
+  }
+
+  const tinygraph_curve curves[2] = {TINYGRAPH_CURVE_ZORDER, TINYGRAPH_CURVE_HILBERT};
+
+  for (uint32_t k = 0; k < 2; ++k) {
+    for (uint32_t coarse = 0; coarse < 2; ++coarse) {
+      for (uint32_t i = 0; i < n; ++i) {
+        nodes[i] = i;
+        seen[i] = false;
+      }
+
+      assert(tinygraph_reorder32(nodes, lngs, lats, n, curves[k], coarse));
+
+      for (uint32_t i = 0; i < n; ++i) {
+        assert(nodes[i] < n);
+        assert(!seen[nodes[i]]);
+        seen[nodes[i]] = true;
+
+        keys[i] = curves[k] == TINYGRAPH_CURVE_ZORDER
+          ? tinygraph_zorder_encode64(lngs[nodes[i]], lats[nodes[i]])
+          : tinygraph_hilbert_encode64(lngs[nodes[i]], lats[nodes[i]]);
+      }
+
+      // The coarse order is sorted by the keys' high bits
+      // and keeps the input order within equal high bits
+
+      const uint32_t skip = coarse ? tinygraph_reorder_coarse_bits(keys, n) : 0;
+
+      assert(!coarse || skip > 0);
+
+      for (uint32_t i = 1; i < n; ++i) {
+        assert(keys[i - 1] >> skip <= keys[i] >> skip);
+
+        if (coarse && keys[i - 1] >> skip == keys[i] >> skip) {
+          assert(nodes[i - 1] < nodes[i]);
+        }
+      }
+    }
+  }
+
+  free(seen);
+  free(values);
+  free(keys);
+  free(lats);
+  free(lngs);
+  free(nodes);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test66(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  // A grid graph with its node ids shuffled, plus a hub
+
+  const uint32_t side = 64;
+  const uint32_t num_nodes = side * side + 1;
+  const uint32_t hub = side * side;
+
+  uint32_t *ids = malloc(num_nodes * sizeof(uint32_t));
+  uint32_t *sources = malloc(6 * num_nodes * sizeof(uint32_t));
+  uint32_t *targets = malloc(6 * num_nodes * sizeof(uint32_t));
+  uint32_t *nodes = malloc(num_nodes * sizeof(uint32_t));
+  bool *seen = malloc(num_nodes * sizeof(bool));
+  assert(ids && sources && targets && nodes && seen);
+
+  for (uint32_t i = 0; i < num_nodes; ++i) {
+    ids[i] = i;
+  }
+
+  for (uint32_t i = side * side - 1; i > 0; --i) {
+    const uint32_t j = tinygraph_rng_bounded(rng, i + 1);
+    const uint32_t tmp = ids[i];
+    ids[i] = ids[j];
+    ids[j] = tmp;
+  }
+
+  uint32_t n = 0;
+
+  for (uint32_t x = 0; x < side; ++x) {
+    for (uint32_t y = 0; y < side; ++y) {
+      const uint32_t v = ids[x * side + y];
+
+      if (x + 1 < side) {
+        sources[n] = v; targets[n] = ids[(x + 1) * side + y]; n += 1;
+        sources[n] = ids[(x + 1) * side + y]; targets[n] = v; n += 1;
+      }
+
+      if (y + 1 < side) {
+        sources[n] = v; targets[n] = ids[x * side + y + 1]; n += 1;
+      }
+
+      if (tinygraph_rng_bounded(rng, 16) == 0) {
+        sources[n] = v; targets[n] = hub; n += 1;
+      }
+    }
+  }
+
+  tinygraph_s graph = tinygraph_construct_from_unsorted_edges(sources, targets, n);
+  assert(graph);
+  assert(tinygraph_get_num_nodes(graph) == num_nodes);
+
+  tinygraph_s compressed = tinygraph_copy_compressed(graph);
+  assert(compressed);
+
+  double shuffled;
+  const uint32_t shuffled_wasted = tinygraph_bytes_wasted(graph, &shuffled);
+
+  double shuffled_compressed;
+  assert(tinygraph_bytes_wasted(compressed, &shuffled_compressed) == 0);
+  assert(shuffled == shuffled_compressed);
+
+  tinygraph_const_s graphs[2] = {graph, compressed};
+
+  for (uint32_t k = 0; k < 2; ++k) {
+    for (uint32_t order = 0; order < 3; ++order) {
+      bool ok = false;
+
+      switch (order) {
+        case 0: ok = tinygraph_reorder_degree(graphs[k], nodes); break;
+        case 1: ok = tinygraph_reorder_rcm(graphs[k], nodes); break;
+        case 2: ok = tinygraph_reorder_gorder(graphs[k], nodes, 5); break;
+      }
+
+      assert(ok);
+
+      for (uint32_t i = 0; i < num_nodes; ++i) {
+        seen[i] = false;
+      }
+
+      for (uint32_t i = 0; i < num_nodes; ++i) {
+        assert(nodes[i] < num_nodes);
+        assert(!seen[nodes[i]]);
+        seen[nodes[i]] = true;
+      }
+
+      tinygraph_s permuted = tinygraph_permute(graphs[k], nodes, NULL, NULL);
+      assert(permuted);
+
+      double log_gap;
+      const uint32_t wasted = tinygraph_bytes_wasted(permuted, &log_gap);
+
+      if (order == 0) {
+        assert(nodes[0] == hub);
+      } else {
+        // Neighbors end up close to each other
+
+        assert(log_gap + 2 < shuffled);
+        assert(wasted > shuffled_wasted);
+      }
+
+      tinygraph_destruct(permuted);
+    }
+  }
+
+  // A hub 0 with leaves 1..len having a few tail nodes each;
+  // RCM visits the hub's leaves by ascending degree and id,
+  // for frontiers both small and large
+
+  const uint32_t star_lens[2] = {20, 100};
+
+  for (uint32_t k = 0; k < 2; ++k) {
+    const uint32_t len = star_lens[k];
+
+    uint32_t star_sources[512];
+    uint32_t star_targets[512];
+    uint32_t star_degrees[128];
+
+    uint32_t m = 0;
+    uint32_t tail = len + 1;
+
+    for (uint32_t leaf = 1; leaf <= len; ++leaf) {
+      star_sources[m] = 0; star_targets[m] = leaf; m += 1;
+      star_degrees[leaf] = 1;
+
+      for (uint32_t i = 0; i < (leaf * 7) % 5; ++i) {
+        star_sources[m] = leaf; star_targets[m] = tail++; m += 1;
+        star_degrees[leaf] += 1;
+      }
+    }
+
+    tinygraph_s star = tinygraph_construct_from_unsorted_edges(star_sources, star_targets, m);
+    assert(star);
+
+    uint32_t star_nodes[512];
+    assert(tinygraph_reorder_rcm(star, star_nodes));
+
+    // In the search order, that is reversed, the first leaf
+    // may be the search's start; the others follow sorted
+
+    uint32_t prev = 0;
+    uint32_t num_leaves = 0;
+
+    for (uint32_t i = tail; i > 0; --i) {
+      const uint32_t v = star_nodes[i - 1];
+
+      if (v == 0 || v > len) {
+        continue;
+      }
+
+      if (num_leaves > 1) {
+        assert(star_degrees[prev] < star_degrees[v]
+            || (star_degrees[prev] == star_degrees[v] && prev < v));
+      }
+
+      prev = v;
+      num_leaves += 1;
+    }
+
+    assert(num_leaves == len);
+
+    tinygraph_destruct(star);
+  }
+
+  tinygraph_s empty = tinygraph_construct_empty();
+  assert(empty);
+
+  assert(tinygraph_reorder_degree(empty, NULL));
+  assert(tinygraph_reorder_rcm(empty, NULL));
+  assert(tinygraph_reorder_gorder(empty, NULL, 5));
+
+  tinygraph_destruct(empty);
+  tinygraph_destruct(compressed);
+  tinygraph_destruct(graph);
+
+  free(seen);
+  free(nodes);
+  free(targets);
+  free(sources);
+  free(ids);
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test67(void) {
+  {
+    // Components {0, 1, 2}, {3, 4} and {5}
+    const uint32_t sources[] = {0, 1, 2, 2, 3, 4};
+    const uint32_t targets[] = {1, 2, 0, 3, 4, 3};
+
+    tinygraph_s graph = tinygraph_construct_from_sorted_edges(sources, targets, 6);
+    assert(graph);
+
+    tinygraph_s single = tinygraph_construct_from_sorted_edges((uint32_t[]){0, 5}, (uint32_t[]){0, 5}, 2);
+    assert(single);
+
+    uint32_t labels[6];
+    uint32_t num_components;
+
+    assert(tinygraph_scc(single, labels, &num_components));
+    assert(num_components == 6);
+
+    assert(tinygraph_scc(graph, labels, &num_components));
+    assert(num_components == 2);
+    assert(labels[0] == labels[1] && labels[1] == labels[2]);
+    assert(labels[3] == labels[4]);
+    assert(labels[3] < labels[0]);
+
+    uint32_t nodes[5];
+
+    tinygraph_s largest = tinygraph_copy_largest_scc(graph, nodes);
+    assert(largest);
+    assert(tinygraph_get_num_nodes(largest) == 3);
+    assert(tinygraph_get_num_edges(largest) == 3);
+    assert(nodes[0] == 0 && nodes[1] == 1 && nodes[2] == 2);
+    assert(tinygraph_has_edge_from_to(largest, 2, 0));
+
+    tinygraph_destruct(largest);
+    tinygraph_destruct(single);
+    tinygraph_destruct(graph);
+  }
+
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  {
+    // A cycle and a path far deeper than the call stack allows
+
+    const uint32_t n = 1000000;
+
+    uint32_t *sources = malloc(n * sizeof(uint32_t));
+    uint32_t *targets = malloc(n * sizeof(uint32_t));
+    uint32_t *labels = malloc(n * sizeof(uint32_t));
+    assert(sources && targets && labels);
+
+    for (uint32_t i = 0; i < n; ++i) {
+      sources[i] = i;
+      targets[i] = (i + 1) % n;
+    }
+
+    tinygraph_s cycle = tinygraph_construct_from_sorted_edges(sources, targets, n);
+    assert(cycle);
+
+    tinygraph_s path = tinygraph_construct_from_sorted_edges(sources, targets, n - 1);
+    assert(path);
+
+    uint32_t num_components;
+
+    assert(tinygraph_scc(cycle, labels, &num_components));
+    assert(num_components == 1);
+
+    assert(tinygraph_scc(path, labels, &num_components));
+    assert(num_components == n);
+
+    for (uint32_t i = 0; i < n; ++i) {
+      assert(labels[i] == n - 1 - i);
+    }
+
+    // Compressed graphs keep a neighbors iterator per call
+
+    tinygraph_s compressed = tinygraph_copy_compressed(path);
+    assert(compressed);
+
+    assert(tinygraph_scc(compressed, labels, &num_components));
+    assert(num_components == n);
+
+    for (uint32_t i = 0; i < n; ++i) {
+      assert(labels[i] == n - 1 - i);
+    }
+
+    tinygraph_destruct(compressed);
+    tinygraph_destruct(path);
+    tinygraph_destruct(cycle);
+
+    free(labels);
+    free(targets);
+    free(sources);
+  }
+
+  {
+    // Against mutual reachability on a random graph
+
+    const uint32_t num_nodes = 300;
+    const uint32_t n = 400;
+
+    uint32_t *sources = malloc(n * sizeof(uint32_t));
+    uint32_t *targets = malloc(n * sizeof(uint32_t));
+    uint32_t *labels = malloc(num_nodes * sizeof(uint32_t));
+    uint32_t *nodes = malloc(num_nodes * sizeof(uint32_t));
+    uint16_t *lngs = malloc(num_nodes * sizeof(uint16_t));
+    uint16_t *lats = malloc(num_nodes * sizeof(uint16_t));
+    bool *reachable = calloc(num_nodes * num_nodes, sizeof(bool));
+    assert(sources && targets && labels && nodes && lngs && lats && reachable);
+
+    for (uint32_t i = 0; i < n; ++i) {
+      sources[i] = i == 0 ? num_nodes - 1 : tinygraph_rng_bounded(rng, num_nodes);
+      targets[i] = tinygraph_rng_bounded(rng, num_nodes);
+    }
+
+    for (uint32_t v = 0; v < num_nodes; ++v) {
+      lngs[v] = (uint16_t)tinygraph_rng_random(rng);
+      lats[v] = (uint16_t)tinygraph_rng_random(rng);
+    }
+
+    tinygraph_s graph = tinygraph_construct_from_unsorted_edges(sources, targets, n);
+    assert(graph);
+    assert(tinygraph_get_num_nodes(graph) == num_nodes);
+
+    tinygraph_s compressed = tinygraph_copy_compressed(graph);
+    assert(compressed);
+
+    for (uint32_t s = 0; s < num_nodes; ++s) {
+      reachable[s * num_nodes + s] = true;
+
+      for (bool changed = true; changed;) {
+        changed = false;
+
+        for (uint32_t i = 0; i < n; ++i) {
+          if (reachable[s * num_nodes + sources[i]] && !reachable[s * num_nodes + targets[i]]) {
+            reachable[s * num_nodes + targets[i]] = true;
+            changed = true;
+          }
+        }
+      }
+    }
+
+    tinygraph_const_s graphs[2] = {graph, compressed};
+
+    for (uint32_t k = 0; k < 2; ++k) {
+      uint32_t num_components;
+      assert(tinygraph_scc(graphs[k], labels, &num_components));
+
+      for (uint32_t u = 0; u < num_nodes; ++u) {
+        assert(labels[u] < num_components);
+
+        for (uint32_t v = 0; v < num_nodes; ++v) {
+          const bool mutual = reachable[u * num_nodes + v] && reachable[v * num_nodes + u];
+          assert(mutual == (labels[u] == labels[v]));
+        }
+      }
+
+      for (uint32_t i = 0; i < n; ++i) {
+        assert(labels[sources[i]] >= labels[targets[i]]);
+      }
+
+      // Components contiguous, largest first, spatially inside
+
+      assert(tinygraph_reorder_scc(graphs[k], nodes, lngs, lats, TINYGRAPH_CURVE_ZORDER));
+
+      uint32_t *sizes = calloc(num_components, sizeof(uint32_t));
+      bool *done = calloc(num_components, sizeof(bool));
+      assert(sizes && done);
+
+      for (uint32_t v = 0; v < num_nodes; ++v) {
+        sizes[labels[v]] += 1;
+      }
+
+      for (uint32_t i = 0; i < num_nodes; ++i) {
+        const uint32_t c = labels[nodes[i]];
+
+        if (i > 0 && labels[nodes[i - 1]] == c) {
+          assert(tinygraph_zorder_encode32(lngs[nodes[i - 1]], lats[nodes[i - 1]])
+              <= tinygraph_zorder_encode32(lngs[nodes[i]], lats[nodes[i]]));
+        } else {
+          assert(!done[c]);
+          done[c] = true;
+
+          assert(i == 0 || sizes[labels[nodes[i - 1]]] >= sizes[c]);
+        }
+      }
+
+      const uint32_t largest_size = sizes[labels[nodes[0]]];
+
+      free(done);
+      free(sizes);
+
+      tinygraph_s largest = tinygraph_copy_largest_scc(graphs[k], nodes);
+      assert(largest);
+      assert(tinygraph_get_num_nodes(largest) == largest_size);
+
+      for (uint32_t u = 0; u < largest_size; ++u) {
+        assert(u == 0 || nodes[u - 1] < nodes[u]);
+
+        for (uint32_t v = 0; v < largest_size; ++v) {
+          assert(tinygraph_has_edge_from_to(largest, u, v) == tinygraph_has_edge_from_to(graphs[k], nodes[u], nodes[v]));
+        }
+      }
+
+      tinygraph_destruct(largest);
+    }
+
+    tinygraph_destruct(compressed);
+    tinygraph_destruct(graph);
+
+    free(reachable);
+    free(lats);
+    free(lngs);
+    free(nodes);
+    free(labels);
+    free(targets);
+    free(sources);
+  }
+
+  tinygraph_rng_destruct(rng);
+}
+
+
+void test68(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  // The monotone queues have to pop in the binary heap's
+  // order for pushes within the window after the last pop;
+  // values are the priorities so that ties don't matter
+
+  const uint32_t windows[] = {0, 1, 100, 65535};
+
+  for (uint32_t w = 0; w < sizeof(windows) / sizeof(windows[0]); ++w) {
+    const uint32_t window = windows[w];
+
+    tinygraph_heap_s heap = tinygraph_heap_construct();
+    tinygraph_radix_heap_s radix_heap = tinygraph_radix_heap_construct();
+    tinygraph_bucket_queue_s bucket_queue = tinygraph_bucket_queue_construct(window);
+    assert(heap);
+    assert(radix_heap);
+    assert(bucket_queue);
+
+    // The priorities wrap around the bucket queue's ring
+    uint32_t last = 0;
+
+    for (uint32_t i = 0; i < 10000; ++i) {
+      const uint32_t pushes = tinygraph_rng_bounded(rng, 4);
+
+      for (uint32_t j = 0; j < pushes; ++j) {
+        const uint32_t priority = last + tinygraph_rng_bounded(rng, window + 1);
+
+        assert(tinygraph_heap_push(heap, priority, priority));
+        assert(tinygraph_radix_heap_push(radix_heap, priority, priority));
+        assert(tinygraph_bucket_queue_push(bucket_queue, priority, priority));
+      }
+
+      assert(tinygraph_heap_get_size(heap) == tinygraph_radix_heap_get_size(radix_heap));
+      assert(tinygraph_heap_get_size(heap) == tinygraph_bucket_queue_get_size(bucket_queue));
+
+      if (tinygraph_heap_is_empty(heap)) {
+        assert(tinygraph_radix_heap_is_empty(radix_heap));
+        assert(tinygraph_bucket_queue_is_empty(bucket_queue));
+        continue;
+      }
+
+      const uint32_t expected = tinygraph_heap_pop(heap);
+
+      uint32_t value;
+      assert(tinygraph_radix_heap_pop(radix_heap, &value));
+      assert(value == expected);
+
+      assert(tinygraph_bucket_queue_pop(bucket_queue) == expected);
+
+      assert(expected >= last);
+      last = expected;
+    }
+
+    tinygraph_heap_clear(heap);
+    tinygraph_radix_heap_clear(radix_heap);
+    tinygraph_bucket_queue_clear(bucket_queue);
+
+    assert(tinygraph_radix_heap_is_empty(radix_heap));
+    assert(tinygraph_bucket_queue_is_empty(bucket_queue));
+
+    // After clearing the queues start over at priority zero
+    uint32_t value;
+
+    assert(tinygraph_radix_heap_push(radix_heap, 8, window));
+    assert(tinygraph_radix_heap_push(radix_heap, 7, 0));
+    assert(tinygraph_radix_heap_pop(radix_heap, &value));
+    assert(value == 7 || window == 0);
+
+    assert(tinygraph_bucket_queue_push(bucket_queue, 8, window));
+    assert(tinygraph_bucket_queue_push(bucket_queue, 7, 0));
+    value = tinygraph_bucket_queue_pop(bucket_queue);
+    assert(value == 7 || window == 0);
+
+    tinygraph_bucket_queue_destruct(bucket_queue);
+    tinygraph_radix_heap_destruct(radix_heap);
+    tinygraph_heap_destruct(heap);
+  }
+
+  // Shortest paths have the same distances with all queues,
+  // for weights with zeros and up to the largest weight
+
+  const uint32_t n = 5000;
+
+  tinygraph_s graph = construct_embedded_graph(rng, n, 3);
+  assert(graph);
+
+  const uint32_t m = tinygraph_get_num_edges(graph);
+
+  uint16_t* weights = malloc(m * sizeof(uint16_t));
+  assert(weights);
+
+  const tinygraph_dijkstra_queue queues[] = {
+    TINYGRAPH_DIJKSTRA_QUEUE_BINARY_HEAP,
+    TINYGRAPH_DIJKSTRA_QUEUE_RADIX_HEAP,
+    TINYGRAPH_DIJKSTRA_QUEUE_BUCKET_QUEUE,
+    TINYGRAPH_DIJKSTRA_QUEUE_INDEXED_HEAP,
+  };
+
+  const uint32_t num_queues = sizeof(queues) / sizeof(queues[0]);
+
+  const uint32_t bounds[] = {3, 1000, UINT16_MAX + 1};
+
+  for (uint32_t b = 0; b < sizeof(bounds) / sizeof(bounds[0]); ++b) {
+    for (uint32_t i = 0; i < m; ++i) {
+      weights[i] = tinygraph_rng_bounded(rng, bounds[b]);
+    }
+
+    tinygraph_dijkstra_s ctxs[sizeof(queues) / sizeof(queues[0])];
+
+    for (uint32_t q = 0; q < num_queues; ++q) {
+      ctxs[q] = tinygraph_dijkstra_construct_with_queue(graph, weights, queues[q]);
+      assert(ctxs[q]);
+    }
+
+    for (uint32_t i = 0; i < 20; ++i) {
+      // Every other query re-uses the source node
+      // and therefore the cached search state
+      const uint32_t s = i % 2 == 0 ? tinygraph_rng_bounded(rng, n) : i;
+      const uint32_t t = tinygraph_rng_bounded(rng, n);
+
+      const bool ok = tinygraph_dijkstra_shortest_path(ctxs[0], s, t);
+
+      for (uint32_t q = 1; q < num_queues; ++q) {
+        assert(ok == tinygraph_dijkstra_shortest_path(ctxs[q], s, t));
+      }
+
+      if (!ok) {
+        continue;
+      }
+
+      const uint32_t dist = tinygraph_dijkstra_get_distance(ctxs[0]);
+
+      for (uint32_t q = 1; q < num_queues; ++q) {
+        assert(tinygraph_dijkstra_get_distance(ctxs[q]) == dist);
+
+        const uint32_t *first, *last;
+        assert(tinygraph_dijkstra_get_path(ctxs[q], &first, &last));
+
+        // The path might differ for ties, not its length
+        uint32_t length = 0;
+        uint32_t u = s;
+
+        if (first != last) {
+          assert(*first == s);
+          ++first;
+        }
+
+        for (; first != last; ++first) {
+          uint32_t best = UINT32_MAX;
+          uint32_t it, end;
+
+          tinygraph_get_out_edges(graph, u, &it, &end);
+
+          for (; it != end; ++it) {
+            if (tinygraph_get_edge_target(graph, it) == *first && weights[it] < best) {
+              best = weights[it];
+            }
+          }
+
+          assert(best != UINT32_MAX);
+
+          length += best;
+          u = *first;
+        }
+
+        assert(u == t);
+        assert(length == dist);
+      }
+    }
+
+    for (uint32_t q = 0; q < num_queues; ++q) {
+      tinygraph_dijkstra_destruct(ctxs[q]);
+    }
+  }
+
+  free(weights);
+  tinygraph_destruct(graph);
+  tinygraph_rng_destruct(rng);
+}
+
+void test69(void) {
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint32_t n = 1000;
+
+  tinygraph_indexed_heap_s heap = tinygraph_indexed_heap_construct(n);
+  assert(heap);
+  assert(tinygraph_indexed_heap_is_empty(heap));
+
+  // Keep track of the priorities in the heap to
+  // check pops against the smallest priority
+
+  uint32_t *priorities = malloc(n * sizeof(uint32_t));
+  assert(priorities);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    priorities[i] = UINT32_MAX;
+  }
+
+  for (uint32_t round = 0; round < 2; ++round) {
+    uint32_t size = 0;
+
+    for (uint32_t i = 0; i < 20000; ++i) {
+      const uint32_t v = tinygraph_rng_bounded(rng, n);
+      const uint32_t priority = tinygraph_rng_bounded(rng, 1000);
+
+      if (!tinygraph_indexed_heap_contains(heap, v)) {
+        assert(tinygraph_indexed_heap_push(heap, v, priority));
+        priorities[v] = priority;
+        size += 1;
+      } else if (priority < tinygraph_indexed_heap_get_priority(heap, v)) {
+        tinygraph_indexed_heap_decrease(heap, v, priority);
+        priorities[v] = priority;
+      }
+
+      assert(tinygraph_indexed_heap_get_priority(heap, v) == priorities[v]);
+      assert(tinygraph_indexed_heap_get_size(heap) == size);
+
+      if (tinygraph_rng_bounded(rng, 3) == 0) {
+        uint32_t min = UINT32_MAX;
+
+        for (uint32_t j = 0; j < n; ++j) {
+          min = priorities[j] < min ? priorities[j] : min;
+        }
+
+        assert(tinygraph_indexed_heap_get_min_priority(heap) == min);
+
+        const uint32_t u = tinygraph_indexed_heap_pop(heap);
+        assert(priorities[u] == min);
+        assert(!tinygraph_indexed_heap_contains(heap, u));
+
+        priorities[u] = UINT32_MAX;
+        size -= 1;
+      }
+    }
+
+    // Bounded by the number of values, not pushes
+    assert(tinygraph_indexed_heap_get_size(heap) <= n);
+
+    if (round == 0) {
+      tinygraph_indexed_heap_clear(heap);
+
+      for (uint32_t i = 0; i < n; ++i) {
+        assert(!tinygraph_indexed_heap_contains(heap, i));
+        priorities[i] = UINT32_MAX;
+      }
+    }
+  }
+
+  uint32_t last = 0;
+
+  while (!tinygraph_indexed_heap_is_empty(heap)) {
+    const uint32_t priority = tinygraph_indexed_heap_get_min_priority(heap);
+    assert(priority >= last);
+    last = priority;
+
+    const uint32_t u = tinygraph_indexed_heap_pop(heap);
+    assert(priorities[u] == priority);
+  }
+
+  free(priorities);
+  tinygraph_indexed_heap_destruct(heap);
+  tinygraph_rng_destruct(rng);
+}
+
+void test70(void) {
+  // A path 0 -> 1 -> 2 -> 3 with a shortcut 0 -> 3
+
+  const uint32_t sources[4] = {0, 0, 1, 2};
+  const uint32_t targets[4] = {1, 3, 2, 3};
+  const uint16_t weights[4] = {1, 10, 1, 1};
+
+  tinygraph_s path = tinygraph_construct_from_sorted_edges(sources, targets, 4);
+  assert(path);
+
+  tinygraph_dijkstra_s pctx = tinygraph_dijkstra_construct(path, weights);
+  assert(pctx);
+
+  // A search from a new source with s == t must not
+  // leave the previous source's search state behind
+
+  assert(tinygraph_dijkstra_shortest_path(pctx, 0, 3));
+  assert(tinygraph_dijkstra_get_distance(pctx) == 3);
+  assert(tinygraph_dijkstra_shortest_path(pctx, 1, 1));
+  assert(tinygraph_dijkstra_get_distance(pctx) == 0);
+  assert(tinygraph_dijkstra_shortest_path(pctx, 1, 3));
+  assert(tinygraph_dijkstra_get_distance(pctx) == 2);
+  assert(!tinygraph_dijkstra_shortest_path(pctx, 1, 0));
+  assert(tinygraph_dijkstra_shortest_path(pctx, 2, 2));
+  assert(!tinygraph_dijkstra_shortest_path(pctx, 2, 1));
+
+  tinygraph_dijkstra_destruct(pctx);
+  tinygraph_destruct(path);
+
+  // Local and far searches mixed, so that clearing resets
+  // the touched nodes only as well as the whole context;
+  // each search has to match a search from a new context
+
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint32_t n = 5000;
+
+  tinygraph_s graph = construct_embedded_graph(rng, n, 3);
+  assert(graph);
+
+  const uint32_t m = tinygraph_get_num_edges(graph);
+
+  uint16_t* costs = malloc(m * sizeof(uint16_t));
+  assert(costs);
+
+  for (uint32_t i = 0; i < m; ++i) {
+    costs[i] = tinygraph_rng_bounded(rng, 1000);
+  }
+
+  const tinygraph_dijkstra_queue queues[] = {
+    TINYGRAPH_DIJKSTRA_QUEUE_BINARY_HEAP,
+    TINYGRAPH_DIJKSTRA_QUEUE_BUCKET_QUEUE,
+    TINYGRAPH_DIJKSTRA_QUEUE_INDEXED_HEAP,
+  };
+
+  for (uint32_t q = 0; q < sizeof(queues) / sizeof(queues[0]); ++q) {
+    tinygraph_dijkstra_s ctx = tinygraph_dijkstra_construct_with_queue(graph, costs, queues[q]);
+    assert(ctx);
+
+    for (uint32_t i = 0; i < 50; ++i) {
+      const uint32_t s = tinygraph_rng_bounded(rng, n);
+
+      // Node ids are close to their neighbors' ids
+      const uint32_t t = i % 5 == 0
+        ? tinygraph_rng_bounded(rng, n)
+        : (s + tinygraph_rng_bounded(rng, 8)) % n;
+
+      tinygraph_dijkstra_s fresh = tinygraph_dijkstra_construct_with_queue(graph, costs, queues[q]);
+      assert(fresh);
+
+      const bool ok = tinygraph_dijkstra_shortest_path(fresh, s, t);
+      assert(ok == tinygraph_dijkstra_shortest_path(ctx, s, t));
+
+      if (ok) {
+        assert(tinygraph_dijkstra_get_distance(ctx) == tinygraph_dijkstra_get_distance(fresh));
+      }
+
+      tinygraph_dijkstra_destruct(fresh);
+    }
+
+    tinygraph_dijkstra_destruct(ctx);
+  }
+
+  free(costs);
+  tinygraph_destruct(graph);
+  tinygraph_rng_destruct(rng);
+}
+
+void test71(void) {
+  // A path 0 -> 1 -> 2 -> 3 with a shortcut 0 -> 3
+  // and an edge 3 -> 4 to a node with no out edges
+
+  const uint32_t sources[5] = {0, 0, 1, 2, 3};
+  const uint32_t targets[5] = {1, 3, 2, 3, 4};
+  const uint16_t weights[5] = {1, 10, 1, 1, 5};
+
+  tinygraph_s path = tinygraph_construct_from_sorted_edges(sources, targets, 5);
+  assert(path);
+
+  tinygraph_bidirectional_s pbidir = tinygraph_bidirectional_construct(path);
+  assert(pbidir);
+
+  tinygraph_dijkstra_s pctx = tinygraph_dijkstra_construct_bidirectional(pbidir, weights,
+      TINYGRAPH_DIJKSTRA_QUEUE_BINARY_HEAP);
+  assert(pctx);
+
+  const uint32_t *first, *last;
+
+  assert(tinygraph_dijkstra_shortest_path(pctx, 0, 4));
+  assert(tinygraph_dijkstra_get_distance(pctx) == 8);
+  assert(tinygraph_dijkstra_get_path(pctx, &first, &last));
+  assert(last - first == 5);
+
+  for (uint32_t i = 0; i < 5; ++i) {
+    assert(first[i] == i);
+  }
+
+  assert(tinygraph_dijkstra_shortest_path(pctx, 0, 4));
+  assert(tinygraph_dijkstra_get_distance(pctx) == 8);
+
+  assert(tinygraph_dijkstra_shortest_path(pctx, 1, 3));
+  assert(tinygraph_dijkstra_get_distance(pctx) == 2);
+  assert(tinygraph_dijkstra_get_path(pctx, &first, &last));
+  assert(last - first == 3);
+  assert(first[0] == 1 && first[1] == 2 && first[2] == 3);
+
+  assert(tinygraph_dijkstra_shortest_path(pctx, 2, 2));
+  assert(tinygraph_dijkstra_get_distance(pctx) == 0);
+  assert(tinygraph_dijkstra_get_path(pctx, &first, &last));
+  assert(first == last);
+
+  assert(!tinygraph_dijkstra_shortest_path(pctx, 4, 0));
+  assert(!tinygraph_dijkstra_shortest_path(pctx, 3, 1));
+
+  assert(tinygraph_dijkstra_shortest_path(pctx, 0, 1));
+  assert(tinygraph_dijkstra_get_distance(pctx) == 1);
+
+  tinygraph_dijkstra_destruct(pctx);
+  tinygraph_bidirectional_destruct(pbidir);
+  tinygraph_destruct(path);
+
+  // Bidirectional searches have to match the single
+  // search's distances and find paths as short
+
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint32_t n = 5000;
+
+  tinygraph_s graph = construct_embedded_graph(rng, n, 3);
+  assert(graph);
+
+  tinygraph_bidirectional_s bidir = tinygraph_bidirectional_construct(graph);
+  assert(bidir);
+
+  const uint32_t m = tinygraph_get_num_edges(graph);
+
+  uint16_t* costs = malloc(m * sizeof(uint16_t));
+  assert(costs);
+
+  for (uint32_t i = 0; i < m; ++i) {
+    costs[i] = tinygraph_rng_bounded(rng, 1000);
+  }
+
+  tinygraph_dijkstra_s ref = tinygraph_dijkstra_construct(graph, costs);
+  assert(ref);
+
+  const tinygraph_dijkstra_queue queues[] = {
+    TINYGRAPH_DIJKSTRA_QUEUE_BINARY_HEAP,
+    TINYGRAPH_DIJKSTRA_QUEUE_RADIX_HEAP,
+    TINYGRAPH_DIJKSTRA_QUEUE_BUCKET_QUEUE,
+    TINYGRAPH_DIJKSTRA_QUEUE_INDEXED_HEAP,
+  };
+
+  for (uint32_t q = 0; q < sizeof(queues) / sizeof(queues[0]); ++q) {
+    tinygraph_dijkstra_s ctx = tinygraph_dijkstra_construct_bidirectional(bidir, costs, queues[q]);
+    assert(ctx);
+
+    for (uint32_t i = 0; i < 50; ++i) {
+      const uint32_t s = tinygraph_rng_bounded(rng, n);
+
+      // Node ids are close to their neighbors' ids
+      const uint32_t t = i % 5 == 0
+        ? (s + tinygraph_rng_bounded(rng, 8)) % n
+        : tinygraph_rng_bounded(rng, n);
+
+      const bool ok = tinygraph_dijkstra_shortest_path(ref, s, t);
+      assert(ok == tinygraph_dijkstra_shortest_path(ctx, s, t));
+
+      if (!ok) {
+        continue;
+      }
+
+      const uint32_t dist = tinygraph_dijkstra_get_distance(ctx);
+      assert(dist == tinygraph_dijkstra_get_distance(ref));
+
+      assert(tinygraph_dijkstra_get_path(ctx, &first, &last));
+
+      if (s == t) {
+        assert(first == last);
+        continue;
+      }
+
+      assert(last - first >= 2);
+      assert(first[0] == s);
+      assert(last[-1] == t);
+
+      // The path's edges have to add up to the distance
+
+      uint32_t sum = 0;
+
+      for (const uint32_t *it = first; it + 1 < last; ++it) {
+        uint32_t efirst, elast;
+        tinygraph_get_out_edges(graph, it[0], &efirst, &elast);
+
+        uint32_t best = UINT32_MAX;
+
+        for (uint32_t e = efirst; e < elast; ++e) {
+          if (tinygraph_get_edge_target(graph, e) == it[1] && costs[e] < best) {
+            best = costs[e];
+          }
+        }
+
+        assert(best != UINT32_MAX);
+
+        sum += best;
+      }
+
+      assert(sum == dist);
+    }
+
+    tinygraph_dijkstra_destruct(ctx);
+  }
+
+  tinygraph_dijkstra_destruct(ref);
+  free(costs);
+  tinygraph_bidirectional_destruct(bidir);
+  tinygraph_destruct(graph);
+  tinygraph_rng_destruct(rng);
+}
+
+void test72(void) {
+  // A grid with jittered node coordinates and weights at
+  // least the scaled straight line length of their edges
+
+  tinygraph_rng_s rng = tinygraph_rng_construct();
+  assert(rng);
+
+  const uint32_t side = 40;
+  const uint32_t n = side * side;
+
+  uint32_t *lngs = malloc(n * sizeof(uint32_t));
+  uint32_t *lats = malloc(n * sizeof(uint32_t));
+  assert(lngs && lats);
+
+  for (uint32_t x = 0; x < side; ++x) {
+    for (uint32_t y = 0; y < side; ++y) {
+      lngs[x * side + y] = x * 1000 + tinygraph_rng_bounded(rng, 500);
+      lats[x * side + y] = y * 1000 + tinygraph_rng_bounded(rng, 500);
+    }
+  }
+
+  uint32_t *sources = malloc(4 * n * sizeof(uint32_t));
+  uint32_t *targets = malloc(4 * n * sizeof(uint32_t));
+  assert(sources && targets);
+
+  uint32_t m = 0;
+
+  for (uint32_t x = 0; x < side; ++x) {
+    for (uint32_t y = 0; y < side; ++y) {
+      const uint32_t v = x * side + y;
+
+      if (x + 1 < side) {
+        sources[m] = v; targets[m] = v + side; m += 1;
+        sources[m] = v + side; targets[m] = v; m += 1;
+      }
+
+      if (y + 1 < side) {
+        sources[m] = v; targets[m] = v + 1; m += 1;
+        sources[m] = v + 1; targets[m] = v; m += 1;
+      }
+    }
+  }
+
+  tinygraph_s graph = tinygraph_construct_from_unsorted_edges(sources, targets, m);
+  assert(graph);
+
+  free(sources);
+  free(targets);
+
+  const double scale = 0.01;
+
+  uint16_t* costs = malloc(m * sizeof(uint16_t));
+  assert(costs);
+
+  for (uint32_t v = 0; v < n; ++v) {
+    uint32_t first, last;
+    tinygraph_get_out_edges(graph, v, &first, &last);
+
+    for (uint32_t e = first; e < last; ++e) {
+      const uint32_t w = tinygraph_get_edge_target(graph, e);
+
+      const double dx = (double)lngs[v] - (double)lngs[w];
+      const double dy = (double)lats[v] - (double)lats[w];
+
+      costs[e] = ceil(scale * sqrt(dx * dx + dy * dy)) + tinygraph_rng_bounded(rng, 20);
+    }
+  }
+
+  tinygraph_dijkstra_s ref = tinygraph_dijkstra_construct(graph, costs);
+  assert(ref);
+
+  const tinygraph_dijkstra_queue queues[] = {
+    TINYGRAPH_DIJKSTRA_QUEUE_BINARY_HEAP,
+    TINYGRAPH_DIJKSTRA_QUEUE_RADIX_HEAP,
+    TINYGRAPH_DIJKSTRA_QUEUE_BUCKET_QUEUE,
+    TINYGRAPH_DIJKSTRA_QUEUE_INDEXED_HEAP,
+  };
+
+  for (uint32_t q = 0; q < sizeof(queues) / sizeof(queues[0]); ++q) {
+    tinygraph_dijkstra_s ctx = tinygraph_dijkstra_construct_astar(graph, costs, lngs, lats, scale, queues[q]);
+    assert(ctx);
+
+    uint32_t s = 0;
+
+    for (uint32_t i = 0; i < 100; ++i) {
+      // Re-use the source node for some of the
+      // queries, the same target for a few
+
+      if (i % 4 == 0) {
+        s = tinygraph_rng_bounded(rng, n);
+      }
+
+      const uint32_t t = i % 7 == 0 ? s : tinygraph_rng_bounded(rng, n);
+
+      assert(tinygraph_dijkstra_shortest_path(ref, s, t));
+      assert(tinygraph_dijkstra_shortest_path(ctx, s, t));
+
+      const uint32_t dist = tinygraph_dijkstra_get_distance(ctx);
+      assert(dist == tinygraph_dijkstra_get_distance(ref));
+
+      assert(tinygraph_dijkstra_shortest_path(ctx, s, t));
+      assert(tinygraph_dijkstra_get_distance(ctx) == dist);
+
+      const uint32_t *first, *last;
+      assert(tinygraph_dijkstra_get_path(ctx, &first, &last));
+
+      if (s == t) {
+        assert(first == last);
+        continue;
+      }
+
+      assert(first[0] == s);
+      assert(last[-1] == t);
+
+      uint32_t sum = 0;
+
+      for (const uint32_t *it = first; it + 1 < last; ++it) {
+        uint32_t efirst, elast;
+        tinygraph_get_out_edges(graph, it[0], &efirst, &elast);
+
+        uint32_t e = efirst;
+
+        while (e < elast && tinygraph_get_edge_target(graph, e) != it[1]) {
+          e += 1;
+        }
+
+        assert(e < elast);
+
+        sum += costs[e];
+      }
+
+      assert(sum == dist);
+    }
+
+    tinygraph_dijkstra_destruct(ctx);
+  }
+
+  tinygraph_dijkstra_destruct(ref);
+  free(costs);
+  free(lngs);
+  free(lats);
+  tinygraph_destruct(graph);
+
+  // Coordinates breaking the lower bound: the edges are far
+  // shorter than their straight line, the potential drops by
+  // up to 500 along an edge of weight 1. The queues have to
+  // stay intact, and the path found has to be a real path.
+
+  const uint32_t chain_sources[5] = {0, 0, 1, 2, 3};
+  const uint32_t chain_targets[5] = {1, 4, 2, 3, 4};
+  const uint16_t chain_weights[5] = {1, 2000, 1, 1, 1};
+
+  const uint32_t chain_lngs[5] = {0, 0, 500, 500, 1000};
+  const uint32_t chain_lats[5] = {0, 0, 0, 0, 0};
+
+  tinygraph_s chain = tinygraph_construct_from_sorted_edges(chain_sources, chain_targets, 5);
+  assert(chain);
+
+  for (uint32_t q = 0; q < sizeof(queues) / sizeof(queues[0]); ++q) {
+    tinygraph_dijkstra_s ctx = tinygraph_dijkstra_construct_astar(chain, chain_weights,
+        chain_lngs, chain_lats, 1.0, queues[q]);
+    assert(ctx);
+
+    for (uint32_t t = 0; t < 5; ++t) {
+      assert(tinygraph_dijkstra_shortest_path(ctx, 0, t));
+
+      const uint32_t dist = tinygraph_dijkstra_get_distance(ctx);
+      assert(t == 4 ? (dist == 4 || dist == 2000) : dist == t);
+
+      const uint32_t *first, *last;
+      assert(tinygraph_dijkstra_get_path(ctx, &first, &last));
+      assert(t == 0 || (first[0] == 0 && last[-1] == t));
+    }
+
+    tinygraph_dijkstra_destruct(ctx);
+  }
+
+  tinygraph_destruct(chain);
+
+  // A node relaxed twice: the clamp must not make its second,
+  // shorter relaxation's priority larger than the one it has
+
+  const uint32_t twice_sources[4] = {0, 0, 1, 2};
+  const uint32_t twice_targets[4] = {1, 2, 2, 3};
+  const uint16_t twice_weights[4] = {1, 5, 1, 1};
+
+  const uint32_t twice_lngs[4] = {0, 0, 1000, 0};
+  const uint32_t twice_lats[4] = {0, 0, 0, 0};
+
+  tinygraph_s twice = tinygraph_construct_from_sorted_edges(twice_sources, twice_targets, 4);
+  assert(twice);
+
+  for (uint32_t q = 0; q < sizeof(queues) / sizeof(queues[0]); ++q) {
+    tinygraph_dijkstra_s ctx = tinygraph_dijkstra_construct_astar(twice, twice_weights,
+        twice_lngs, twice_lats, 1.0, queues[q]);
+    assert(ctx);
+
+    assert(tinygraph_dijkstra_shortest_path(ctx, 0, 3));
+    assert(tinygraph_dijkstra_get_distance(ctx) == 3);
+
+    const uint32_t *first, *last;
+    assert(tinygraph_dijkstra_get_path(ctx, &first, &last));
+    assert(last - first == 4);
+
+    for (uint32_t i = 0; i < 4; ++i) {
+      assert(first[i] == i);
+    }
+
+    tinygraph_dijkstra_destruct(ctx);
+  }
+
+  tinygraph_destruct(twice);
+  tinygraph_rng_destruct(rng);
+}
+
 int main(void) {
   test1();
   test2();
@@ -1808,4 +4578,32 @@ int main(void) {
   test42();
   test43();
   test44();
+  test45();
+  test46();
+  test47();
+  test48();
+  test49();
+  test50();
+  test51();
+  test52();
+  test53();
+  test54();
+  test55();
+  test56();
+  test57();
+  test58();
+  test59();
+  test60();
+  test61();
+  test62();
+  test63();
+  test64();
+  test65();
+  test66();
+  test67();
+  test68();
+  test69();
+  test70();
+  test71();
+  test72();
 }
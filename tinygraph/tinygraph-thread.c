@@ -0,0 +1,75 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "tinygraph-thread.h"
+
+
+typedef struct tinygraph_thread_task {
+  void (*fn)(void *arg, uint32_t task);
+  void *arg;
+  uint32_t task;
+  bool spawned;
+  pthread_t thread;
+} tinygraph_thread_task;
+
+
+static void* tinygraph_thread_main(void *data) {
+  tinygraph_thread_task *task = data;
+
+  task->fn(task->arg, task->task);
+
+  return NULL;
+}
+
+
+void tinygraph_thread_run(uint32_t num_tasks, void (*fn)(void *arg, uint32_t task), void *arg) {
+  TINYGRAPH_ASSERT(fn);
+
+  if (num_tasks == 0) {
+    return;
+  }
+
+  tinygraph_thread_task *tasks = NULL;
+
+  if (num_tasks > 1) {
+    tasks = calloc(num_tasks - 1, sizeof(tinygraph_thread_task));
+  }
+
+  // Without the bookkeeping memory we run all tasks ourselves
+
+  if (!tasks) {
+    for (uint32_t i = 0; i < num_tasks; ++i) {
+      fn(arg, i);
+    }
+
+    return;
+  }
+
+  for (uint32_t i = 1; i < num_tasks; ++i) {
+    tinygraph_thread_task *task = &tasks[i - 1];
+
+    *task = (tinygraph_thread_task){
+      .fn = fn,
+      .arg = arg,
+      .task = i,
+      .spawned = false,
+    };
+
+    task->spawned = pthread_create(&task->thread, NULL, tinygraph_thread_main, task) == 0;
+  }
+
+  fn(arg, 0);
+
+  for (uint32_t i = 1; i < num_tasks; ++i) {
+    tinygraph_thread_task *task = &tasks[i - 1];
+
+    if (task->spawned) {
+      pthread_join(task->thread, NULL);
+    } else {
+      fn(arg, i);
+    }
+  }
+
+  free(tasks);
+}
@@ -0,0 +1,23 @@
+#ifndef TINYGRAPH_THREAD_H
+#define TINYGRAPH_THREAD_H
+
+#include <stdint.h>
+
+#include "tinygraph-utils.h"
+
+/*
+ * Minimal fork-join parallelism for the
+ * parallel construction functions: runs
+ * independent tasks on short-lived threads.
+ */
+
+
+// Runs fn(arg, task) for all tasks in [0, num_tasks)
+// with one thread per task, the calling thread taking
+// on the first task, and waits for all of them. Tasks
+// have to be independent: if a thread can not be
+// created, its task runs on the calling thread instead
+void tinygraph_thread_run(uint32_t num_tasks, void (*fn)(void *arg, uint32_t task), void *arg);
+
+
+#endif
@@ -3,8 +3,7 @@
 #include "tinygraph-vbyte.h"
 
 
-TINYGRAPH_WARN_UNUSED
-static inline uint32_t tinygraph_vbyte_encode_one(uint8_t * restrict out, uint32_t value) {
+uint32_t tinygraph_vbyte_encode_one(uint8_t * restrict out, uint32_t value) {
   TINYGRAPH_ASSERT(out);
 
   uint32_t i = 0;
@@ -24,8 +23,7 @@ static inline uint32_t tinygraph_vbyte_encode_one(uint8_t * restrict out, uint32
   return i + 1;
 }
 
-TINYGRAPH_WARN_UNUSED
-static inline uint32_t tinygraph_vbyte_decode_one(const uint8_t * restrict data, uint32_t * restrict out) {
+uint32_t tinygraph_vbyte_decode_one(const uint8_t * restrict data, uint32_t * restrict out) {
   TINYGRAPH_ASSERT(data);
   TINYGRAPH_ASSERT(out);
 
@@ -11,13 +11,20 @@
  * in combination with delta coding, to get to
  * smaller values.
  *
- * Todo: expose functions for scalars not requiring
- * us writing into an out array, for efficiency. Also
- * expose function to decode an array of n bytes and
- * don't require the user to tell us about num ints.
+ * The scalar functions encode or decode a single
+ * integer and return the number of bytes used.
+ *
+ * Todo: expose function to decode an array of n bytes
+ * and don't require the user to tell us about num ints.
  */
 
 
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_vbyte_encode_one(uint8_t * restrict out, uint32_t value);
+
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_vbyte_decode_one(const uint8_t * restrict data, uint32_t * restrict out);
+
 TINYGRAPH_WARN_UNUSED
 uint32_t tinygraph_vbyte_encode(const uint32_t * restrict data, uint8_t * restrict out, uint32_t n);
 
@@ -1,155 +1,256 @@
 #include "tinygraph-zorder.h"
+#include "tinygraph-cpu.h"
 
-#ifdef __BMI2__
+#if defined(__x86_64__) || defined(__i386__)
 #include <x86intrin.h>
 #endif
 
 /*
  * The z-order space filling curve for n dimensions
  * works by bit-interleaving the n different values.
+ * We support 2d only for now.
  *
- * We implement bit-interleaving recursively for all
- * data types by means of combining the even and odd
- * bit-blasted patterns. We support 2d only for now.
+ * On hosts with fast PDEP and PEXT instructions the
+ * interleaving is a single deposit or extract per
+ * dimension. Everywhere else we bit-blast bytes via
+ * a look up table for encoding and compact the bits
+ * with shifts and masks for decoding.
  *
  * Bit-blasting 4 bits into 8 bits: 1010 -> 01000100
  *
- * For the 4-to-8 bit-blasting we define a small
- * look up table; bigger data types then build up
- * from the four bit look up table bottom to top.
+ * We pick the implementation at load time, see the
+ * tinygraph-cpu module.
  */
 
-#ifdef __BMI2__
+#if defined(__x86_64__) || defined(__i386__)
 
-uint32_t tinygraph_zorder_encode32(uint16_t x, uint16_t y) {
+__attribute__((target("bmi2")))
+uint32_t tinygraph_zorder_encode32_pdep(uint16_t x, uint16_t y) {
   TINYGRAPH_STATIC_ASSERT(sizeof(uint32_t) == sizeof(unsigned int));
 
   return _pdep_u32(y, UINT32_C(0xaaaaaaaa)) | _pdep_u32(x, UINT32_C(0x55555555));
 }
 
-uint64_t tinygraph_zorder_encode64(uint32_t x, uint32_t y) {
+__attribute__((target("bmi2")))
+uint64_t tinygraph_zorder_encode64_pdep(uint32_t x, uint32_t y) {
   TINYGRAPH_STATIC_ASSERT(sizeof(uint64_t) == sizeof(unsigned long long));
 
   return _pdep_u64(y, UINT64_C(0xaaaaaaaaaaaaaaaa)) | _pdep_u64(x, UINT64_C(0x5555555555555555));
 }
 
-void tinygraph_zorder_decode32(uint32_t z, uint16_t * restrict x, uint16_t * restrict y) {
+__attribute__((target("bmi2")))
+void tinygraph_zorder_decode32_pdep(uint32_t z, uint16_t * restrict x, uint16_t * restrict y) {
   TINYGRAPH_STATIC_ASSERT(sizeof(uint32_t) == sizeof(unsigned int));
 
   *y = _pext_u32(z, UINT32_C(0xaaaaaaaa));
   *x = _pext_u32(z, UINT32_C(0x55555555));
 }
 
-void tinygraph_zorder_decode64(uint64_t z, uint32_t * restrict x, uint32_t * restrict y) {
+__attribute__((target("bmi2")))
+void tinygraph_zorder_decode64_pdep(uint64_t z, uint32_t * restrict x, uint32_t * restrict y) {
   TINYGRAPH_STATIC_ASSERT(sizeof(uint64_t) == sizeof(unsigned long long));
 
   *y = _pext_u64(z, UINT64_C(0xaaaaaaaaaaaaaaaa));
   *x = _pext_u64(z, UINT64_C(0x5555555555555555));
 }
 
-#else // __BMI2__
+#endif
 
-static const uint8_t tinygraph_bitblast4[16] = {
-   0x0,  0x1,  0x4,  0x5, 0x10, 0x11, 0x14, 0x15,
-  0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55
+
+// Bit-blasts a byte into the even bits of 16 bits
+static const uint16_t tinygraph_bitblast8[256] = {
+  0x0000, 0x0001, 0x0004, 0x0005, 0x0010, 0x0011, 0x0014, 0x0015,
+  0x0040, 0x0041, 0x0044, 0x0045, 0x0050, 0x0051, 0x0054, 0x0055,
+  0x0100, 0x0101, 0x0104, 0x0105, 0x0110, 0x0111, 0x0114, 0x0115,
+  0x0140, 0x0141, 0x0144, 0x0145, 0x0150, 0x0151, 0x0154, 0x0155,
+  0x0400, 0x0401, 0x0404, 0x0405, 0x0410, 0x0411, 0x0414, 0x0415,
+  0x0440, 0x0441, 0x0444, 0x0445, 0x0450, 0x0451, 0x0454, 0x0455,
+  0x0500, 0x0501, 0x0504, 0x0505, 0x0510, 0x0511, 0x0514, 0x0515,
+  0x0540, 0x0541, 0x0544, 0x0545, 0x0550, 0x0551, 0x0554, 0x0555,
+  0x1000, 0x1001, 0x1004, 0x1005, 0x1010, 0x1011, 0x1014, 0x1015,
+  0x1040, 0x1041, 0x1044, 0x1045, 0x1050, 0x1051, 0x1054, 0x1055,
+  0x1100, 0x1101, 0x1104, 0x1105, 0x1110, 0x1111, 0x1114, 0x1115,
+  0x1140, 0x1141, 0x1144, 0x1145, 0x1150, 0x1151, 0x1154, 0x1155,
+  0x1400, 0x1401, 0x1404, 0x1405, 0x1410, 0x1411, 0x1414, 0x1415,
+  0x1440, 0x1441, 0x1444, 0x1445, 0x1450, 0x1451, 0x1454, 0x1455,
+  0x1500, 0x1501, 0x1504, 0x1505, 0x1510, 0x1511, 0x1514, 0x1515,
+  0x1540, 0x1541, 0x1544, 0x1545, 0x1550, 0x1551, 0x1554, 0x1555,
+  0x4000, 0x4001, 0x4004, 0x4005, 0x4010, 0x4011, 0x4014, 0x4015,
+  0x4040, 0x4041, 0x4044, 0x4045, 0x4050, 0x4051, 0x4054, 0x4055,
+  0x4100, 0x4101, 0x4104, 0x4105, 0x4110, 0x4111, 0x4114, 0x4115,
+  0x4140, 0x4141, 0x4144, 0x4145, 0x4150, 0x4151, 0x4154, 0x4155,
+  0x4400, 0x4401, 0x4404, 0x4405, 0x4410, 0x4411, 0x4414, 0x4415,
+  0x4440, 0x4441, 0x4444, 0x4445, 0x4450, 0x4451, 0x4454, 0x4455,
+  0x4500, 0x4501, 0x4504, 0x4505, 0x4510, 0x4511, 0x4514, 0x4515,
+  0x4540, 0x4541, 0x4544, 0x4545, 0x4550, 0x4551, 0x4554, 0x4555,
+  0x5000, 0x5001, 0x5004, 0x5005, 0x5010, 0x5011, 0x5014, 0x5015,
+  0x5040, 0x5041, 0x5044, 0x5045, 0x5050, 0x5051, 0x5054, 0x5055,
+  0x5100, 0x5101, 0x5104, 0x5105, 0x5110, 0x5111, 0x5114, 0x5115,
+  0x5140, 0x5141, 0x5144, 0x5145, 0x5150, 0x5151, 0x5154, 0x5155,
+  0x5400, 0x5401, 0x5404, 0x5405, 0x5410, 0x5411, 0x5414, 0x5415,
+  0x5440, 0x5441, 0x5444, 0x5445, 0x5450, 0x5451, 0x5454, 0x5455,
+  0x5500, 0x5501, 0x5504, 0x5505, 0x5510, 0x5511, 0x5514, 0x5515,
+  0x5540, 0x5541, 0x5544, 0x5545, 0x5550, 0x5551, 0x5554, 0x5555
 };
 
 TINYGRAPH_WARN_UNUSED
-static inline uint16_t tinygraph_bitblast8(uint8_t x) {
-  uint16_t v = 0;
-
-  v |= (uint16_t)tinygraph_bitblast4[(x >> 0) & 0xf] << 0;
-  v |= (uint16_t)tinygraph_bitblast4[(x >> 4) & 0xf] << 8;
+static inline uint32_t tinygraph_bitblast16(uint16_t x) {
+  return (uint32_t)tinygraph_bitblast8[x & 0xff]
+    | (uint32_t)tinygraph_bitblast8[x >> 8] << 16;
+}
 
-  return v;
+TINYGRAPH_WARN_UNUSED
+static inline uint64_t tinygraph_bitblast32(uint32_t x) {
+  return (uint64_t)tinygraph_bitblast8[(x >> 0) & 0xff] << 0
+    | (uint64_t)tinygraph_bitblast8[(x >> 8) & 0xff] << 16
+    | (uint64_t)tinygraph_bitblast8[(x >> 16) & 0xff] << 32
+    | (uint64_t)tinygraph_bitblast8[(x >> 24) & 0xff] << 48;
 }
 
+// Inverse of bit-blasting: packs the even bits together
 TINYGRAPH_WARN_UNUSED
-static inline uint32_t tinygraph_bitblast16(uint16_t x) {
-  uint32_t v = 0;
+static inline uint32_t tinygraph_bitpack64(uint64_t x) {
+  x &= UINT64_C(0x5555555555555555);
+  x = (x | (x >> 1)) & UINT64_C(0x3333333333333333);
+  x = (x | (x >> 2)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+  x = (x | (x >> 4)) & UINT64_C(0x00ff00ff00ff00ff);
+  x = (x | (x >> 8)) & UINT64_C(0x0000ffff0000ffff);
+  x = (x | (x >> 16)) & UINT64_C(0x00000000ffffffff);
+
+  return (uint32_t)x;
+}
 
-  v |= (uint32_t)tinygraph_bitblast8((x >> 0) & 0xff) << 0;
-  v |= (uint32_t)tinygraph_bitblast8((x >> 8) & 0xff) << 16;
 
-  return v;
+uint32_t tinygraph_zorder_encode32_lut(uint16_t x, uint16_t y) {
+  return (tinygraph_bitblast16(y) << 1) | tinygraph_bitblast16(x);
 }
 
-TINYGRAPH_WARN_UNUSED
-static inline uint64_t tinygraph_bitblast32(uint32_t x) {
-  uint64_t v = 0;
+uint64_t tinygraph_zorder_encode64_lut(uint32_t x, uint32_t y) {
+  return (tinygraph_bitblast32(y) << 1) | tinygraph_bitblast32(x);
+}
 
-  v |= (uint64_t)tinygraph_bitblast16((x >> 0) & 0xffff) << 0;
-  v |= (uint64_t)tinygraph_bitblast16((x >> 16) & 0xffff) << 32;
+void tinygraph_zorder_decode32_lut(uint32_t z, uint16_t * restrict x, uint16_t * restrict y) {
+  TINYGRAPH_ASSERT(y);
+  TINYGRAPH_ASSERT(x);
 
-  return v;
+  *x = (uint16_t)tinygraph_bitpack64(z);
+  *y = (uint16_t)tinygraph_bitpack64(z >> 1);
 }
 
+void tinygraph_zorder_decode64_lut(uint64_t z, uint32_t * restrict x, uint32_t * restrict y) {
+  TINYGRAPH_ASSERT(y);
+  TINYGRAPH_ASSERT(x);
 
-TINYGRAPH_WARN_UNUSED
-uint32_t tinygraph_zorder_encode32(uint16_t x, uint16_t y) {
-  return (tinygraph_bitblast16(y) << 1) | tinygraph_bitblast16(x);
+  *x = tinygraph_bitpack64(z);
+  *y = tinygraph_bitpack64(z >> 1);
 }
 
 
-TINYGRAPH_WARN_UNUSED
-uint64_t tinygraph_zorder_encode64(uint32_t x, uint32_t y) {
-  return (tinygraph_bitblast32(y) << 1) | tinygraph_bitblast32(x);
+uint32_t tinygraph_zorder_encode32(uint16_t x, uint16_t y) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (TINYGRAPH_LIKELY(tinygraph_cpu_has_fast_pdep())) {
+    return tinygraph_zorder_encode32_pdep(x, y);
+  }
+#endif
+
+  return tinygraph_zorder_encode32_lut(x, y);
 }
 
+uint64_t tinygraph_zorder_encode64(uint32_t x, uint32_t y) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (TINYGRAPH_LIKELY(tinygraph_cpu_has_fast_pdep())) {
+    return tinygraph_zorder_encode64_pdep(x, y);
+  }
+#endif
 
-static const uint8_t tinygraph_bitpack8[] = {
-   [0x0] = 0,   [0x1] = 1,   [0x4] = 2,   [0x5] = 3,
-  [0x10] = 4,  [0x11] = 5,  [0x14] = 6,  [0x15] = 7,
-  [0x40] = 8,  [0x41] = 9,  [0x44] = 10, [0x45] = 11,
-  [0x50] = 12, [0x51] = 13, [0x54] = 14, [0x55] = 15
-};
+  return tinygraph_zorder_encode64_lut(x, y);
+}
 
-TINYGRAPH_WARN_UNUSED
-static inline uint8_t tinygraph_bitpack16(uint16_t x) {
-  uint8_t v = 0;
+void tinygraph_zorder_decode32(uint32_t z, uint16_t * restrict x, uint16_t * restrict y) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (TINYGRAPH_LIKELY(tinygraph_cpu_has_fast_pdep())) {
+    tinygraph_zorder_decode32_pdep(z, x, y);
+    return;
+  }
+#endif
 
-  v |= tinygraph_bitpack8[(x & 0x00ff) >> 0] << 0;
-  v |= tinygraph_bitpack8[(x & 0xff00) >> 8] << 4;
+  tinygraph_zorder_decode32_lut(z, x, y);
+}
 
-  return v;
+void tinygraph_zorder_decode64(uint64_t z, uint32_t * restrict x, uint32_t * restrict y) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (TINYGRAPH_LIKELY(tinygraph_cpu_has_fast_pdep())) {
+    tinygraph_zorder_decode64_pdep(z, x, y);
+    return;
+  }
+#endif
+
+  tinygraph_zorder_decode64_lut(z, x, y);
 }
 
-TINYGRAPH_WARN_UNUSED
-static inline uint16_t tinygraph_bitpack32(uint32_t x) {
-  uint16_t v = 0;
 
-  v |= tinygraph_bitpack16((x & UINT32_C(0x0000ffff)) >> 0) << 0;
-  v |= tinygraph_bitpack16((x & UINT32_C(0xffff0000)) >> 16) << 8;
+#if defined(__x86_64__) || defined(__i386__)
+
+// Spreads the lower 32 bits of each lane into its even bits;
+// the ternary logic 0xa8 computes (a | b) & c in one step
+
+TINYGRAPH_TARGET_AVX512
+static inline __m512i tinygraph_bitblast32_avx512(__m512i v) {
+  v = _mm512_ternarylogic_epi64(v, _mm512_slli_epi64(v, 16), _mm512_set1_epi64(INT64_C(0x0000ffff0000ffff)), 0xa8);
+  v = _mm512_ternarylogic_epi64(v, _mm512_slli_epi64(v, 8), _mm512_set1_epi64(INT64_C(0x00ff00ff00ff00ff)), 0xa8);
+  v = _mm512_ternarylogic_epi64(v, _mm512_slli_epi64(v, 4), _mm512_set1_epi64(INT64_C(0x0f0f0f0f0f0f0f0f)), 0xa8);
+  v = _mm512_ternarylogic_epi64(v, _mm512_slli_epi64(v, 2), _mm512_set1_epi64(INT64_C(0x3333333333333333)), 0xa8);
+  v = _mm512_ternarylogic_epi64(v, _mm512_slli_epi64(v, 1), _mm512_set1_epi64(INT64_C(0x5555555555555555)), 0xa8);
 
   return v;
 }
 
-TINYGRAPH_WARN_UNUSED
-static inline uint32_t tinygraph_bitpack64(uint64_t x) {
-  uint32_t v = 0;
+TINYGRAPH_TARGET_AVX512
+static void tinygraph_zorder_encode64_n_avx512(const uint32_t * restrict xs, const uint32_t * restrict ys, uint64_t * restrict zs, uint64_t n) {
+  uint64_t i = 0;
 
-  v |= tinygraph_bitpack32((x & UINT64_C(0x00000000ffffffff)) >> 0) << 0;
-  v |= tinygraph_bitpack32((x & UINT64_C(0xffffffff00000000)) >> 32) << 16;
+  for (; i + 8 <= n; i += 8) {
+    const __m512i x = _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *)(xs + i)));
+    const __m512i y = _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *)(ys + i)));
 
-  return v;
-}
+    const __m512i z = _mm512_or_si512(
+        _mm512_slli_epi64(tinygraph_bitblast32_avx512(y), 1),
+        tinygraph_bitblast32_avx512(x));
 
+    _mm512_storeu_si512((void *)(zs + i), z);
+  }
 
-void tinygraph_zorder_decode32(uint32_t z, uint16_t * restrict x, uint16_t * restrict y) {
-  TINYGRAPH_ASSERT(y);
-  TINYGRAPH_ASSERT(x);
+  // The tail as a masked eight lanes step
+  if (i < n) {
+    const __mmask8 k = (__mmask8)((1u << (n - i)) - 1);
+
+    const __m512i x = _mm512_cvtepu32_epi64(_mm256_maskz_loadu_epi32(k, xs + i));
+    const __m512i y = _mm512_cvtepu32_epi64(_mm256_maskz_loadu_epi32(k, ys + i));
+
+    const __m512i z = _mm512_or_si512(
+        _mm512_slli_epi64(tinygraph_bitblast32_avx512(y), 1),
+        tinygraph_bitblast32_avx512(x));
 
-  *x = tinygraph_bitpack32(z & UINT32_C(0x55555555));
-  *y = tinygraph_bitpack32((z >> 1) & UINT32_C(0x55555555));
+    _mm512_mask_storeu_epi64(zs + i, k, z);
+  }
 }
 
+#endif
 
-void tinygraph_zorder_decode64(uint64_t z, uint32_t * restrict x, uint32_t * restrict y) {
-  TINYGRAPH_ASSERT(y);
-  TINYGRAPH_ASSERT(x);
 
-  *x = tinygraph_bitpack64(z & UINT64_C(0x5555555555555555));
-  *y = tinygraph_bitpack64((z >> 1) & UINT64_C(0x5555555555555555));
-}
+void tinygraph_zorder_encode64_n(const uint32_t * restrict xs, const uint32_t * restrict ys, uint64_t * restrict zs, uint64_t n) {
+  TINYGRAPH_ASSERT(xs || n == 0);
+  TINYGRAPH_ASSERT(ys || n == 0);
+  TINYGRAPH_ASSERT(zs || n == 0);
+
+#if defined(__x86_64__) || defined(__i386__)
+  if (tinygraph_cpu_has_avx512()) {
+    tinygraph_zorder_encode64_n_avx512(xs, ys, zs, n);
+    return;
+  }
+#endif
 
-#endif // __BMI2__
+  for (uint64_t i = 0; i < n; ++i) {
+    zs[i] = tinygraph_zorder_encode64(xs[i], ys[i]);
+  }
+}
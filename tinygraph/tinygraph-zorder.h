@@ -21,5 +21,31 @@ void tinygraph_zorder_decode32(uint32_t z, uint16_t * restrict x, uint16_t * res
 
 void tinygraph_zorder_decode64(uint64_t z, uint32_t * restrict x, uint32_t * restrict y);
 
+// Encodes the n pairs in xs and ys into zs in bulk
+void tinygraph_zorder_encode64_n(const uint32_t * restrict xs, const uint32_t * restrict ys, uint64_t * restrict zs, uint64_t n);
+
+
+// The implementations we dispatch between at runtime;
+// the PDEP ones require BMI2 on the host
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_zorder_encode32_pdep(uint16_t x, uint16_t y);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_zorder_encode64_pdep(uint32_t x, uint32_t y);
+
+void tinygraph_zorder_decode32_pdep(uint32_t z, uint16_t * restrict x, uint16_t * restrict y);
+
+void tinygraph_zorder_decode64_pdep(uint64_t z, uint32_t * restrict x, uint32_t * restrict y);
+
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_zorder_encode32_lut(uint16_t x, uint16_t y);
+
+TINYGRAPH_WARN_UNUSED
+uint64_t tinygraph_zorder_encode64_lut(uint32_t x, uint32_t y);
+
+void tinygraph_zorder_decode32_lut(uint32_t z, uint16_t * restrict x, uint16_t * restrict y);
+
+void tinygraph_zorder_decode64_lut(uint64_t z, uint32_t * restrict x, uint32_t * restrict y);
+
 
 #endif
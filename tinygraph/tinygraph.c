@@ -1,15 +1,28 @@
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 
 #include "tinygraph.h"
 #include "tinygraph-utils.h"
 #include "tinygraph-zorder.h"
+#include "tinygraph-hilbert.h"
 #include "tinygraph-sort.h"
+#include "tinygraph-bits.h"
 #include "tinygraph-impl.h"
 #include "tinygraph-array.h"
 #include "tinygraph-bitset.h"
 #include "tinygraph-heap.h"
+#include "tinygraph-radixheap.h"
+#include "tinygraph-bucketqueue.h"
+#include "tinygraph-indexedheap.h"
+#include "tinygraph-queue.h"
+#include "tinygraph-stack.h"
+#include "tinygraph-vbyte.h"
+#include "tinygraph-zigzag.h"
+#include "tinygraph-eliasfano.h"
+#include "tinygraph-thread.h"
 
 
 
@@ -34,19 +47,16 @@ tinygraph_s tinygraph_construct_from_sorted_edges(
   TINYGRAPH_ASSERT(sources);
   TINYGRAPH_ASSERT(targets);
 
-  uint32_t min_sources_node;
-  uint32_t max_sources_node;
+  // The sources are sorted, the largest one is the last one
 
-  tinygraph_minmax_u32(sources, n, &min_sources_node, &max_sources_node);
+  const uint32_t max_sources_node = sources[n - 1];
 
-  uint32_t min_targets_node;
-  uint32_t max_targets_node;
+  uint32_t max_node = max_sources_node;
 
-  tinygraph_minmax_u32(targets, n, &min_targets_node, &max_targets_node);
-
-  TINYGRAPH_ASSERT(tinygraph_min_u32(min_sources_node, min_targets_node) == 0);
+  for (uint32_t i = 0; i < n; ++i) {
+    max_node = tinygraph_max_u32(max_node, targets[i]);
+  }
 
-  const uint32_t max_node = tinygraph_max_u32(max_sources_node, max_targets_node);
   TINYGRAPH_ASSERT(max_node != UINT32_MAX);
 
   const uint32_t num_nodes = max_node + 1;
@@ -67,79 +77,165 @@ tinygraph_s tinygraph_construct_from_sorted_edges(
 
   memcpy(graph->targets, targets, num_edges * sizeof(uint32_t));
 
-  const uint32_t *it = sources;
-  const uint32_t * const last = sources + n;
+  // A single pass over the sources: the edge at i starts the
+  // edge ranges of all nodes after the previous edge's source
+  // up to its own source; nodes past the last source are empty
 
-  graph->offsets[0] = 0;
+  uint32_t v = 0;
 
-  for (uint32_t v = 0; v < max_sources_node + 1; ++v) {
-    it = tinygraph_find_if_not_u32(it, last, v);
+  tinygraph_offsets_set(graph, 0, 0);
 
-    const uint32_t offset = it - sources;
+  for (uint32_t i = 0; i < n; ++i) {
+    for (; v < sources[i]; ++v) {
+      tinygraph_offsets_set(graph, v + 1, i);
+    }
+  }
 
-    graph->offsets[v + 1] = offset;
+  for (; v + 1 < num_nodes; ++v) {
+    tinygraph_offsets_set(graph, v + 1, num_edges);
   }
 
-  const uint32_t tombstone = graph->targets_len;
+  if (!tinygraph_offsets_build(graph)) {
+    tinygraph_destruct(graph);
 
-  for (uint32_t v = max_sources_node + 1; v < num_nodes; ++v) {
-    graph->offsets[v + 1] = tombstone;
+    return NULL;
   }
 
   return graph;
 }
 
 
-tinygraph_s tinygraph_copy_reversed(const tinygraph * const graph) {
+// Transposes graph; if ranks is not NULL, we write for each
+// reversed edge its forward edge's index within the forward
+// edge's source's out edges, that is the forward edge id
+// relative to the first out edge of the reversed target
+static tinygraph* tinygraph_copy_reversed_with_ranks(const tinygraph * const graph, uint32_t *ranks) {
   TINYGRAPH_ASSERT(graph);
 
-  if (tinygraph_is_empty(graph)) {
+  const uint32_t n = tinygraph_get_num_edges(graph);
+
+  if (tinygraph_is_empty(graph) || n == 0) {
     return tinygraph_construct_empty();
   }
 
-  const uint32_t n = tinygraph_get_num_edges(graph);
+  // A counting sort by target: count the nodes' in degrees,
+  // prefix sum them into the reversed edge ranges, and then
+  // scatter the sources into their targets' ranges. We visit
+  // the sources in order, so that every reversed edge range
+  // comes out sorted already and the scatter is stable.
+
+  const uint32_t num_nodes = tinygraph_get_num_nodes(graph);
 
-  uint32_t* sources = calloc(n, sizeof(uint32_t));
-  uint32_t* targets = calloc(n, sizeof(uint32_t));
+  tinygraph *copy = tinygraph_construct_empty();
+  uint32_t *ends = calloc(num_nodes, sizeof(uint32_t));
 
-  if (!sources || !targets) {
-    free(sources);
-    free(targets);
+  if (!copy || !ends || !tinygraph_reserve(copy, num_nodes, n)) {
+    free(ends);
+    tinygraph_destruct(copy);
 
     return NULL;
   }
 
-  uint32_t i = 0;
+  if (graph->targets) {
+    for (uint32_t i = 0; i < n; ++i) {
+      ends[graph->targets[i]] += 1;
+    }
+  } else {
+    TINYGRAPH_FOR_EACH_NODE(s, graph) {
+      tinygraph_neighbors_it it;
+      uint32_t t;
 
-  TINYGRAPH_FOR_EACH_NODE(s, graph) {
-    const uint32_t *it, *last;
+      tinygraph_neighbors_begin(graph, &it, s);
 
-    tinygraph_get_neighbors(graph, &it, &last, s);
+      while (tinygraph_neighbors_next(&it, &t)) {
+        ends[t] += 1;
+      }
+    }
+  }
 
-    for (; it != last; ++it) {
-      const uint32_t t = *it;
+  uint32_t sum = 0;
 
-      sources[i] = t;
-      targets[i] = s;
+  for (uint32_t v = 0; v < num_nodes; ++v) {
+    const uint32_t degree = ends[v];
+    ends[v] = sum;
+    sum += degree;
+  }
 
-      i += 1;
+  TINYGRAPH_ASSERT(sum == n);
+
+  if (graph->targets) {
+    // Walk the offsets' set bits in order, instead of a select per node
+
+    uint64_t p = 0;
+
+    for (uint32_t s = 0; s < num_nodes; ++s) {
+      const uint64_t q = tinygraph_bitset_find_next(graph->offsets, p + 1);
+
+      const uint64_t first = p - s;
+
+      for (uint64_t e = first; e < q - (s + 1); ++e) {
+        const uint32_t pos = ends[graph->targets[e]]++;
+
+        copy->targets[pos] = s;
+
+        if (ranks) {
+          ranks[pos] = (uint32_t)(e - first);
+        }
+      }
+
+      p = q;
+    }
+  } else {
+    TINYGRAPH_FOR_EACH_NODE(s, graph) {
+      tinygraph_neighbors_it it;
+      uint32_t t;
+
+      tinygraph_neighbors_begin(graph, &it, s);
+
+      for (uint32_t rank = 0; tinygraph_neighbors_next(&it, &t); ++rank) {
+        const uint32_t pos = ends[t]++;
+
+        copy->targets[pos] = s;
+
+        if (ranks) {
+          ranks[pos] = rank;
+        }
+      }
     }
   }
 
-  TINYGRAPH_ASSERT(n == i);
+  uint32_t start = 0;
+
+  for (uint32_t v = 0; v < num_nodes; ++v) {
+    tinygraph_offsets_set(copy, v, start);
+
+    start = ends[v];
+  }
+
+  free(ends);
 
-  tinygraph *copy = tinygraph_construct_from_unsorted_edges(sources, targets, n);
+  if (!tinygraph_offsets_build(copy)) {
+    tinygraph_destruct(copy);
 
-  free(sources);
-  free(targets);
+    return NULL;
+  }
 
   return copy;
 }
 
 
+tinygraph_s tinygraph_copy_reversed(const tinygraph * const graph) {
+  return tinygraph_copy_reversed_with_ranks(graph, NULL);
+}
+
+
 tinygraph_s tinygraph_copy(const tinygraph * const graph) {
   TINYGRAPH_ASSERT(graph);
 
+  if (tinygraph_is_compressed(graph)) {
+    return tinygraph_copy_compressed(graph);
+  }
+
   tinygraph *copy = tinygraph_construct_empty();
 
   if (!copy) {
@@ -160,242 +256,1343 @@ tinygraph_s tinygraph_copy(const tinygraph * const graph) {
     return NULL;
   }
 
-  TINYGRAPH_ASSERT(graph->offsets_len > 0);
-  TINYGRAPH_ASSERT(graph->targets_len > 0);
+  TINYGRAPH_ASSERT(graph->num_nodes > 0);
 
   TINYGRAPH_ASSERT(copy->offsets);
   TINYGRAPH_ASSERT(graph->offsets);
 
-  TINYGRAPH_ASSERT(copy->targets);
-  TINYGRAPH_ASSERT(graph->targets);
+  TINYGRAPH_ASSERT(copy->targets || graph->targets_len == 0);
+  TINYGRAPH_ASSERT(graph->targets || graph->targets_len == 0);
 
-  memcpy(copy->offsets, graph->offsets, graph->offsets_len * sizeof(uint32_t));
-  memcpy(copy->targets, graph->targets, graph->targets_len * sizeof(uint32_t));
+  TINYGRAPH_FOR_EACH_NODE(v, graph) {
+    uint32_t efirst, elast;
 
-  copy->offsets_len = graph->offsets_len;
-  copy->targets_len = graph->targets_len;
+    tinygraph_get_out_edges(graph, v, &efirst, &elast);
 
-  return copy;
-}
+    tinygraph_offsets_set(copy, v, efirst);
+  }
 
+  if (graph->targets_len > 0) {
+    memcpy(copy->targets, graph->targets, graph->targets_len * sizeof(uint32_t));
+  }
 
-tinygraph_s tinygraph_construct_from_unsorted_edges(
-    const uint32_t* sources,
-    const uint32_t* targets,
-    uint32_t n)
-{
-  TINYGRAPH_ASSERT(n != UINT32_MAX);
+  if (!tinygraph_offsets_build(copy)) {
+    tinygraph_destruct(copy);
+
+    return NULL;
+  }
+
+  return copy;
+}
 
-  TINYGRAPH_ASSERT(sources);
-  TINYGRAPH_ASSERT(targets);
 
-  uint32_t* sorted_sources = calloc(n, sizeof(uint32_t));
-  uint32_t* sorted_targets = calloc(n, sizeof(uint32_t));
+tinygraph_s tinygraph_copy_compressed(const tinygraph * const graph) {
+  TINYGRAPH_ASSERT(graph);
 
-  if (!sorted_sources || !sorted_targets) {
-    free(sorted_sources);
-    free(sorted_targets);
+  tinygraph *copy = tinygraph_construct_empty();
 
+  if (!copy) {
     return NULL;
   }
 
-  memcpy(sorted_sources, sources, n * sizeof(uint32_t));
-  memcpy(sorted_targets, targets, n * sizeof(uint32_t));
+  if (tinygraph_is_empty(graph)) {
+    return copy;
+  }
 
-  if (!tinygraph_sort_sources_targets(sorted_sources, sorted_targets, n)) {
-    free(sorted_sources);
-    free(sorted_targets);
+  // The targets are sorted per node by construction, so
+  // that gaps after the first target are non-negative;
+  // the first target can be before its source node and
+  // we zig-zag code its gap to keep it small, too.
+  //
+  // We first run over the graph to find out how many
+  // bytes we need, then we allocate and encode into it.
+  // Hub nodes' targets go into Elias-Fano structures.
 
-    return NULL;
-  }
+  uint64_t num_bytes = 0;
+  uint32_t num_hubs = 0;
+  uint32_t max_degree = 0;
 
-  tinygraph *graph = tinygraph_construct_from_sorted_edges(
-      sorted_sources, sorted_targets, n);
+  TINYGRAPH_FOR_EACH_NODE(s, graph) {
+    const uint32_t degree = tinygraph_get_out_degree(graph, s);
 
-  free(sorted_sources);
-  free(sorted_targets);
+    max_degree = tinygraph_max_u32(max_degree, degree);
 
-  return graph;
-}
+    if (degree >= TINYGRAPH_HUB_DEGREE) {
+      num_hubs += 1;
+      continue;
+    }
 
+    tinygraph_neighbors_it it;
+    uint32_t t;
 
-void tinygraph_destruct(tinygraph * const graph) {
-  if (!graph) {
-    return;
+    tinygraph_neighbors_begin(graph, &it, s);
+
+    uint32_t prev = s;
+    bool head = true;
+
+    while (tinygraph_neighbors_next(&it, &t)) {
+      const uint32_t gap = tinygraph_target_gap_encode(s, prev, t, head);
+
+      num_bytes += tinygraph_requires_num_bytes_u32(gap);
+
+      prev = t;
+      head = false;
+    }
   }
 
-  TINYGRAPH_ASSERT(graph->offsets || graph->offsets_len == 0);
-  TINYGRAPH_ASSERT(graph->targets || graph->targets_len == 0);
+  bool ok = tinygraph_reserve_compressed(copy,
+      tinygraph_get_num_nodes(graph),
+      tinygraph_get_num_edges(graph),
+      num_bytes,
+      num_hubs);
 
-  free(graph->offsets);
-  free(graph->targets);
+  if (!ok) {
+    tinygraph_destruct(copy);
 
-  graph->offsets = NULL;
-  graph->targets = NULL;
+    return NULL;
+  }
 
-  graph->offsets_len = 0;
-  graph->targets_len = 0;
+  uint32_t *hub_targets = NULL;
 
-  free(graph);
-}
+  if (num_hubs > 0) {
+    hub_targets = malloc(max_degree * sizeof(uint32_t));
 
+    if (!hub_targets) {
+      tinygraph_destruct(copy);
 
-bool tinygraph_is_empty(const tinygraph * const graph) {
-  TINYGRAPH_ASSERT(graph);
+      return NULL;
+    }
+  }
 
-  return tinygraph_get_num_nodes(graph) == 0;
-}
+  uint32_t offset = 0;
+  uint64_t bytes_offset = 0;
+  uint32_t hub = 0;
 
+  TINYGRAPH_FOR_EACH_NODE(s, graph) {
+    tinygraph_offsets_set(copy, s, offset);
+    tinygraph_bytes_offsets_set(copy, s, bytes_offset);
 
-uint32_t tinygraph_get_num_nodes(const tinygraph * const graph) {
-  TINYGRAPH_ASSERT(graph);
+    tinygraph_neighbors_it it;
+    uint32_t t;
 
-  return graph->offsets_len > 1 ? graph->offsets_len - 1 : 0;  // tombstone
-}
+    const uint32_t degree = tinygraph_get_out_degree(graph, s);
 
+    if (degree >= TINYGRAPH_HUB_DEGREE) {
+      tinygraph_neighbors_begin(graph, &it, s);
 
-uint32_t tinygraph_get_num_edges(const tinygraph * const graph) {
-  TINYGRAPH_ASSERT(graph);
+      for (uint32_t i = 0; tinygraph_neighbors_next(&it, &t); ++i) {
+        hub_targets[i] = t;
+      }
 
-  return graph->targets_len;
-}
+      copy->hubs[hub] = tinygraph_eliasfano_construct(hub_targets, degree);
+      copy->hubs_nodes[hub] = s;
 
+      if (!copy->hubs[hub]) {
+        free(hub_targets);
+        tinygraph_destruct(copy);
 
-void tinygraph_get_out_edges(
-    const tinygraph * const graph,
-    uint32_t source,
-    uint32_t* first,
-    uint32_t* last)
-{
-  TINYGRAPH_ASSERT(graph);
-  TINYGRAPH_ASSERT(tinygraph_has_node(graph, source));
-  TINYGRAPH_ASSERT(first);
-  TINYGRAPH_ASSERT(last);
+        return NULL;
+      }
 
-  *first = graph->offsets[source];
-  *last = graph->offsets[source + 1];
+      hub += 1;
+      offset += degree;
 
-  // TODO: benchmark if prefetching edge range has an impact
-  // TINYGRAPH_PREFETCH(graph->targets[graph->offsets[source]]);
+      continue;
+    }
 
-  TINYGRAPH_ASSERT(*first <= *last);
-}
+    tinygraph_neighbors_begin(graph, &it, s);
 
+    uint32_t prev = s;
+    bool head = true;
 
-uint32_t tinygraph_get_edge_target(const tinygraph * const graph, uint32_t e) {
-  TINYGRAPH_ASSERT(graph);
-  TINYGRAPH_ASSERT(tinygraph_has_edge(graph, e));
+    while (tinygraph_neighbors_next(&it, &t)) {
+      const uint32_t gap = tinygraph_target_gap_encode(s, prev, t, head);
 
-  return graph->targets[e];
-}
+      bytes_offset += tinygraph_vbyte_encode_one(copy->bytes + bytes_offset, gap);
+      offset += 1;
 
+      prev = t;
+      head = false;
+    }
+  }
 
-uint32_t tinygraph_get_out_degree(const tinygraph * const graph, uint32_t v) {
-  TINYGRAPH_ASSERT(graph);
-  TINYGRAPH_ASSERT(tinygraph_has_node(graph, v));
+  free(hub_targets);
 
-  uint32_t efirst;
-  uint32_t elast;
+  TINYGRAPH_ASSERT(offset == copy->targets_len);
+  TINYGRAPH_ASSERT(bytes_offset == copy->bytes_len);
+  TINYGRAPH_ASSERT(hub == copy->hubs_len);
 
-  tinygraph_get_out_edges(graph, v, &efirst, &elast);
+  if (!tinygraph_offsets_build(copy)) {
+    tinygraph_destruct(copy);
 
-  TINYGRAPH_ASSERT(efirst <= elast);
+    return NULL;
+  }
 
-  return elast - efirst;
+  return copy;
 }
 
 
-void tinygraph_get_neighbors(
-    const tinygraph * const graph,
-    const uint32_t **first,
-    const uint32_t **last,
-    uint32_t v)
+tinygraph_s tinygraph_construct_from_unsorted_edges(
+    const uint32_t* sources,
+    const uint32_t* targets,
+    uint32_t n)
 {
-  TINYGRAPH_ASSERT(graph);
-  TINYGRAPH_ASSERT(first);
-  TINYGRAPH_ASSERT(last);
-  TINYGRAPH_ASSERT(tinygraph_has_node(graph, v));
+  TINYGRAPH_ASSERT(n != UINT32_MAX);
 
-  uint32_t efirst;
-  uint32_t elast;
+  tinygraph *graph = tinygraph_construct_empty();
 
-  tinygraph_get_out_edges(graph, v, &efirst, &elast);
+  if (!graph) {
+    return NULL;
+  }
 
-  *first = &graph->targets[efirst];
-  *last = &graph->targets[elast];
+  if (n == 0) {
+    return graph;
+  }
 
-  // TODO: benchmark if prefetching edge range has an impact
-  // TINYGRAPH_PREFETCH(graph->targets[graph->offsets[source]]);
-}
+  TINYGRAPH_ASSERT(sources);
+  TINYGRAPH_ASSERT(targets);
 
+  // A counting sort by source instead of sorting all edges:
+  // count the nodes' out degrees, prefix sum them into the
+  // start of their edge ranges, and scatter the targets into
+  // their ranges; we then only sort each edge range on its own
 
-bool tinygraph_has_node(const tinygraph * const graph, uint32_t v) {
-  TINYGRAPH_ASSERT(graph);
+  uint32_t max_node = 0;
 
-  return v < tinygraph_get_num_nodes(graph);
-}
+  for (uint32_t i = 0; i < n; ++i) {
+    max_node = tinygraph_max_u32(max_node, tinygraph_max_u32(sources[i], targets[i]));
+  }
 
+  TINYGRAPH_ASSERT(max_node != UINT32_MAX);
 
-bool tinygraph_has_edge(const tinygraph * const graph, uint32_t e) {
-  TINYGRAPH_ASSERT(graph);
+  const uint32_t num_nodes = max_node + 1;
+  const uint32_t num_edges = n;
 
-  return e < tinygraph_get_num_edges(graph);
-}
+  uint32_t *ends = calloc(num_nodes, sizeof(uint32_t));
 
+  if (!ends) {
+    tinygraph_destruct(graph);
 
-bool tinygraph_has_edge_from_to(
-    const tinygraph * const graph,
-    uint32_t source,
-    uint32_t target)
-{
-  TINYGRAPH_ASSERT(tinygraph_has_node(graph, source));
-  TINYGRAPH_ASSERT(tinygraph_has_node(graph, target));
+    return NULL;
+  }
 
-  const uint32_t *it, *last;
+  if (!tinygraph_reserve(graph, num_nodes, num_edges)) {
+    free(ends);
+    tinygraph_destruct(graph);
 
-  tinygraph_get_neighbors(graph, &it, &last, source);
+    return NULL;
+  }
 
-  return tinygraph_find_if_u32(it, last, target) != last;
+  for (uint32_t i = 0; i < n; ++i) {
+    ends[sources[i]] += 1;
+  }
 
-  // TODO: benchmark if prefetching edge range has an impact
-  // TINYGRAPH_PREFETCH(graph->targets[graph->offsets[source]]);
-}
+  // Exclusive prefix sum: ends[v] is where v's edge range starts;
+  // scattering moves it forward to where v's edge range ends
 
+  uint32_t sum = 0;
 
-void tinygraph_apsp(const tinygraph * const graph, const uint8_t* weights, uint8_t* results) {
-  TINYGRAPH_ASSERT(graph);
-  TINYGRAPH_ASSERT(weights);
-  TINYGRAPH_ASSERT(results);
+  for (uint32_t v = 0; v < num_nodes; ++v) {
+    const uint32_t degree = ends[v];
+    ends[v] = sum;
+    sum += degree;
+  }
 
-  const uint64_t num_nodes = tinygraph_get_num_nodes(graph);
+  TINYGRAPH_ASSERT(sum == num_edges);
 
-  for (uint32_t i = 0; i < num_nodes; ++i) {
-    for (uint32_t j = 0; j < num_nodes; ++j) {
-      results[i * num_nodes + j] = -1;
-    }
+  for (uint32_t i = 0; i < n; ++i) {
+    graph->targets[ends[sources[i]]++] = targets[i];
   }
 
-  TINYGRAPH_FOR_EACH_NODE(source, graph) {
-    uint32_t efirst, elast;
+  uint32_t start = 0;
 
-    tinygraph_get_out_edges(graph, source, &efirst, &elast);
+  for (uint32_t v = 0; v < num_nodes; ++v) {
+    tinygraph_offsets_set(graph, v, start);
+    tinygraph_sort_plain_u32(graph->targets + start, ends[v] - start);
 
-    for (; efirst != elast; ++efirst) {
-      const uint32_t edge = efirst;
+    start = ends[v];
+  }
 
-      const uint32_t target = tinygraph_get_edge_target(graph, edge);
+  TINYGRAPH_ASSERT(start == num_edges);
 
-      uint8_t *out = &results[source * num_nodes + target];
+  free(ends);
 
-      *out = tinygraph_min_u32(weights[edge], *out);
-    }
+  if (!tinygraph_offsets_build(graph)) {
+    tinygraph_destruct(graph);
+
+    return NULL;
   }
 
-  TINYGRAPH_FOR_EACH_NODE(v, graph) {
-    const uint32_t source = v;
-    const uint32_t target = v;
+  return graph;
+}
 
-    results[source * num_nodes + target] = 0;
+
+// Sorts an edge range's keys with the target in the upper
+// half and a tie-breaking edge index in the lower half;
+// ranges are short except for the rare hub nodes
+TINYGRAPH_WARN_UNUSED
+static bool tinygraph_sort_edge_keys(uint64_t *keys, uint32_t n) {
+  if (n > 32) {
+    return tinygraph_radix_sort_u64(keys, n);
+  }
+
+  for (uint32_t i = 1; i < n; ++i) {
+    const uint64_t key = keys[i];
+    uint32_t j = i;
+
+    for (; j > 0 && keys[j - 1] > key; --j) {
+      keys[j] = keys[j - 1];
+    }
+
+    keys[j] = key;
+  }
+
+  return true;
+}
+
+
+tinygraph_s tinygraph_construct_from_unsorted_edges_permutation(
+    const uint32_t* sources,
+    const uint32_t* targets,
+    uint32_t n,
+    uint32_t* permutation)
+{
+  TINYGRAPH_ASSERT(n != UINT32_MAX);
+
+  tinygraph *graph = tinygraph_construct_empty();
+
+  if (!graph) {
+    return NULL;
+  }
+
+  if (n == 0) {
+    return graph;
+  }
+
+  TINYGRAPH_ASSERT(sources);
+  TINYGRAPH_ASSERT(targets);
+  TINYGRAPH_ASSERT(permutation);
+
+  // A counting sort by source as in the construction above,
+  // scattering keys with the target in the upper half and
+  // the input index in the lower half; sorting each edge
+  // range by these keys then sorts by target and keeps
+  // duplicate edges in their input order
+
+  uint32_t max_node = 0;
+
+  for (uint32_t i = 0; i < n; ++i) {
+    max_node = tinygraph_max_u32(max_node, tinygraph_max_u32(sources[i], targets[i]));
+  }
+
+  TINYGRAPH_ASSERT(max_node != UINT32_MAX);
+
+  const uint32_t num_nodes = max_node + 1;
+  const uint32_t num_edges = n;
+
+  uint32_t *ends = calloc(num_nodes, sizeof(uint32_t));
+  uint64_t *keys = malloc(num_edges * sizeof(uint64_t));
+
+  if (!ends || !keys) {
+    free(keys);
+    free(ends);
+    tinygraph_destruct(graph);
+
+    return NULL;
+  }
+
+  if (!tinygraph_reserve(graph, num_nodes, num_edges)) {
+    free(keys);
+    free(ends);
+    tinygraph_destruct(graph);
+
+    return NULL;
+  }
+
+  for (uint32_t i = 0; i < n; ++i) {
+    ends[sources[i]] += 1;
+  }
+
+  uint32_t sum = 0;
+
+  for (uint32_t v = 0; v < num_nodes; ++v) {
+    const uint32_t degree = ends[v];
+    ends[v] = sum;
+    sum += degree;
+  }
+
+  TINYGRAPH_ASSERT(sum == num_edges);
+
+  for (uint32_t i = 0; i < n; ++i) {
+    keys[ends[sources[i]]++] = ((uint64_t)targets[i] << 32) | i;
+  }
+
+  uint32_t start = 0;
+
+  for (uint32_t v = 0; v < num_nodes; ++v) {
+    tinygraph_offsets_set(graph, v, start);
+
+    if (!tinygraph_sort_edge_keys(keys + start, ends[v] - start)) {
+      free(keys);
+      free(ends);
+      tinygraph_destruct(graph);
+
+      return NULL;
+    }
+
+    for (uint32_t e = start; e < ends[v]; ++e) {
+      graph->targets[e] = (uint32_t)(keys[e] >> 32);
+      permutation[e] = (uint32_t)keys[e];
+    }
+
+    start = ends[v];
+  }
+
+  TINYGRAPH_ASSERT(start == num_edges);
+
+  free(keys);
+  free(ends);
+
+  if (!tinygraph_offsets_build(graph)) {
+    tinygraph_destruct(graph);
+
+    return NULL;
+  }
+
+  return graph;
+}
+
+
+tinygraph_s tinygraph_construct_from_unsorted_edges_payload(
+    const uint32_t* sources,
+    const uint32_t* targets,
+    uint32_t n,
+    const void* payload,
+    void* payload_out,
+    uint32_t payload_size)
+{
+  TINYGRAPH_ASSERT(n != UINT32_MAX);
+  TINYGRAPH_ASSERT(payload_size > 0);
+
+  if (n == 0) {
+    return tinygraph_construct_empty();
+  }
+
+  TINYGRAPH_ASSERT(payload);
+  TINYGRAPH_ASSERT(payload_out);
+  TINYGRAPH_ASSERT(payload != payload_out);
+
+  uint32_t *permutation = malloc(n * sizeof(uint32_t));
+
+  if (!permutation) {
+    return NULL;
+  }
+
+  tinygraph *graph = tinygraph_construct_from_unsorted_edges_permutation(
+      sources, targets, n, permutation);
+
+  if (!graph) {
+    free(permutation);
+
+    return NULL;
+  }
+
+  // Gather the records; the common record sizes get their
+  // own loops so that the compiler turns memcpy into moves
+
+  const unsigned char *src = payload;
+  unsigned char *dst = payload_out;
+
+  switch (payload_size) {
+    case 2:
+      for (uint32_t e = 0; e < n; ++e) {
+        memcpy(dst + (uint64_t)e * 2, src + (uint64_t)permutation[e] * 2, 2);
+      }
+      break;
+    case 4:
+      for (uint32_t e = 0; e < n; ++e) {
+        memcpy(dst + (uint64_t)e * 4, src + (uint64_t)permutation[e] * 4, 4);
+      }
+      break;
+    case 8:
+      for (uint32_t e = 0; e < n; ++e) {
+        memcpy(dst + (uint64_t)e * 8, src + (uint64_t)permutation[e] * 8, 8);
+      }
+      break;
+    default:
+      for (uint32_t e = 0; e < n; ++e) {
+        memcpy(dst + (uint64_t)e * payload_size, src + (uint64_t)permutation[e] * payload_size, payload_size);
+      }
+      break;
+  }
+
+  free(permutation);
+
+  return graph;
+}
+
+
+// The parallel construction's state shared by all threads;
+// every phase is a fork-join over independent tasks
+
+typedef struct tinygraph_parallel_build {
+  const uint32_t *sources;
+  const uint32_t *targets;
+  uint32_t num_edges;
+  uint32_t num_threads;
+  uint32_t num_nodes;
+  uint32_t num_buckets;
+  uint32_t bucket_width;
+  uint32_t next_bucket;
+  uint32_t *max_nodes;
+  uint32_t *cursors;
+  uint32_t *bucket_starts;
+  uint32_t *bucket_sources;
+  uint32_t *bucket_targets;
+  uint32_t *ends;
+  uint32_t *graph_targets;
+  bool sort_ranges;
+} tinygraph_parallel_build;
+
+
+static void tinygraph_parallel_build_chunk(const tinygraph_parallel_build *build, uint32_t thread, uint32_t *first, uint32_t *last) {
+  *first = (uint32_t)((uint64_t)build->num_edges * thread / build->num_threads);
+  *last = (uint32_t)((uint64_t)build->num_edges * (thread + 1) / build->num_threads);
+}
+
+
+static void tinygraph_parallel_build_max(void *arg, uint32_t thread) {
+  tinygraph_parallel_build *build = arg;
+
+  uint32_t first, last;
+  tinygraph_parallel_build_chunk(build, thread, &first, &last);
+
+  uint32_t max_node = 0;
+
+  for (uint32_t i = first; i < last; ++i) {
+    max_node = tinygraph_max_u32(max_node, tinygraph_max_u32(build->sources[i], build->targets[i]));
+  }
+
+  build->max_nodes[thread] = max_node;
+}
+
+
+static void tinygraph_parallel_build_histogram(void *arg, uint32_t thread) {
+  tinygraph_parallel_build *build = arg;
+
+  uint32_t first, last;
+  tinygraph_parallel_build_chunk(build, thread, &first, &last);
+
+  uint32_t *histogram = build->cursors + (uint64_t)thread * build->num_buckets;
+
+  for (uint32_t i = first; i < last; ++i) {
+    histogram[build->sources[i] / build->bucket_width] += 1;
+  }
+}
+
+
+static void tinygraph_parallel_build_scatter(void *arg, uint32_t thread) {
+  tinygraph_parallel_build *build = arg;
+
+  uint32_t first, last;
+  tinygraph_parallel_build_chunk(build, thread, &first, &last);
+
+  uint32_t *cursors = build->cursors + (uint64_t)thread * build->num_buckets;
+
+  for (uint32_t i = first; i < last; ++i) {
+    const uint32_t pos = cursors[build->sources[i] / build->bucket_width]++;
+
+    build->bucket_sources[pos] = build->sources[i];
+    build->bucket_targets[pos] = build->targets[i];
+  }
+}
+
+
+static void tinygraph_parallel_build_buckets(void *arg, uint32_t thread) {
+  tinygraph_parallel_build *build = arg;
+
+  (void)thread;
+
+  // Buckets differ in size with the graph's degrees, we hand
+  // them out one by one to whichever thread is done first
+
+  while (true) {
+    const uint32_t bucket = __atomic_fetch_add(&build->next_bucket, 1, __ATOMIC_RELAXED);
+
+    if (bucket >= build->num_buckets) {
+      return;
+    }
+
+    const uint32_t first_node = bucket * build->bucket_width;
+    const uint64_t end_node = (uint64_t)first_node + build->bucket_width;
+    const uint32_t last_node = end_node < build->num_nodes ? (uint32_t)end_node : build->num_nodes;
+
+    const uint32_t first = build->bucket_starts[bucket];
+    const uint32_t last = build->bucket_starts[bucket + 1];
+
+    // The serial counting sort restricted to the bucket's nodes
+
+    uint32_t * const ends = build->ends;
+
+    for (uint32_t i = first; i < last; ++i) {
+      ends[build->bucket_sources[i]] += 1;
+    }
+
+    uint32_t sum = first;
+
+    for (uint32_t v = first_node; v < last_node; ++v) {
+      const uint32_t degree = ends[v];
+      ends[v] = sum;
+      sum += degree;
+    }
+
+    TINYGRAPH_ASSERT(sum == last);
+
+    for (uint32_t i = first; i < last; ++i) {
+      build->graph_targets[ends[build->bucket_sources[i]]++] = build->bucket_targets[i];
+    }
+
+    if (!build->sort_ranges) {
+      continue;
+    }
+
+    uint32_t start = first;
+
+    for (uint32_t v = first_node; v < last_node; ++v) {
+      tinygraph_sort_plain_u32(build->graph_targets + start, ends[v] - start);
+
+      start = ends[v];
+    }
+  }
+}
+
+
+// Builds the graph with the edges from sources to targets on
+// num_threads threads; if the edges are in sorted order, all
+// edge ranges come out sorted and we skip sorting them. With
+// num_nodes of zero we derive it from the largest node id
+static tinygraph* tinygraph_construct_parallel(
+    const uint32_t* sources,
+    const uint32_t* targets,
+    uint32_t n,
+    uint32_t num_nodes,
+    uint32_t num_threads,
+    bool sorted)
+{
+  TINYGRAPH_ASSERT(n != UINT32_MAX);
+  TINYGRAPH_ASSERT(n > 0);
+  TINYGRAPH_ASSERT(num_threads > 0);
+
+  TINYGRAPH_ASSERT(sources);
+  TINYGRAPH_ASSERT(targets);
+
+  // We partition the edges by ranges of source nodes into a few
+  // buckets per thread. Each thread counts its chunk of edges
+  // into per-thread bucket histograms and scatters its chunk
+  // into the buckets in input order. The buckets then are
+  // independent counting sorts over their node ranges, writing
+  // disjoint parts of the targets and the ends of the ranges.
+  // All of which results in the serial path's very same graph.
+
+  tinygraph_parallel_build build = {
+    .sources = sources,
+    .targets = targets,
+    .num_edges = n,
+    .num_threads = num_threads,
+    .sort_ranges = !sorted,
+  };
+
+  build.num_nodes = num_nodes;
+
+  if (build.num_nodes == 0) {
+    build.max_nodes = calloc(num_threads, sizeof(uint32_t));
+
+    if (!build.max_nodes) {
+      return NULL;
+    }
+
+    tinygraph_thread_run(num_threads, tinygraph_parallel_build_max, &build);
+
+    uint32_t max_node = 0;
+
+    for (uint32_t t = 0; t < num_threads; ++t) {
+      max_node = tinygraph_max_u32(max_node, build.max_nodes[t]);
+    }
+
+    free(build.max_nodes);
+    build.max_nodes = NULL;
+
+    TINYGRAPH_ASSERT(max_node != UINT32_MAX);
+
+    build.num_nodes = max_node + 1;
+  }
+
+  const uint64_t wanted_buckets = (uint64_t)num_threads * 8;
+
+  build.bucket_width = (uint32_t)(((uint64_t)build.num_nodes + wanted_buckets - 1) / wanted_buckets);
+  build.num_buckets = (uint32_t)(((uint64_t)build.num_nodes + build.bucket_width - 1) / build.bucket_width);
+
+  tinygraph *graph = tinygraph_construct_empty();
+
+  build.cursors = calloc((uint64_t)num_threads * build.num_buckets, sizeof(uint32_t));
+  build.bucket_starts = calloc((uint64_t)build.num_buckets + 1, sizeof(uint32_t));
+  build.bucket_sources = malloc((uint64_t)n * sizeof(uint32_t));
+  build.bucket_targets = malloc((uint64_t)n * sizeof(uint32_t));
+  build.ends = calloc(build.num_nodes, sizeof(uint32_t));
+
+  if (!graph || !build.cursors || !build.bucket_starts || !build.bucket_sources
+      || !build.bucket_targets || !build.ends || !tinygraph_reserve(graph, build.num_nodes, n)) {
+    free(build.ends);
+    free(build.bucket_targets);
+    free(build.bucket_sources);
+    free(build.bucket_starts);
+    free(build.cursors);
+    tinygraph_destruct(graph);
+
+    return NULL;
+  }
+
+  build.graph_targets = graph->targets;
+
+  tinygraph_thread_run(num_threads, tinygraph_parallel_build_histogram, &build);
+
+  // Bucket major, thread minor: each thread's edges go into
+  // the buckets after the edges of all threads before it
+
+  uint32_t sum = 0;
+
+  for (uint32_t b = 0; b < build.num_buckets; ++b) {
+    build.bucket_starts[b] = sum;
+
+    for (uint32_t t = 0; t < num_threads; ++t) {
+      uint32_t * const cursor = &build.cursors[(uint64_t)t * build.num_buckets + b];
+
+      const uint32_t count = *cursor;
+      *cursor = sum;
+      sum += count;
+    }
+  }
+
+  build.bucket_starts[build.num_buckets] = sum;
+
+  TINYGRAPH_ASSERT(sum == n);
+
+  tinygraph_thread_run(num_threads, tinygraph_parallel_build_scatter, &build);
+  tinygraph_thread_run(num_threads, tinygraph_parallel_build_buckets, &build);
+
+  uint32_t start = 0;
+
+  for (uint32_t v = 0; v < build.num_nodes; ++v) {
+    tinygraph_offsets_set(graph, v, start);
+
+    start = build.ends[v];
+  }
+
+  TINYGRAPH_ASSERT(start == n);
+
+  free(build.ends);
+  free(build.bucket_targets);
+  free(build.bucket_sources);
+  free(build.bucket_starts);
+  free(build.cursors);
+
+  if (!tinygraph_offsets_build(graph)) {
+    tinygraph_destruct(graph);
+
+    return NULL;
+  }
+
+  return graph;
+}
+
+
+tinygraph_s tinygraph_construct_from_unsorted_edges_parallel(
+    const uint32_t* sources,
+    const uint32_t* targets,
+    uint32_t n,
+    uint32_t num_threads)
+{
+  TINYGRAPH_ASSERT(n != UINT32_MAX);
+
+  if (num_threads < 2 || n == 0) {
+    return tinygraph_construct_from_unsorted_edges(sources, targets, n);
+  }
+
+  return tinygraph_construct_parallel(sources, targets, n, 0, num_threads, false);
+}
+
+
+// The parallel transposition's state: the forward edges'
+// sources, and their targets for compressed graphs
+
+typedef struct tinygraph_parallel_reverse {
+  const tinygraph *graph;
+  uint32_t num_threads;
+  uint32_t *sources;
+  uint32_t *targets;
+} tinygraph_parallel_reverse;
+
+
+static void tinygraph_parallel_reverse_edges(void *arg, uint32_t thread) {
+  tinygraph_parallel_reverse *reverse = arg;
+
+  const uint32_t num_nodes = reverse->graph->num_nodes;
+
+  const uint32_t first = (uint32_t)((uint64_t)num_nodes * thread / reverse->num_threads);
+  const uint32_t last = (uint32_t)((uint64_t)num_nodes * (thread + 1) / reverse->num_threads);
+
+  if (first == last) {
+    return;
+  }
+
+  uint32_t i, end;
+  tinygraph_get_out_edges(reverse->graph, first, &i, &end);
+
+  for (uint32_t s = first; s < last; ++s) {
+    tinygraph_neighbors_it it;
+    uint32_t t;
+
+    tinygraph_neighbors_begin(reverse->graph, &it, s);
+
+    while (tinygraph_neighbors_next(&it, &t)) {
+      reverse->sources[i] = s;
+
+      if (reverse->targets) {
+        reverse->targets[i] = t;
+      }
+
+      i += 1;
+    }
+  }
+}
+
+
+tinygraph_s tinygraph_copy_reversed_parallel(const tinygraph * const graph, uint32_t num_threads) {
+  TINYGRAPH_ASSERT(graph);
+
+  const uint32_t n = tinygraph_get_num_edges(graph);
+
+  if (num_threads < 2 || tinygraph_is_empty(graph) || n == 0) {
+    return tinygraph_copy_reversed(graph);
+  }
+
+  // The transposition is the parallel construction from the
+  // reversed edges, which we materialize in parallel, too;
+  // uncompressed graphs have their targets readily available.
+  // With the edges in forward order the scatter is stable and
+  // all reversed edge ranges come out sorted already.
+
+  tinygraph_parallel_reverse reverse = {
+    .graph = graph,
+    .num_threads = num_threads,
+    .sources = malloc((uint64_t)n * sizeof(uint32_t)),
+    .targets = NULL,
+  };
+
+  if (!graph->targets) {
+    reverse.targets = malloc((uint64_t)n * sizeof(uint32_t));
+  }
+
+  if (!reverse.sources || (!graph->targets && !reverse.targets)) {
+    free(reverse.sources);
+    free(reverse.targets);
+
+    return NULL;
+  }
+
+  tinygraph_thread_run(num_threads, tinygraph_parallel_reverse_edges, &reverse);
+
+  const uint32_t *targets = graph->targets ? graph->targets : reverse.targets;
+
+  tinygraph *copy = tinygraph_construct_parallel(targets, reverse.sources, n, graph->num_nodes, num_threads, true);
+
+  free(reverse.sources);
+  free(reverse.targets);
+
+  return copy;
+}
+
+
+void tinygraph_destruct(tinygraph * const graph) {
+  if (!graph) {
+    return;
+  }
+
+  TINYGRAPH_ASSERT(graph->offsets || graph->num_nodes == 0);
+  TINYGRAPH_ASSERT(graph->targets || graph->targets_len == 0 || graph->bytes);
+
+  tinygraph_rankselect_destruct(graph->offsets_rs);
+  tinygraph_bitset_destruct(graph->offsets);
+  free(graph->targets);
+
+  tinygraph_rankselect_destruct(graph->bytes_offsets_rs);
+  tinygraph_bitset_destruct(graph->bytes_offsets);
+  free(graph->bytes);
+
+  for (uint32_t i = 0; i < graph->hubs_len; ++i) {
+    tinygraph_eliasfano_destruct(graph->hubs[i]);
+  }
+
+  free(graph->hubs);
+  free(graph->hubs_nodes);
+
+  graph->offsets_rs = NULL;
+  graph->offsets = NULL;
+  graph->targets = NULL;
+
+  graph->bytes_offsets_rs = NULL;
+  graph->bytes_offsets = NULL;
+  graph->bytes = NULL;
+
+  graph->hubs = NULL;
+  graph->hubs_nodes = NULL;
+
+  graph->num_nodes = 0;
+  graph->targets_len = 0;
+  graph->bytes_len = 0;
+  graph->hubs_len = 0;
+
+  free(graph);
+}
+
+
+bool tinygraph_is_empty(const tinygraph * const graph) {
+  TINYGRAPH_ASSERT(graph);
+
+  return tinygraph_get_num_nodes(graph) == 0;
+}
+
+
+bool tinygraph_is_compressed(const tinygraph * const graph) {
+  TINYGRAPH_ASSERT(graph);
+
+  return graph->bytes != NULL;
+}
+
+
+uint32_t tinygraph_get_num_nodes(const tinygraph * const graph) {
+  TINYGRAPH_ASSERT(graph);
+
+  return graph->num_nodes;
+}
+
+
+uint32_t tinygraph_get_num_edges(const tinygraph * const graph) {
+  TINYGRAPH_ASSERT(graph);
+
+  return graph->targets_len;
+}
+
+
+void tinygraph_get_out_edges(
+    const tinygraph * const graph,
+    uint32_t source,
+    uint32_t* first,
+    uint32_t* last)
+{
+  TINYGRAPH_ASSERT(graph);
+  TINYGRAPH_ASSERT(tinygraph_has_node(graph, source));
+  TINYGRAPH_ASSERT(first);
+  TINYGRAPH_ASSERT(last);
+
+  TINYGRAPH_ASSERT(graph->offsets);
+  TINYGRAPH_ASSERT(graph->offsets_rs);
+
+  // The node's bit in the offsets is at select(v), its
+  // out edges are the zeros up to the next set bit.
+  // For most nodes it is in the same or the next 64 bit
+  // block; for hubs we select it instead of scanning.
+  const uint64_t p = tinygraph_rankselect_select(graph->offsets_rs, source);
+
+  const uint64_t *blocks = tinygraph_bitset_get_data(graph->offsets);
+  const uint64_t size = tinygraph_bitset_get_size(graph->offsets);
+
+  const uint64_t i = p + 1;
+  const uint64_t b = i >> 6;
+
+  uint64_t q;
+  uint64_t block = blocks[b] & (UINT64_MAX << (i & UINT64_C(63)));
+
+  if (TINYGRAPH_LIKELY(block != 0)) {
+    q = (b << 6) + (uint64_t)__builtin_ctzll(block);
+  } else if (((b + 1) << 6) < size && (block = blocks[b + 1]) != 0) {
+    q = ((b + 1) << 6) + (uint64_t)__builtin_ctzll(block);
+  } else {
+    q = tinygraph_rankselect_select(graph->offsets_rs, source + 1);
+  }
+
+  TINYGRAPH_ASSERT(q > p && tinygraph_bitset_get_at(graph->offsets, q));
+
+  *first = p - source;
+  *last = q - (source + 1);
+
+  // TODO: benchmark if prefetching edge range has an impact
+  // TINYGRAPH_PREFETCH(graph->targets[*first]);
+
+  TINYGRAPH_ASSERT(*first <= *last);
+}
+
+
+// Returns the Elias-Fano coded targets of hub node v
+TINYGRAPH_WARN_UNUSED
+static inline tinygraph_eliasfano_const_s tinygraph_find_hub(
+    const tinygraph * const graph,
+    uint32_t v)
+{
+  TINYGRAPH_ASSERT(graph);
+  TINYGRAPH_ASSERT(graph->hubs_len > 0);
+
+  const uint32_t *first = graph->hubs_nodes;
+  const uint32_t *last = graph->hubs_nodes + graph->hubs_len;
+
+  const uint32_t *it = tinygraph_binary_search_u32(first, last, v);
+
+  TINYGRAPH_ASSERT(it != last);
+  TINYGRAPH_ASSERT(*it == v);
+
+  return graph->hubs[it - first];
+}
+
+
+uint32_t tinygraph_get_edge_target(const tinygraph * const graph, uint32_t e) {
+  TINYGRAPH_ASSERT(graph);
+  TINYGRAPH_ASSERT(tinygraph_has_edge(graph, e));
+
+  if (TINYGRAPH_LIKELY(!tinygraph_is_compressed(graph))) {
+    return graph->targets[e];
+  }
+
+  // Slow path for compressed graphs: binary search for the
+  // last node whose edge range starts at or before e, then
+  // decode the node's targets up to and including edge e.
+
+  uint32_t first = 0;
+  uint32_t len = graph->num_nodes;
+
+  while (len > 0) {
+    const uint32_t half = len / 2;
+    const uint32_t v = first + half;
+
+    const uint64_t start = tinygraph_rankselect_select(graph->offsets_rs, v) - v;
+
+    if (start <= e) {
+      first = v + 1;
+      len = len - half - 1;
+    } else {
+      len = half;
+    }
+  }
+
+  TINYGRAPH_ASSERT(first > 0);
+
+  const uint32_t source = first - 1;
+
+  uint32_t efirst, elast;
+
+  tinygraph_get_out_edges(graph, source, &efirst, &elast);
+
+  TINYGRAPH_ASSERT(efirst <= e);
+  TINYGRAPH_ASSERT(e < elast);
+
+  if (elast - efirst >= TINYGRAPH_HUB_DEGREE) {
+    return tinygraph_eliasfano_access(tinygraph_find_hub(graph, source), e - efirst);
+  }
+
+  tinygraph_neighbors_it it;
+  uint32_t target = 0;
+
+  tinygraph_neighbors_begin(graph, &it, source);
+
+  for (uint32_t i = efirst; i <= e; ++i) {
+    const bool ok = tinygraph_neighbors_next(&it, &target);
+    TINYGRAPH_ASSERT(ok);
+    (void)ok;
+  }
+
+  return target;
+}
+
+
+uint32_t tinygraph_get_out_degree(const tinygraph * const graph, uint32_t v) {
+  TINYGRAPH_ASSERT(graph);
+  TINYGRAPH_ASSERT(tinygraph_has_node(graph, v));
+
+  uint32_t efirst;
+  uint32_t elast;
+
+  tinygraph_get_out_edges(graph, v, &efirst, &elast);
+
+  TINYGRAPH_ASSERT(efirst <= elast);
+
+  return elast - efirst;
+}
+
+
+void tinygraph_get_neighbors(
+    const tinygraph * const graph,
+    const uint32_t **first,
+    const uint32_t **last,
+    uint32_t v)
+{
+  TINYGRAPH_ASSERT(graph);
+  TINYGRAPH_ASSERT(first);
+  TINYGRAPH_ASSERT(last);
+  TINYGRAPH_ASSERT(tinygraph_has_node(graph, v));
+  TINYGRAPH_ASSERT(!tinygraph_is_compressed(graph));
+
+  uint32_t efirst;
+  uint32_t elast;
+
+  tinygraph_get_out_edges(graph, v, &efirst, &elast);
+
+  *first = &graph->targets[efirst];
+  *last = &graph->targets[elast];
+
+  // TODO: benchmark if prefetching edge range has an impact
+  // TINYGRAPH_PREFETCH(graph->targets[graph->offsets[source]]);
+}
+
+
+// Initializes the neighbors iterator for node v with its
+// already known edge range [efirst, elast), saving us the
+// select on the offsets when the caller needs the edges
+static inline void tinygraph_neighbors_begin_range(
+    const tinygraph * const graph,
+    tinygraph_neighbors_it *it,
+    uint32_t v,
+    uint32_t efirst,
+    uint32_t elast)
+{
+  TINYGRAPH_ASSERT(graph);
+  TINYGRAPH_ASSERT(it);
+  TINYGRAPH_ASSERT(efirst <= elast);
+
+  if (!tinygraph_is_compressed(graph)) {
+    *it = (tinygraph_neighbors_it){
+      .targets = graph->targets + efirst,
+      .bytes = NULL,
+      .hub = NULL,
+      .pos = 0,
+      .prev = v,
+      .left = elast - efirst,
+      .head = true,
+    };
+
+    return;
+  }
+
+  // Empty ranges don't need to find their byte offset
+  if (efirst == elast) {
+    *it = (tinygraph_neighbors_it){
+      .targets = NULL,
+      .bytes = graph->bytes,
+      .hub = NULL,
+      .pos = 0,
+      .prev = v,
+      .left = 0,
+      .head = true,
+    };
+
+    return;
+  }
+
+  // Hubs decode sequentially from their Elias-Fano
+  // structure, with prev counting the decoded targets
+  if (elast - efirst >= TINYGRAPH_HUB_DEGREE) {
+    *it = (tinygraph_neighbors_it){
+      .targets = NULL,
+      .bytes = NULL,
+      .hub = tinygraph_find_hub(graph, v),
+      .pos = 0,
+      .prev = 0,
+      .left = elast - efirst,
+      .head = false,
+    };
+
+    return;
+  }
+
+  const uint64_t p = tinygraph_rankselect_select(graph->bytes_offsets_rs, v);
+
+  *it = (tinygraph_neighbors_it){
+    .targets = NULL,
+    .bytes = graph->bytes + (p - v),
+    .hub = NULL,
+    .pos = 0,
+    .prev = v,
+    .left = elast - efirst,
+    .head = true,
+  };
+}
+
+
+void tinygraph_neighbors_begin(
+    const tinygraph * const graph,
+    tinygraph_neighbors_it *it,
+    uint32_t v)
+{
+  TINYGRAPH_ASSERT(graph);
+  TINYGRAPH_ASSERT(it);
+  TINYGRAPH_ASSERT(tinygraph_has_node(graph, v));
+
+  uint32_t efirst;
+  uint32_t elast;
+
+  tinygraph_get_out_edges(graph, v, &efirst, &elast);
+
+  tinygraph_neighbors_begin_range(graph, it, v, efirst, elast);
+}
+
+
+bool tinygraph_neighbors_next(tinygraph_neighbors_it *it, uint32_t *target) {
+  TINYGRAPH_ASSERT(it);
+  TINYGRAPH_ASSERT(target);
+
+  if (it->left == 0) {
+    return false;
+  }
+
+  it->left -= 1;
+
+  if (it->targets) {
+    *target = *it->targets++;
+
+    return true;
+  }
+
+  if (it->hub) {
+    *target = tinygraph_eliasfano_decode_next(it->hub, it->prev, &it->pos);
+    it->prev += 1;
+
+    return true;
+  }
+
+  // The first target is a zig-zag coded gap relative
+  // to the source node, all others are plain gaps
+  // to their previous target in the sorted range.
+
+  uint32_t gap;
+
+  it->bytes += tinygraph_vbyte_decode_one(it->bytes, &gap);
+
+  if (it->head) {
+    it->prev = it->prev + (uint32_t)tinygraph_zigzag_decode(gap);
+    it->head = false;
+  } else {
+    it->prev = it->prev + gap;
+  }
+
+  *target = it->prev;
+
+  return true;
+}
+
+
+bool tinygraph_has_node(const tinygraph * const graph, uint32_t v) {
+  TINYGRAPH_ASSERT(graph);
+
+  return v < tinygraph_get_num_nodes(graph);
+}
+
+
+bool tinygraph_has_edge(const tinygraph * const graph, uint32_t e) {
+  TINYGRAPH_ASSERT(graph);
+
+  return e < tinygraph_get_num_edges(graph);
+}
+
+
+bool tinygraph_has_edge_from_to(
+    const tinygraph * const graph,
+    uint32_t source,
+    uint32_t target)
+{
+  TINYGRAPH_ASSERT(tinygraph_has_node(graph, source));
+  TINYGRAPH_ASSERT(tinygraph_has_node(graph, target));
+
+  const uint32_t degree = tinygraph_get_out_degree(graph, source);
+
+  // Large adjacency lists are sorted, binary search them
+  // in flat graphs and use Elias-Fano in compressed ones
+
+  if (degree >= TINYGRAPH_HUB_DEGREE && tinygraph_is_compressed(graph)) {
+    uint32_t t;
+
+    const tinygraph_eliasfano_const_s hub = tinygraph_find_hub(graph, source);
+
+    return tinygraph_eliasfano_next_geq(hub, target, &t) && t == target;
+  }
+
+  if (tinygraph_is_compressed(graph)) {
+    tinygraph_neighbors_it it;
+    uint32_t t;
+
+    tinygraph_neighbors_begin(graph, &it, source);
+
+    // targets are sorted, stop as soon as we're past
+    while (tinygraph_neighbors_next(&it, &t)) {
+      if (t >= target) {
+        return t == target;
+      }
+    }
+
+    return false;
+  }
+
+  const uint32_t *it, *last;
+
+  tinygraph_get_neighbors(graph, &it, &last, source);
+
+  if (degree >= TINYGRAPH_HUB_DEGREE) {
+    it = tinygraph_binary_search_u32(it, last, target);
+
+    return it != last && *it == target;
+  }
+
+  return tinygraph_find_if_u32(it, last, target) != last;
+
+  // TODO: benchmark if prefetching edge range has an impact
+  // TINYGRAPH_PREFETCH(graph->targets[graph->offsets[source]]);
+}
+
+
+void tinygraph_apsp(const tinygraph * const graph, const uint8_t* weights, uint8_t* results) {
+  TINYGRAPH_ASSERT(graph);
+  TINYGRAPH_ASSERT(weights);
+  TINYGRAPH_ASSERT(results);
+
+  const uint64_t num_nodes = tinygraph_get_num_nodes(graph);
+
+  for (uint32_t i = 0; i < num_nodes; ++i) {
+    for (uint32_t j = 0; j < num_nodes; ++j) {
+      results[i * num_nodes + j] = -1;
+    }
+  }
+
+  TINYGRAPH_FOR_EACH_NODE(source, graph) {
+    uint32_t efirst, elast;
+
+    tinygraph_get_out_edges(graph, source, &efirst, &elast);
+
+    tinygraph_neighbors_it it;
+    uint32_t target;
+
+    tinygraph_neighbors_begin_range(graph, &it, source, efirst, elast);
+
+    for (; tinygraph_neighbors_next(&it, &target); ++efirst) {
+      const uint32_t edge = efirst;
+
+      uint8_t *out = &results[source * num_nodes + target];
+
+      *out = tinygraph_min_u32(weights[edge], *out);
+    }
+  }
+
+  TINYGRAPH_FOR_EACH_NODE(v, graph) {
+    const uint32_t source = v;
+    const uint32_t target = v;
+
+    results[source * num_nodes + target] = 0;
   }
 
   TINYGRAPH_FOR_EACH_NODE(k, graph) {
@@ -405,141 +1602,1789 @@ void tinygraph_apsp(const tinygraph * const graph, const uint8_t* weights, uint8
         const uint8_t ik = results[i * num_nodes + k];
         const uint8_t kj = results[k * num_nodes + j];
 
-        const uint8_t sum = tinygraph_saturated_add_u8(ik, kj);
+        const uint8_t sum = tinygraph_saturated_add_u8(ik, kj);
+
+        if (ij > sum) {
+          results[i * num_nodes + j] = sum;
+        }
+      }
+    }
+  }
+}
+
+
+void tinygraph_print(const tinygraph * const graph) {
+  TINYGRAPH_ASSERT(graph);
+
+  fprintf(stderr, "graph %p with nodes=%ju, edges=%ju of %ju bytes total\n",
+      (const void *)graph,
+      (uintmax_t)tinygraph_get_num_nodes(graph),
+      (uintmax_t)tinygraph_get_num_edges(graph),
+      (uintmax_t)tinygraph_size_in_bytes(graph));
+
+  TINYGRAPH_FOR_EACH_NODE(s, graph) {
+    tinygraph_neighbors_it it;
+    uint32_t t;
+
+    tinygraph_neighbors_begin(graph, &it, s);
+
+    fprintf(stderr, "%ju:", (uintmax_t)s);
+
+    while (tinygraph_neighbors_next(&it, &t)) {
+      fprintf(stderr, " (%ju -> %ju)", (uintmax_t)s, (uintmax_t)t);
+    }
+
+    fprintf(stderr, "\n");
+  }
+
+  //tinygraph_print_internal(graph);
+}
+
+
+uint32_t tinygraph_size_in_bytes(const tinygraph * const graph) {
+  TINYGRAPH_ASSERT(graph);
+
+  uint64_t size = sizeof(tinygraph);
+
+  if (graph->targets) {
+    size += sizeof(uint32_t) * graph->targets_len;
+  }
+
+  if (graph->offsets) {
+    size += tinygraph_bitset_get_size_in_bytes(graph->offsets);
+  }
+
+  if (graph->offsets_rs) {
+    size += tinygraph_rankselect_get_size_in_bytes(graph->offsets_rs);
+  }
+
+  if (graph->bytes) {
+    size += graph->bytes_len;
+  }
+
+  if (graph->bytes_offsets) {
+    size += tinygraph_bitset_get_size_in_bytes(graph->bytes_offsets);
+  }
+
+  if (graph->bytes_offsets_rs) {
+    size += tinygraph_rankselect_get_size_in_bytes(graph->bytes_offsets_rs);
+  }
+
+  size += graph->hubs_len * (sizeof(tinygraph_eliasfano_s) + sizeof(uint32_t));
+
+  for (uint32_t i = 0; i < graph->hubs_len; ++i) {
+    size += tinygraph_eliasfano_get_size_in_bytes(graph->hubs[i]);
+  }
+
+  return size > UINT32_MAX ? UINT32_MAX : size;
+}
+
+
+bool tinygraph_reorder(
+    uint32_t* nodes,
+    const uint16_t* lngs,
+    const uint16_t* lats,
+    uint32_t n)
+{
+  return tinygraph_reorder_curve(nodes, lngs, lats, n, TINYGRAPH_CURVE_ZORDER);
+}
+
+
+bool tinygraph_reorder_curve(
+    uint32_t* nodes,
+    const uint16_t* lngs,
+    const uint16_t* lats,
+    uint32_t n,
+    tinygraph_curve curve)
+{
+  if (n == 0) {
+    return true;
+  }
+
+  TINYGRAPH_ASSERT(nodes);
+  TINYGRAPH_ASSERT(lngs);
+  TINYGRAPH_ASSERT(lats);
+  TINYGRAPH_ASSERT(curve == TINYGRAPH_CURVE_ZORDER || curve == TINYGRAPH_CURVE_HILBERT);
+
+  // Reorder graph nodes spatially based on a space
+  // filling curve to improve memory locality; we
+  // radix sort the nodes keyed by their curve position
+
+  uint64_t *keys = malloc(n * sizeof(uint64_t));
+
+  if (!keys) {
+    return false;
+  }
+
+  switch (curve) {
+    case TINYGRAPH_CURVE_ZORDER:
+      for (uint32_t i = 0; i < n; ++i) {
+        keys[i] = tinygraph_zorder_encode32(lngs[nodes[i]], lats[nodes[i]]);
+      }
+      break;
+    case TINYGRAPH_CURVE_HILBERT:
+      for (uint32_t i = 0; i < n; ++i) {
+        keys[i] = tinygraph_hilbert_encode32(lngs[nodes[i]], lats[nodes[i]]);
+      }
+      break;
+    default:
+      TINYGRAPH_UNREACHABLE();
+  }
+
+  const bool ok = tinygraph_radix_sort_u64_u32(keys, nodes, n, 0);
+
+  free(keys);
+
+  return ok;
+}
+
+
+uint32_t tinygraph_reorder_coarse_bits(const uint64_t *keys, uint32_t n) {
+  TINYGRAPH_ASSERT(keys || n == 0);
+
+  if (n == 0) {
+    return 0;
+  }
+
+  // We want the nodes in a memory page worth of node ids
+  // to be close but don't care about their order within
+  // the page. With nodes spread evenly, the curve's cells
+  // on level l hold n / 4^l nodes: we go down to the level
+  // with cells of about a page plus four levels, so that
+  // dense areas such as cities still get split up
+
+  uint64_t min = keys[0];
+  uint64_t max = keys[0];
+
+  for (uint32_t i = 1; i < n; ++i) {
+    min = min < keys[i] ? min : keys[i];
+    max = max > keys[i] ? max : keys[i];
+  }
+
+  if (min == max) {
+    return 0;
+  }
+
+  // Keys sharing a prefix with the min and the max key
+  // share it with all keys; we only sort below that
+
+  const uint32_t width = 64 - tinygraph_bits_leading0_u64(min ^ max);
+
+  const uint32_t pages = (n + TINYGRAPH_REORDER_PAGE_NODES - 1) / TINYGRAPH_REORDER_PAGE_NODES;
+  const uint32_t levels = (pages <= 1 ? 0 : (32 - tinygraph_bits_leading0_u32(pages - 1)) + 1) / 2 + 4;
+
+  return width > 2 * levels ? width - 2 * levels : 0;
+}
+
+
+bool tinygraph_reorder32(
+    uint32_t* nodes,
+    const uint32_t* lngs,
+    const uint32_t* lats,
+    uint32_t n,
+    tinygraph_curve curve,
+    bool coarse)
+{
+  if (n == 0) {
+    return true;
+  }
+
+  TINYGRAPH_ASSERT(nodes);
+  TINYGRAPH_ASSERT(lngs);
+  TINYGRAPH_ASSERT(lats);
+  TINYGRAPH_ASSERT(curve == TINYGRAPH_CURVE_ZORDER || curve == TINYGRAPH_CURVE_HILBERT);
+
+  uint64_t *keys = malloc(n * sizeof(uint64_t));
+
+  if (!keys) {
+    return false;
+  }
+
+  switch (curve) {
+    case TINYGRAPH_CURVE_ZORDER:
+      for (uint32_t i = 0; i < n; ++i) {
+        keys[i] = tinygraph_zorder_encode64(lngs[nodes[i]], lats[nodes[i]]);
+      }
+      break;
+    case TINYGRAPH_CURVE_HILBERT:
+      for (uint32_t i = 0; i < n; ++i) {
+        keys[i] = tinygraph_hilbert_encode64(lngs[nodes[i]], lats[nodes[i]]);
+      }
+      break;
+    default:
+      TINYGRAPH_UNREACHABLE();
+  }
+
+  // The coarse order skips the passes for the low digits
+
+  const uint32_t skip_bits = coarse ? tinygraph_reorder_coarse_bits(keys, n) : 0;
+
+  const bool ok = tinygraph_radix_sort_u64_u32(keys, nodes, n, skip_bits);
+
+  free(keys);
+
+  return ok;
+}
+
+
+// Writes all nodes into `order`, sorted by their total
+// degree of out and in edges with a counting sort; ties
+// keep ascending node ids. Writes the degrees into the
+// optional `out_degrees` for callers needing them, too.
+TINYGRAPH_WARN_UNUSED
+static bool tinygraph_sort_by_degree(
+    const tinygraph * const graph,
+    const tinygraph * const reversed,
+    uint32_t *order,
+    uint32_t *out_degrees,
+    bool descending)
+{
+  const uint32_t num_nodes = tinygraph_get_num_nodes(graph);
+
+  uint32_t *degrees = out_degrees ? out_degrees : malloc(num_nodes * sizeof(uint32_t));
+
+  if (!degrees) {
+    return false;
+  }
+
+  uint32_t max_degree = 0;
+
+  for (uint32_t v = 0; v < num_nodes; ++v) {
+    degrees[v] = tinygraph_get_out_degree(graph, v) + tinygraph_get_out_degree(reversed, v);
+    max_degree = tinygraph_max_u32(max_degree, degrees[v]);
+  }
+
+  uint32_t *starts = calloc((uint64_t)max_degree + 1, sizeof(uint32_t));
+
+  if (!starts) {
+    if (!out_degrees) {
+      free(degrees);
+    }
+
+    return false;
+  }
+
+  for (uint32_t v = 0; v < num_nodes; ++v) {
+    starts[descending ? max_degree - degrees[v] : degrees[v]] += 1;
+  }
+
+  uint32_t sum = 0;
+
+  for (uint32_t d = 0; d <= max_degree; ++d) {
+    const uint32_t count = starts[d];
+    starts[d] = sum;
+    sum += count;
+  }
+
+  for (uint32_t v = 0; v < num_nodes; ++v) {
+    order[starts[descending ? max_degree - degrees[v] : degrees[v]]++] = v;
+  }
+
+  free(starts);
+
+  if (!out_degrees) {
+    free(degrees);
+  }
+
+  return true;
+}
+
+
+bool tinygraph_reorder_degree(const tinygraph * const graph, uint32_t* nodes) {
+  TINYGRAPH_ASSERT(graph);
+
+  if (tinygraph_is_empty(graph)) {
+    return true;
+  }
+
+  TINYGRAPH_ASSERT(nodes);
+
+  // Hubs first: the few nodes most edges point to or
+  // come from share their cache lines with each other
+
+  tinygraph *reversed = tinygraph_copy_reversed(graph);
+
+  if (!reversed) {
+    return false;
+  }
+
+  const bool ok = tinygraph_sort_by_degree(graph, reversed, nodes, NULL, true);
+
+  tinygraph_destruct(reversed);
+
+  return ok;
+}
+
+
+bool tinygraph_reorder_rcm(const tinygraph * const graph, uint32_t* nodes) {
+  TINYGRAPH_ASSERT(graph);
+
+  if (tinygraph_is_empty(graph)) {
+    return true;
+  }
+
+  TINYGRAPH_ASSERT(nodes);
+
+  // Reverse Cuthill-McKee on the graph with its edges
+  // taken as undirected: a breadth first search visiting
+  // neighbors by ascending degree, starting each of the
+  // components at its node with the smallest degree.
+  // The search order gives a small bandwidth, that is
+  // small gaps between neighbors; reversing it reduces
+  // the fill-in for sparse matrix factorization, and we
+  // keep it for comparability with other implementations.
+
+  const uint32_t num_nodes = tinygraph_get_num_nodes(graph);
+
+  tinygraph *reversed = tinygraph_copy_reversed(graph);
+  uint32_t *starts = malloc(num_nodes * sizeof(uint32_t));
+  uint32_t *degrees = malloc(num_nodes * sizeof(uint32_t));
+  tinygraph_bitset_s seen = tinygraph_bitset_construct(num_nodes);
+  tinygraph_queue_s queue = tinygraph_queue_construct();
+  tinygraph_array_s frontier = tinygraph_array_construct(0);
+
+  if (!reversed || !starts || !degrees || !seen || !queue || !frontier
+      || !tinygraph_queue_reserve(queue, num_nodes)) {
+    tinygraph_array_destruct(frontier);
+    tinygraph_queue_destruct(queue);
+    tinygraph_bitset_destruct(seen);
+    free(degrees);
+    free(starts);
+    tinygraph_destruct(reversed);
+
+    return false;
+  }
+
+  bool ok = tinygraph_sort_by_degree(graph, reversed, starts, degrees, false);
+
+  uint32_t pos = 0;
+
+  for (uint32_t i = 0; ok && i < num_nodes; ++i) {
+    const uint32_t s = starts[i];
+
+    if (tinygraph_bitset_get_at(seen, s)) {
+      continue;
+    }
+
+    tinygraph_bitset_set_at(seen, s);
+    ok = tinygraph_queue_push(queue, s);
+
+    while (ok && !tinygraph_queue_is_empty(queue)) {
+      const uint32_t u = tinygraph_queue_pop(queue);
+
+      nodes[pos++] = u;
+
+      // The unseen neighbors, sorted by degree below
+
+      tinygraph_array_clear(frontier);
+
+      tinygraph_neighbors_it it;
+      uint32_t v;
+
+      tinygraph_neighbors_begin(graph, &it, u);
+
+      while (ok && tinygraph_neighbors_next(&it, &v)) {
+        if (!tinygraph_bitset_get_at(seen, v)) {
+          tinygraph_bitset_set_at(seen, v);
+          ok = tinygraph_array_push(frontier, v);
+        }
+      }
+
+      const uint32_t *first, *last;
+      tinygraph_get_neighbors(reversed, &first, &last, u);
+
+      for (; ok && first != last; ++first) {
+        if (!tinygraph_bitset_get_at(seen, *first)) {
+          tinygraph_bitset_set_at(seen, *first);
+          ok = tinygraph_array_push(frontier, *first);
+        }
+      }
+
+      // Sort by degree and node id: insertion sort for the
+      // few neighbors most nodes have, radix sort on packed
+      // (degree, node) keys for hubs' large frontiers
+
+      const uint32_t len = tinygraph_array_get_size(frontier);
+
+      if (ok && len > 32) {
+        uint64_t *keys = malloc(len * sizeof(uint64_t));
+
+        ok = keys != NULL;
+
+        for (uint32_t j = 0; ok && j < len; ++j) {
+          const uint32_t w = tinygraph_array_get_at(frontier, j);
+
+          keys[j] = (uint64_t)degrees[w] << 32 | w;
+        }
+
+        ok = ok && tinygraph_radix_sort_u64(keys, len);
+
+        for (uint32_t j = 0; ok && j < len; ++j) {
+          tinygraph_array_set_at(frontier, j, (uint32_t)keys[j]);
+        }
+
+        free(keys);
+      }
+
+      for (uint32_t j = 1; ok && len <= 32 && j < len; ++j) {
+        const uint32_t w = tinygraph_array_get_at(frontier, j);
+        uint32_t k = j;
+
+        for (; k > 0; --k) {
+          const uint32_t prev = tinygraph_array_get_at(frontier, k - 1);
+
+          if (degrees[prev] < degrees[w] || (degrees[prev] == degrees[w] && prev < w)) {
+            break;
+          }
+
+          tinygraph_array_set_at(frontier, k, prev);
+        }
+
+        tinygraph_array_set_at(frontier, k, w);
+      }
+
+      for (uint32_t j = 0; ok && j < len; ++j) {
+        ok = tinygraph_queue_push(queue, tinygraph_array_get_at(frontier, j));
+      }
+    }
+  }
+
+  TINYGRAPH_ASSERT(!ok || pos == num_nodes);
+
+  for (uint32_t i = 0; ok && i < num_nodes / 2; ++i) {
+    const uint32_t tmp = nodes[i];
+    nodes[i] = nodes[num_nodes - 1 - i];
+    nodes[num_nodes - 1 - i] = tmp;
+  }
+
+  tinygraph_array_destruct(frontier);
+  tinygraph_queue_destruct(queue);
+  tinygraph_bitset_destruct(seen);
+  free(degrees);
+  free(starts);
+  tinygraph_destruct(reversed);
+
+  return ok;
+}
+
+
+// Gorder's score change for all nodes related to node u
+// when u enters (+1) or leaves (-1) the window: the nodes
+// u has an edge from or to, and the nodes sharing an in
+// neighbor with u; each change gets pushed into the max
+// heap lazily, outdated entries get skipped when popped
+TINYGRAPH_WARN_UNUSED
+static bool tinygraph_gorder_update(
+    const tinygraph * const graph,
+    const tinygraph * const reversed,
+    tinygraph_bitset_const_s placed,
+    uint32_t *scores,
+    tinygraph_heap_s heap,
+    uint32_t u,
+    bool enter)
+{
+  tinygraph_neighbors_it it;
+  uint32_t v;
+
+  bool ok = true;
+
+#define TINYGRAPH_GORDER_BUMP(w)                                              \
+  do {                                                                        \
+    if (!tinygraph_bitset_get_at(placed, (w))) {                              \
+      scores[(w)] = enter ? scores[(w)] + 1 : scores[(w)] - 1;                \
+      ok = tinygraph_heap_push(heap, (w), UINT32_MAX - scores[(w)]);          \
+    }                                                                         \
+  } while (0)
+
+  tinygraph_neighbors_begin(graph, &it, u);
+
+  while (ok && tinygraph_neighbors_next(&it, &v)) {
+    TINYGRAPH_GORDER_BUMP(v);
+  }
+
+  const uint32_t *first, *last;
+  tinygraph_get_neighbors(reversed, &first, &last, u);
+
+  for (; ok && first != last; ++first) {
+    const uint32_t w = *first;
+
+    TINYGRAPH_GORDER_BUMP(w);
+
+    // Hubs relate almost all nodes with each other,
+    // the siblings through them are not worth it
+
+    if (tinygraph_get_out_degree(graph, w) >= TINYGRAPH_HUB_DEGREE) {
+      continue;
+    }
+
+    tinygraph_neighbors_begin(graph, &it, w);
+
+    while (ok && tinygraph_neighbors_next(&it, &v)) {
+      if (v != u) {
+        TINYGRAPH_GORDER_BUMP(v);
+      }
+    }
+  }
+
+#undef TINYGRAPH_GORDER_BUMP
+
+  return ok;
+}
+
+
+bool tinygraph_reorder_gorder(const tinygraph * const graph, uint32_t* nodes, uint32_t window) {
+  TINYGRAPH_ASSERT(graph);
+  TINYGRAPH_ASSERT(window > 0);
+
+  if (tinygraph_is_empty(graph)) {
+    return true;
+  }
+
+  TINYGRAPH_ASSERT(nodes);
+
+  // Gorder greedily places next the node with the most
+  // relations to the last `window` placed nodes: edges
+  // between them and shared in neighbors, so that nodes
+  // accessed together end up in the same cache lines.
+  //
+  // See
+  // - Graph Ordering: Towards the Optimal by Learning
+  //   the Locality, Wei et al., SIGMOD 2016
+
+  const uint32_t num_nodes = tinygraph_get_num_nodes(graph);
+
+  tinygraph *reversed = tinygraph_copy_reversed(graph);
+  uint32_t *fallback = malloc(num_nodes * sizeof(uint32_t));
+  uint32_t *scores = calloc(num_nodes, sizeof(uint32_t));
+  tinygraph_bitset_s placed = tinygraph_bitset_construct(num_nodes);
+  tinygraph_heap_s heap = tinygraph_heap_construct();
+
+  if (!reversed || !fallback || !scores || !placed || !heap
+      || !tinygraph_heap_reserve(heap, num_nodes)) {
+    tinygraph_heap_destruct(heap);
+    tinygraph_bitset_destruct(placed);
+    free(scores);
+    free(fallback);
+    tinygraph_destruct(reversed);
+
+    return false;
+  }
+
+  // Without any relations to the window we continue
+  // with the unplaced node of the highest degree
+
+  bool ok = tinygraph_sort_by_degree(graph, reversed, fallback, NULL, true);
+
+  uint32_t next_fallback = 0;
+
+  for (uint32_t pos = 0; ok && pos < num_nodes; ++pos) {
+    uint32_t u = UINT32_MAX;
+
+    while (!tinygraph_heap_is_empty(heap)) {
+      const uint32_t priority = tinygraph_heap_get_min_priority(heap);
+      const uint32_t v = tinygraph_heap_pop(heap);
+
+      // Outdated entries: placed nodes and nodes whose
+      // score changed are skipped; the latter have an
+      // entry with their current score in the heap, too
+
+      if (!tinygraph_bitset_get_at(placed, v) && scores[v] > 0
+          && priority == UINT32_MAX - scores[v]) {
+        u = v;
+        break;
+      }
+    }
+
+    if (u == UINT32_MAX) {
+      while (tinygraph_bitset_get_at(placed, fallback[next_fallback])) {
+        next_fallback += 1;
+      }
+
+      u = fallback[next_fallback];
+    }
+
+    tinygraph_bitset_set_at(placed, u);
+    nodes[pos] = u;
+
+    ok = tinygraph_gorder_update(graph, reversed, placed, scores, heap, u, true);
+
+    if (ok && pos >= window) {
+      ok = tinygraph_gorder_update(graph, reversed, placed, scores, heap, nodes[pos - window], false);
+    }
+  }
+
+  tinygraph_heap_destruct(heap);
+  tinygraph_bitset_destruct(placed);
+  free(scores);
+  free(fallback);
+  tinygraph_destruct(reversed);
+
+  return ok;
+}
+
+
+// Enters node v in Tarjan's depth first search at the call
+// stack's depth: sets up its out edges to continue with, as
+// an edge range for uncompressed graphs, and as a neighbors
+// iterator for compressed graphs, kept per call stack frame
+TINYGRAPH_WARN_UNUSED
+static bool tinygraph_scc_enter(
+    const tinygraph * const graph,
+    uint32_t v,
+    uint32_t depth,
+    uint32_t *next,
+    uint32_t *ends,
+    tinygraph_neighbors_it **its,
+    uint32_t *its_len)
+{
+  tinygraph_get_out_edges(graph, v, &next[v], &ends[v]);
+
+  if (!tinygraph_is_compressed(graph)) {
+    return true;
+  }
+
+  if (depth >= *its_len) {
+    const uint32_t len = *its_len < 64 ? 64 : *its_len * 2;
+
+    tinygraph_neighbors_it *grown = realloc(*its, len * sizeof(tinygraph_neighbors_it));
+
+    if (!grown) {
+      return false;
+    }
+
+    *its = grown;
+    *its_len = len;
+  }
+
+  tinygraph_neighbors_begin_range(graph, &(*its)[depth], v, next[v], ends[v]);
+
+  return true;
+}
+
+
+bool tinygraph_scc(const tinygraph * const graph, uint32_t* labels, uint32_t* num_components) {
+  TINYGRAPH_ASSERT(graph);
+  TINYGRAPH_ASSERT(num_components);
+
+  *num_components = 0;
+
+  if (tinygraph_is_empty(graph)) {
+    return true;
+  }
+
+  TINYGRAPH_ASSERT(labels);
+
+  // Tarjan's algorithm with the depth first search's call
+  // stack made explicit: road networks have search paths
+  // with millions of nodes which would overflow the real
+  // call stack. For the nodes on the call stack we keep
+  // their next out edge to continue with, and the labels
+  // hold the nodes' lowlinks until their component is
+  // complete; components come in reverse topological order.
+  // Nodes in a complete component get a marker index, all
+  // other visited nodes are on the component stack.
+  //
+  // See
+  // - Depth-First Search and Linear Graph Algorithms,
+  //   Tarjan, SIAM Journal on Computing 1972
+
+  const uint32_t num_nodes = tinygraph_get_num_nodes(graph);
+
+  uint32_t *index = malloc(num_nodes * sizeof(uint32_t));
+  uint32_t *next = malloc(num_nodes * sizeof(uint32_t));
+  uint32_t *ends = malloc(num_nodes * sizeof(uint32_t));
+  tinygraph_stack_s calls = tinygraph_stack_construct();
+  tinygraph_stack_s component = tinygraph_stack_construct();
+
+  if (!index || !next || !ends || !calls || !component) {
+    tinygraph_stack_destruct(component);
+    tinygraph_stack_destruct(calls);
+    free(ends);
+    free(next);
+    free(index);
+
+    return false;
+  }
+
+  // Compressed graphs only: the neighbors iterators
+  // of the nodes on the call stack, by their depth
+  const bool compressed = tinygraph_is_compressed(graph);
+
+  tinygraph_neighbors_it *its = NULL;
+  uint32_t its_len = 0;
+
+  uint32_t *lowlink = labels;
+
+  const uint32_t unvisited = UINT32_MAX;
+  const uint32_t completed = UINT32_MAX - 1;
+
+  TINYGRAPH_ASSERT(num_nodes < completed);
+
+  for (uint32_t v = 0; v < num_nodes; ++v) {
+    index[v] = unvisited;
+  }
+
+  uint32_t counter = 0;
+  bool ok = true;
+
+  for (uint32_t root = 0; ok && root < num_nodes; ++root) {
+    if (index[root] != unvisited) {
+      continue;
+    }
+
+    index[root] = lowlink[root] = counter++;
+
+    ok = tinygraph_scc_enter(graph, root, 0, next, ends, &its, &its_len)
+      && tinygraph_stack_push(calls, root)
+      && tinygraph_stack_push(component, root);
+
+    while (ok && !tinygraph_stack_is_empty(calls)) {
+      const uint32_t v = tinygraph_stack_get_top(calls);
+      const uint32_t depth = tinygraph_stack_get_size(calls) - 1;
+
+      // Descend into the first unvisited target, or take
+      // the lowlinks of targets in the current component
+
+      bool descended = false;
+
+      while (next[v] < ends[v]) {
+        uint32_t w;
+
+        if (compressed) {
+          const bool has_next = tinygraph_neighbors_next(&its[depth], &w);
+
+          TINYGRAPH_ASSERT(has_next);
+          (void)has_next;
+
+          next[v] += 1;
+        } else {
+          w = graph->targets[next[v]++];
+        }
+
+        if (index[w] == unvisited) {
+          index[w] = lowlink[w] = counter++;
+
+          ok = tinygraph_scc_enter(graph, w, depth + 1, next, ends, &its, &its_len)
+            && tinygraph_stack_push(calls, w)
+            && tinygraph_stack_push(component, w);
+
+          descended = true;
+
+          break;
+        }
+
+        if (index[w] != completed) {
+          lowlink[v] = tinygraph_min_u32(lowlink[v], index[w]);
+        }
+      }
+
+      if (descended) {
+        continue;
+      }
+
+      // Done with v: hand its lowlink to the caller before
+      // a complete component overwrites it with its label
+
+      const uint32_t popped = tinygraph_stack_pop(calls);
+
+      TINYGRAPH_ASSERT(popped == v);
+      (void)popped;
+
+      if (!tinygraph_stack_is_empty(calls)) {
+        const uint32_t u = tinygraph_stack_get_top(calls);
+        lowlink[u] = tinygraph_min_u32(lowlink[u], lowlink[v]);
+      }
+
+      if (lowlink[v] == index[v]) {
+        uint32_t w;
+
+        do {
+          w = tinygraph_stack_pop(component);
+          index[w] = completed;
+          labels[w] = *num_components;
+        } while (w != v);
+
+        *num_components += 1;
+      }
+    }
+  }
+
+  free(its);
+  tinygraph_stack_destruct(component);
+  tinygraph_stack_destruct(calls);
+  free(ends);
+  free(next);
+  free(index);
+
+  return ok;
+}
+
+
+bool tinygraph_reorder_scc(
+    const tinygraph * const graph,
+    uint32_t* nodes,
+    const uint16_t* lngs,
+    const uint16_t* lats,
+    tinygraph_curve curve)
+{
+  TINYGRAPH_ASSERT(graph);
+  TINYGRAPH_ASSERT((lngs && lats) || (!lngs && !lats));
+  TINYGRAPH_ASSERT(curve == TINYGRAPH_CURVE_ZORDER || curve == TINYGRAPH_CURVE_HILBERT);
+
+  if (tinygraph_is_empty(graph)) {
+    return true;
+  }
+
+  TINYGRAPH_ASSERT(nodes);
+
+  const uint32_t num_nodes = tinygraph_get_num_nodes(graph);
+
+  uint32_t *labels = malloc(num_nodes * sizeof(uint32_t));
+  uint64_t *keys = malloc(num_nodes * sizeof(uint64_t));
+
+  uint32_t num_components;
+
+  if (!labels || !keys || !tinygraph_scc(graph, labels, &num_components)) {
+    free(keys);
+    free(labels);
+
+    return false;
+  }
+
+  // Components by descending size, so that the largest
+  // component comes first; the component's rank then is
+  // the nodes' key's upper half, the curve position the
+  // lower half, ordering nodes spatially per component
+
+  uint32_t *ranks = calloc(num_components, sizeof(uint32_t));
+  uint64_t *components = malloc(num_components * sizeof(uint64_t));
+  uint32_t *order = malloc(num_components * sizeof(uint32_t));
+
+  if (!ranks || !components || !order) {
+    free(order);
+    free(components);
+    free(ranks);
+    free(keys);
+    free(labels);
+
+    return false;
+  }
+
+  for (uint32_t v = 0; v < num_nodes; ++v) {
+    ranks[labels[v]] += 1;
+  }
+
+  for (uint32_t c = 0; c < num_components; ++c) {
+    components[c] = (uint64_t)(UINT32_MAX - ranks[c]) << 32 | c;
+    order[c] = c;
+  }
+
+  bool ok = tinygraph_radix_sort_u64_u32(components, order, num_components, 0);
+
+  for (uint32_t i = 0; ok && i < num_components; ++i) {
+    ranks[order[i]] = i;
+  }
+
+  for (uint32_t v = 0; ok && v < num_nodes; ++v) {
+    uint32_t position = 0;
+
+    if (lngs && curve == TINYGRAPH_CURVE_ZORDER) {
+      position = tinygraph_zorder_encode32(lngs[v], lats[v]);
+    } else if (lngs && curve == TINYGRAPH_CURVE_HILBERT) {
+      position = tinygraph_hilbert_encode32(lngs[v], lats[v]);
+    }
+
+    keys[v] = (uint64_t)ranks[labels[v]] << 32 | position;
+    nodes[v] = v;
+  }
+
+  ok = ok && tinygraph_radix_sort_u64_u32(keys, nodes, num_nodes, 0);
+
+  free(order);
+  free(components);
+  free(ranks);
+  free(keys);
+  free(labels);
+
+  return ok;
+}
+
+
+tinygraph_s tinygraph_copy_largest_scc(const tinygraph * const graph, uint32_t* nodes) {
+  TINYGRAPH_ASSERT(graph);
+
+  if (tinygraph_is_empty(graph)) {
+    return tinygraph_construct_empty();
+  }
+
+  TINYGRAPH_ASSERT(nodes);
+
+  const uint32_t num_nodes = tinygraph_get_num_nodes(graph);
+
+  uint32_t *labels = malloc(num_nodes * sizeof(uint32_t));
+
+  uint32_t num_components;
+
+  if (!labels || !tinygraph_scc(graph, labels, &num_components)) {
+    free(labels);
+
+    return NULL;
+  }
+
+  uint32_t *sizes = calloc(num_components, sizeof(uint32_t));
+
+  if (!sizes) {
+    free(labels);
+
+    return NULL;
+  }
+
+  for (uint32_t v = 0; v < num_nodes; ++v) {
+    sizes[labels[v]] += 1;
+  }
+
+  uint32_t largest = 0;
+
+  for (uint32_t c = 1; c < num_components; ++c) {
+    largest = sizes[c] > sizes[largest] ? c : largest;
+  }
+
+  free(sizes);
+
+  // The component's nodes keep their relative order, so
+  // that mapping them keeps the targets sorted; we re-use
+  // the labels for the mapping from old to new node ids
+
+  uint32_t num_sub_nodes = 0;
+  uint32_t num_sub_edges = 0;
+
+  for (uint32_t v = 0; v < num_nodes; ++v) {
+    if (labels[v] != largest) {
+      labels[v] = UINT32_MAX;
+      continue;
+    }
+
+    nodes[num_sub_nodes] = v;
+    labels[v] = num_sub_nodes++;
+  }
+
+  for (uint32_t u = 0; u < num_sub_nodes; ++u) {
+    tinygraph_neighbors_it it;
+    uint32_t t;
+
+    tinygraph_neighbors_begin(graph, &it, nodes[u]);
+
+    while (tinygraph_neighbors_next(&it, &t)) {
+      num_sub_edges += labels[t] != UINT32_MAX;
+    }
+  }
+
+  tinygraph *copy = tinygraph_construct_empty();
+
+  if (!copy || !tinygraph_reserve(copy, num_sub_nodes, num_sub_edges)) {
+    tinygraph_destruct(copy);
+    free(labels);
+
+    return NULL;
+  }
+
+  uint32_t pos = 0;
+
+  for (uint32_t u = 0; u < num_sub_nodes; ++u) {
+    tinygraph_offsets_set(copy, u, pos);
+
+    tinygraph_neighbors_it it;
+    uint32_t t;
+
+    tinygraph_neighbors_begin(graph, &it, nodes[u]);
+
+    while (tinygraph_neighbors_next(&it, &t)) {
+      if (labels[t] != UINT32_MAX) {
+        copy->targets[pos++] = labels[t];
+      }
+    }
+  }
+
+  TINYGRAPH_ASSERT(pos == num_sub_edges);
+
+  free(labels);
+
+  if (!tinygraph_offsets_build(copy)) {
+    tinygraph_destruct(copy);
+
+    return NULL;
+  }
+
+  return copy;
+}
+
+
+tinygraph_s tinygraph_permute(
+    const tinygraph * const graph,
+    const uint32_t* nodes,
+    uint32_t* inverse,
+    uint32_t* edges)
+{
+  TINYGRAPH_ASSERT(graph);
+
+  const uint32_t num_nodes = tinygraph_get_num_nodes(graph);
+  const uint32_t num_edges = tinygraph_get_num_edges(graph);
+
+  if (tinygraph_is_empty(graph)) {
+    return tinygraph_construct_empty();
+  }
+
+  TINYGRAPH_ASSERT(nodes);
+
+  uint32_t *inv = inverse ? inverse : malloc(num_nodes * sizeof(uint32_t));
+
+  if (!inv) {
+    return NULL;
+  }
+
+  // The new node u is the old node nodes[u], that is
+  // the inverse maps old node ids to new node ids
+
+#ifndef NDEBUG
+  for (uint32_t u = 0; u < num_nodes; ++u) {
+    inv[u] = UINT32_MAX;
+  }
+#endif
+
+  for (uint32_t u = 0; u < num_nodes; ++u) {
+    TINYGRAPH_ASSERT(nodes[u] < num_nodes);
+    TINYGRAPH_ASSERT(inv[nodes[u]] == UINT32_MAX);
+
+    inv[nodes[u]] = u;
+  }
+
+  tinygraph *copy = tinygraph_construct_empty();
 
-        if (ij > sum) {
-          results[i * num_nodes + j] = sum;
+  if (!copy || !tinygraph_reserve(copy, num_nodes, num_edges)) {
+    tinygraph_destruct(copy);
+
+    if (!inverse) {
+      free(inv);
+    }
+
+    return NULL;
+  }
+
+  // The new out degrees are the old ones in the new node
+  // order: a single pass places all edge ranges. Mapping
+  // the targets unsorts them, so each range gets sorted
+  // on its own; with the edge permutation requested we
+  // sort keys with the old edge id next to the target
+
+  uint64_t *keys = NULL;
+  uint32_t keys_cap = 0;
+
+  uint32_t start = 0;
+
+  for (uint32_t u = 0; u < num_nodes; ++u) {
+    tinygraph_offsets_set(copy, u, start);
+
+    const uint32_t v = nodes[u];
+
+    uint32_t first, last;
+    tinygraph_get_out_edges(graph, v, &first, &last);
+
+    const uint32_t degree = last - first;
+
+    if (edges && degree > keys_cap) {
+      uint64_t *grown = realloc(keys, degree * sizeof(uint64_t));
+
+      if (!grown) {
+        free(keys);
+        tinygraph_destruct(copy);
+
+        if (!inverse) {
+          free(inv);
+        }
+
+        return NULL;
+      }
+
+      keys = grown;
+      keys_cap = degree;
+    }
+
+    uint32_t *range = copy->targets + start;
+
+    if (graph->targets) {
+      for (uint32_t e = first; e < last; ++e) {
+        range[e - first] = inv[graph->targets[e]];
+      }
+    } else {
+      tinygraph_neighbors_it it;
+      uint32_t t;
+
+      tinygraph_neighbors_begin(graph, &it, v);
+
+      for (uint32_t i = 0; tinygraph_neighbors_next(&it, &t); ++i) {
+        range[i] = inv[t];
+      }
+    }
+
+    if (edges) {
+      for (uint32_t i = 0; i < degree; ++i) {
+        keys[i] = ((uint64_t)range[i] << 32) | (first + i);
+      }
+
+      if (!tinygraph_sort_edge_keys(keys, degree)) {
+        free(keys);
+        tinygraph_destruct(copy);
+
+        if (!inverse) {
+          free(inv);
         }
+
+        return NULL;
+      }
+
+      for (uint32_t i = 0; i < degree; ++i) {
+        range[i] = (uint32_t)(keys[i] >> 32);
+        edges[start + i] = (uint32_t)keys[i];
       }
+    } else {
+      tinygraph_sort_plain_u32(range, degree);
     }
+
+    start += degree;
+  }
+
+  TINYGRAPH_ASSERT(start == num_edges);
+
+  free(keys);
+
+  if (!inverse) {
+    free(inv);
+  }
+
+  if (!tinygraph_offsets_build(copy)) {
+    tinygraph_destruct(copy);
+
+    return NULL;
   }
+
+  return copy;
 }
 
 
-void tinygraph_print(const tinygraph * const graph) {
+bool tinygraph_permute_inplace(
+    void* values,
+    uint32_t size,
+    const uint32_t* permutation,
+    uint32_t n)
+{
+  TINYGRAPH_ASSERT(size > 0);
+
+  if (n == 0) {
+    return true;
+  }
+
+  TINYGRAPH_ASSERT(values);
+  TINYGRAPH_ASSERT(permutation);
+
+  // Follows the permutation's cycles: moving each value
+  // into place frees the slot of the next value in the
+  // cycle, so that every value moves exactly once and
+  // we need only a single value's temporary space plus
+  // a bit per value to mark the ones in place
+
+  tinygraph_bitset_s done = tinygraph_bitset_construct(n);
+  unsigned char *tmp = malloc(size);
+
+  if (!done || !tmp) {
+    free(tmp);
+    tinygraph_bitset_destruct(done);
+
+    return false;
+  }
+
+  unsigned char *data = values;
+
+  for (uint32_t i = 0; i < n; ++i) {
+    if (tinygraph_bitset_get_at(done, i)) {
+      continue;
+    }
+
+    memcpy(tmp, data + (uint64_t)i * size, size);
+
+    uint32_t j = i;
+
+    while (permutation[j] != i) {
+      TINYGRAPH_ASSERT(permutation[j] < n);
+      TINYGRAPH_ASSERT(!tinygraph_bitset_get_at(done, permutation[j]));
+
+      memcpy(data + (uint64_t)j * size, data + (uint64_t)permutation[j] * size, size);
+      tinygraph_bitset_set_at(done, j);
+
+      j = permutation[j];
+    }
+
+    memcpy(data + (uint64_t)j * size, tmp, size);
+    tinygraph_bitset_set_at(done, j);
+  }
+
+  free(tmp);
+  tinygraph_bitset_destruct(done);
+
+  return true;
+}
+
+
+// The bidirectional graph: the forward graph it borrows, its
+// transpose for the in edges, and for each in edge the rank
+// of its forward edge among the forward source's out edges.
+// Ranks of 255 and more are in a sorted exceptions list.
+
+typedef struct tinygraph_bidirectional {
+  tinygraph_const_s graph;
+  tinygraph *reversed;
+  uint8_t *ranks;
+  uint32_t *exceptions_edges;
+  uint32_t *exceptions_ranks;
+  uint32_t exceptions_len;
+} tinygraph_bidirectional;
+
+
+tinygraph_bidirectional* tinygraph_bidirectional_construct(tinygraph_const_s graph) {
   TINYGRAPH_ASSERT(graph);
 
-  fprintf(stderr, "graph %p with nodes=%ju, edges=%ju of %ju bytes total\n",
-      (const void *)graph,
-      (uintmax_t)tinygraph_get_num_nodes(graph),
-      (uintmax_t)tinygraph_get_num_edges(graph),
-      (uintmax_t)tinygraph_size_in_bytes(graph));
+  tinygraph_bidirectional *out = malloc(sizeof(tinygraph_bidirectional));
 
-  TINYGRAPH_FOR_EACH_NODE(s, graph) {
-    const uint32_t *it, *last;
+  if (!out) {
+    return NULL;
+  }
+
+  *out = (tinygraph_bidirectional){
+    .graph = graph,
+    .reversed = NULL,
+    .ranks = NULL,
+    .exceptions_edges = NULL,
+    .exceptions_ranks = NULL,
+    .exceptions_len = 0,
+  };
 
-    tinygraph_get_neighbors(graph, &it, &last, s);
+  const uint32_t n = tinygraph_get_num_edges(graph);
 
-    fprintf(stderr, "%ju:", (uintmax_t)s);
+  if (n == 0) {
+    out->reversed = tinygraph_construct_empty();
 
-    for (; it != last; ++it) {
-      const uint32_t t = *it;
+    if (!out->reversed) {
+      free(out);
 
-      fprintf(stderr, " (%ju -> %ju)", (uintmax_t)s, (uintmax_t)t);
+      return NULL;
     }
 
-    fprintf(stderr, "\n");
+    return out;
+  }
+
+  uint32_t *ranks = malloc(n * sizeof(uint32_t));
+  out->ranks = malloc(n * sizeof(uint8_t));
+
+  if (!ranks || !out->ranks) {
+    free(ranks);
+    tinygraph_bidirectional_destruct(out);
+
+    return NULL;
+  }
+
+  out->reversed = tinygraph_copy_reversed_with_ranks(graph, ranks);
+
+  if (!out->reversed) {
+    free(ranks);
+    tinygraph_bidirectional_destruct(out);
+
+    return NULL;
+  }
+
+  // Road networks have single digit degrees, a byte per
+  // rank covers all but the rare hub nodes' out edges
+
+  uint32_t num_exceptions = 0;
+
+  for (uint32_t i = 0; i < n; ++i) {
+    num_exceptions += ranks[i] >= UINT8_MAX;
+  }
+
+  if (num_exceptions > 0) {
+    out->exceptions_edges = malloc(num_exceptions * sizeof(uint32_t));
+    out->exceptions_ranks = malloc(num_exceptions * sizeof(uint32_t));
+
+    if (!out->exceptions_edges || !out->exceptions_ranks) {
+      free(ranks);
+      tinygraph_bidirectional_destruct(out);
+
+      return NULL;
+    }
+  }
+
+  for (uint32_t i = 0; i < n; ++i) {
+    if (ranks[i] < UINT8_MAX) {
+      out->ranks[i] = (uint8_t)ranks[i];
+    } else {
+      out->ranks[i] = UINT8_MAX;
+
+      out->exceptions_edges[out->exceptions_len] = i;
+      out->exceptions_ranks[out->exceptions_len] = ranks[i];
+      out->exceptions_len += 1;
+    }
+  }
+
+  TINYGRAPH_ASSERT(out->exceptions_len == num_exceptions);
+
+  free(ranks);
+
+  return out;
+}
+
+
+void tinygraph_bidirectional_destruct(tinygraph_bidirectional * const bidir) {
+  if (!bidir) {
+    return;
+  }
+
+  tinygraph_destruct(bidir->reversed);
+  free(bidir->ranks);
+  free(bidir->exceptions_edges);
+  free(bidir->exceptions_ranks);
+
+  bidir->graph = NULL;
+  bidir->reversed = NULL;
+  bidir->ranks = NULL;
+  bidir->exceptions_edges = NULL;
+  bidir->exceptions_ranks = NULL;
+  bidir->exceptions_len = 0;
+
+  free(bidir);
+}
+
+
+tinygraph_const_s tinygraph_bidirectional_get_graph(const tinygraph_bidirectional * const bidir) {
+  TINYGRAPH_ASSERT(bidir);
+
+  return bidir->graph;
+}
+
+
+tinygraph_const_s tinygraph_bidirectional_get_reversed(const tinygraph_bidirectional * const bidir) {
+  TINYGRAPH_ASSERT(bidir);
+
+  return bidir->reversed;
+}
+
+
+void tinygraph_bidirectional_get_in_edges(
+    const tinygraph_bidirectional * const bidir,
+    uint32_t target,
+    uint32_t *first,
+    uint32_t *last)
+{
+  TINYGRAPH_ASSERT(bidir);
+
+  tinygraph_get_out_edges(bidir->reversed, target, first, last);
+}
+
+
+void tinygraph_bidirectional_get_in_neighbors(
+    const tinygraph_bidirectional * const bidir,
+    const uint32_t **first,
+    const uint32_t **last,
+    uint32_t v)
+{
+  TINYGRAPH_ASSERT(bidir);
+
+  tinygraph_get_neighbors(bidir->reversed, first, last, v);
+}
+
+
+uint32_t tinygraph_bidirectional_get_in_degree(const tinygraph_bidirectional * const bidir, uint32_t v) {
+  TINYGRAPH_ASSERT(bidir);
+
+  return tinygraph_get_out_degree(bidir->reversed, v);
+}
+
+
+uint32_t tinygraph_bidirectional_get_edge_source(const tinygraph_bidirectional * const bidir, uint32_t e) {
+  TINYGRAPH_ASSERT(bidir);
+
+  return tinygraph_get_edge_target(bidir->reversed, e);
+}
+
+
+// Returns the in edge e's rank among its source's out edges
+TINYGRAPH_WARN_UNUSED
+static inline uint32_t tinygraph_bidirectional_get_rank(const tinygraph_bidirectional * const bidir, uint32_t e) {
+  TINYGRAPH_ASSERT(bidir);
+  TINYGRAPH_ASSERT(tinygraph_has_edge(bidir->reversed, e));
+
+  uint32_t rank = bidir->ranks[e];
+
+  if (TINYGRAPH_UNLIKELY(rank == UINT8_MAX)) {
+    const uint32_t *first = bidir->exceptions_edges;
+    uint32_t len = bidir->exceptions_len;
+
+    while (len > 0) {
+      const uint32_t half = len / 2;
+
+      if (first[half] < e) {
+        first += half + 1;
+        len -= half + 1;
+      } else {
+        len = half;
+      }
+    }
+
+    TINYGRAPH_ASSERT(first < bidir->exceptions_edges + bidir->exceptions_len);
+    TINYGRAPH_ASSERT(*first == e);
+
+    rank = bidir->exceptions_ranks[first - bidir->exceptions_edges];
+  }
+
+  return rank;
+}
+
+
+uint32_t tinygraph_bidirectional_get_forward_edge(const tinygraph_bidirectional * const bidir, uint32_t e) {
+  TINYGRAPH_ASSERT(bidir);
+
+  uint32_t efirst, elast;
+  tinygraph_get_out_edges(bidir->graph, tinygraph_get_edge_target(bidir->reversed, e), &efirst, &elast);
+
+  return tinygraph_bidirectional_get_forward_edge_in(bidir, e, efirst, elast);
+}
+
+
+uint32_t tinygraph_bidirectional_get_forward_edge_in(
+    const tinygraph_bidirectional * const bidir,
+    uint32_t e,
+    uint32_t first,
+    uint32_t last)
+{
+  TINYGRAPH_ASSERT(bidir);
+  TINYGRAPH_ASSERT(first <= last);
+
+  const uint32_t rank = tinygraph_bidirectional_get_rank(bidir, e);
+
+  TINYGRAPH_ASSERT(first + rank < last);
+  (void)last;
+
+  return first + rank;
+}
+
+
+uint32_t tinygraph_bidirectional_size_in_bytes(const tinygraph_bidirectional * const bidir) {
+  TINYGRAPH_ASSERT(bidir);
+
+  return sizeof(tinygraph_bidirectional)
+    + tinygraph_size_in_bytes(bidir->reversed)
+    + tinygraph_get_num_edges(bidir->reversed) * sizeof(uint8_t)
+    + bidir->exceptions_len * 2 * sizeof(uint32_t);
+}
+
+
+// A single direction's search state: distances, the
+// shortest path tree via parents, and the frontier.
+typedef struct tinygraph_dijkstra_search {
+  uint32_t* dist;
+  uint32_t* parent;
+
+  // The nodes a search reached, so that clearing
+  // for the next search resets only those nodes
+  tinygraph_array_s touched;
+
+  tinygraph_bitset_s seen;
+
+  // Exactly one of the queues below is set,
+  // depending on the queue kind selected
+  tinygraph_dijkstra_queue queue;
+  tinygraph_heap_s heap;
+  tinygraph_radix_heap_s radix_heap;
+  tinygraph_bucket_queue_s bucket_queue;
+  tinygraph_indexed_heap_s indexed_heap;
+} tinygraph_dijkstra_search;
+
+
+// The purpose of the dijkstra context is to cache state
+// like the distance and parents array, so that we don't
+// have to allocate memory for every new s-t search.
+typedef struct tinygraph_dijkstra {
+  uint32_t s;
+  uint32_t t;
+
+  tinygraph_array_s path;
+
+  const uint16_t* weight;
+
+  tinygraph_const_s graph;
+
+  tinygraph_dijkstra_search forward;
+
+  // Bidirectional searches only: the backward search
+  // from t over the in edges, the node where the two
+  // searches meet, and the shortest distance found
+  tinygraph_bidirectional_const_s bidir;
+  tinygraph_dijkstra_search backward;
+  uint32_t meet;
+  uint32_t mu;
+
+  // A* searches only: the node coordinates and the
+  // scale from coordinate to weight units for the
+  // potential, the source node's potential, and the
+  // largest priority increase
+  const uint32_t* lngs;
+  const uint32_t* lats;
+  double scale;
+  uint32_t offset;
+  uint32_t window;
+} tinygraph_dijkstra;
+
+
+// The dijkstra queue functions dispatch to the
+// priority queue selected when constructing the
+// context; the branches are perfectly predicted
+
+TINYGRAPH_WARN_UNUSED
+static inline bool tinygraph_dijkstra_queue_is_empty(const tinygraph_dijkstra_search * const search) {
+  switch (search->queue) {
+    case TINYGRAPH_DIJKSTRA_QUEUE_BINARY_HEAP:
+      return tinygraph_heap_is_empty(search->heap);
+    case TINYGRAPH_DIJKSTRA_QUEUE_RADIX_HEAP:
+      return tinygraph_radix_heap_is_empty(search->radix_heap);
+    case TINYGRAPH_DIJKSTRA_QUEUE_BUCKET_QUEUE:
+      return tinygraph_bucket_queue_is_empty(search->bucket_queue);
+    case TINYGRAPH_DIJKSTRA_QUEUE_INDEXED_HEAP:
+      return tinygraph_indexed_heap_is_empty(search->indexed_heap);
+    default:
+      TINYGRAPH_UNREACHABLE();
+  }
+}
+
+
+TINYGRAPH_WARN_UNUSED
+static inline bool tinygraph_dijkstra_queue_push(tinygraph_dijkstra_search * const search, uint32_t value, uint32_t priority) {
+  switch (search->queue) {
+    case TINYGRAPH_DIJKSTRA_QUEUE_BINARY_HEAP:
+      return tinygraph_heap_push(search->heap, value, priority);
+    case TINYGRAPH_DIJKSTRA_QUEUE_RADIX_HEAP:
+      return tinygraph_radix_heap_push(search->radix_heap, value, priority);
+    case TINYGRAPH_DIJKSTRA_QUEUE_BUCKET_QUEUE:
+      return tinygraph_bucket_queue_push(search->bucket_queue, value, priority);
+    case TINYGRAPH_DIJKSTRA_QUEUE_INDEXED_HEAP:
+      // Nodes on the frontier get their priority decreased
+      // in place instead of being pushed a second time
+      if (tinygraph_indexed_heap_contains(search->indexed_heap, value)) {
+        if (priority < tinygraph_indexed_heap_get_priority(search->indexed_heap, value)) {
+          tinygraph_indexed_heap_decrease(search->indexed_heap, value, priority);
+        }
+
+        return true;
+      }
+
+      return tinygraph_indexed_heap_push(search->indexed_heap, value, priority);
+    default:
+      TINYGRAPH_UNREACHABLE();
+  }
+}
+
+
+// Writes the value with the smallest priority into `value`
+// and the priority it was popped with into `priority`
+TINYGRAPH_WARN_UNUSED
+static inline bool tinygraph_dijkstra_queue_pop(
+    tinygraph_dijkstra_search * const search,
+    uint32_t *value,
+    uint32_t *priority)
+{
+  switch (search->queue) {
+    case TINYGRAPH_DIJKSTRA_QUEUE_BINARY_HEAP:
+      *priority = tinygraph_heap_get_min_priority(search->heap);
+      *value = tinygraph_heap_pop(search->heap);
+      return true;
+    case TINYGRAPH_DIJKSTRA_QUEUE_RADIX_HEAP:
+      if (!tinygraph_radix_heap_pop(search->radix_heap, value)) {
+        return false;
+      }
+
+      *priority = tinygraph_radix_heap_get_last_priority(search->radix_heap);
+      return true;
+    case TINYGRAPH_DIJKSTRA_QUEUE_BUCKET_QUEUE:
+      *value = tinygraph_bucket_queue_pop(search->bucket_queue);
+      *priority = tinygraph_bucket_queue_get_last_priority(search->bucket_queue);
+      return true;
+    case TINYGRAPH_DIJKSTRA_QUEUE_INDEXED_HEAP:
+      *priority = tinygraph_indexed_heap_get_min_priority(search->indexed_heap);
+      *value = tinygraph_indexed_heap_pop(search->indexed_heap);
+      return true;
+    default:
+      TINYGRAPH_UNREACHABLE();
   }
-
-  //tinygraph_print_internal(graph);
 }
 
 
-uint32_t tinygraph_size_in_bytes(const tinygraph * const graph) {
-  TINYGRAPH_ASSERT(graph);
-
-  return sizeof(tinygraph)
-    + sizeof(uint32_t) * graph->offsets_len
-    + sizeof(uint32_t) * graph->targets_len;
+static inline void tinygraph_dijkstra_queue_clear(tinygraph_dijkstra_search * const search) {
+  switch (search->queue) {
+    case TINYGRAPH_DIJKSTRA_QUEUE_BINARY_HEAP:
+      tinygraph_heap_clear(search->heap);
+      return;
+    case TINYGRAPH_DIJKSTRA_QUEUE_RADIX_HEAP:
+      tinygraph_radix_heap_clear(search->radix_heap);
+      return;
+    case TINYGRAPH_DIJKSTRA_QUEUE_BUCKET_QUEUE:
+      tinygraph_bucket_queue_clear(search->bucket_queue);
+      return;
+    case TINYGRAPH_DIJKSTRA_QUEUE_INDEXED_HEAP:
+      tinygraph_indexed_heap_clear(search->indexed_heap);
+      return;
+    default:
+      TINYGRAPH_UNREACHABLE();
+  }
 }
 
 
-typedef struct tinygraph_reorder_item {
-  uint32_t node;
-  uint32_t zval;
-} tinygraph_reorder_item;
+static void tinygraph_dijkstra_search_destruct(tinygraph_dijkstra_search * const search) {
+  free(search->dist);
+  free(search->parent);
 
-TINYGRAPH_WARN_UNUSED
-static inline int tinygraph_reorder_item_cmp(const void* lhs, const void *rhs) {
-  const tinygraph_reorder_item ilhs = *(const tinygraph_reorder_item *)lhs;
-  const tinygraph_reorder_item irhs = *(const tinygraph_reorder_item *)rhs;
-
-  if (ilhs.zval < irhs.zval) {
-    return -1;
-  } else if (ilhs.zval > irhs.zval) {
-    return +1;
-  } else {
-    return 0;
-  }
+  tinygraph_array_destruct(search->touched);
+  tinygraph_bitset_destruct(search->seen);
+
+  tinygraph_indexed_heap_destruct(search->indexed_heap);
+  tinygraph_bucket_queue_destruct(search->bucket_queue);
+  tinygraph_radix_heap_destruct(search->radix_heap);
+  tinygraph_heap_destruct(search->heap);
+
+  *search = (tinygraph_dijkstra_search){0};
 }
 
-bool tinygraph_reorder(
-    uint32_t* nodes,
-    const uint16_t* lngs,
-    const uint16_t* lats,
-    uint32_t n)
-{
-  if (n == 0) {
-    return true;
-  }
 
-  TINYGRAPH_ASSERT(nodes);
-  TINYGRAPH_ASSERT(lngs);
-  TINYGRAPH_ASSERT(lats);
+// Sets up the search state for n nodes with the queue kind
+// and, for the bucket queue, the largest edge weight
+TINYGRAPH_WARN_UNUSED
+static bool tinygraph_dijkstra_search_construct(
+    tinygraph_dijkstra_search * const search,
+    uint32_t n,
+    tinygraph_dijkstra_queue queue,
+    uint32_t window)
+{
+  *search = (tinygraph_dijkstra_search){
+    .dist = malloc(n * sizeof(uint32_t)),
+    .parent = malloc(n * sizeof(uint32_t)),
+    .touched = tinygraph_array_construct(0),
+    .seen = tinygraph_bitset_construct(n),
+    .queue = queue,
+  };
 
-  // Reorder graph nodes spatially based on a z-order
-  // space filling curve to improve memory locality
+  switch (queue) {
+    case TINYGRAPH_DIJKSTRA_QUEUE_BINARY_HEAP:
+      search->heap = tinygraph_heap_construct();
+      break;
+    case TINYGRAPH_DIJKSTRA_QUEUE_RADIX_HEAP:
+      search->radix_heap = tinygraph_radix_heap_construct();
+      break;
+    case TINYGRAPH_DIJKSTRA_QUEUE_BUCKET_QUEUE:
+      search->bucket_queue = tinygraph_bucket_queue_construct(window);
+      break;
+    case TINYGRAPH_DIJKSTRA_QUEUE_INDEXED_HEAP:
+      search->indexed_heap = tinygraph_indexed_heap_construct(n);
+      break;
+    default:
+      TINYGRAPH_UNREACHABLE();
+  }
 
-  // Note that we don't really need a precise sorting
-  // down to every pair of numbers. We could do e.g.
-  // with an ordering that stops at e.g. the 4k page
-  // size and keeps them unsorted. We can use this
-  // as a trade-off between run-time and quality.
-  // The second idea is to use radix sort on the
-  // z-order keyed nodes.
+  const bool has_queue = search->heap || search->radix_heap
+    || search->bucket_queue || search->indexed_heap;
 
-  tinygraph_reorder_item* items = malloc(n * sizeof(tinygraph_reorder_item));
+  if (!search->dist || !search->parent || !search->touched
+      || !search->seen || !has_queue) {
+    tinygraph_dijkstra_search_destruct(search);
 
-  if (!items) {
     return false;
   }
 
+  // Initializes the internal state e.g. sets
+  // self-loops for the parents array; after
+  // this clearing only resets touched nodes
   for (uint32_t i = 0; i < n; ++i) {
-    items[i] = (tinygraph_reorder_item) {
-      .node = nodes[i],
-      .zval = tinygraph_zorder_encode32(lngs[nodes[i]], lats[nodes[i]]),
-    };
+    search->dist[i] = UINT32_MAX;
   }
 
-  qsort(items, n, sizeof(tinygraph_reorder_item), tinygraph_reorder_item_cmp);
-
   for (uint32_t i = 0; i < n; ++i) {
-    nodes[i] = items[i].node;
+    search->parent[i] = i;
   }
 
-  free(items);
-
   return true;
 }
 
 
-// The purpose of the dijkstra context is to cache state
-// like the distance and parents array, so that we don't
-// have to allocate memory for every new s-t search.
-typedef struct tinygraph_dijkstra {
-  uint32_t s;
-  uint32_t t;
+static inline void tinygraph_dijkstra_search_clear(tinygraph_dijkstra_search * const search, uint32_t n) {
+  const uint32_t m = tinygraph_array_get_size(search->touched);
 
-  uint32_t* dist;
-  uint32_t* parent;
-  tinygraph_array_s path;
+  // Local searches reach a few nodes only; resetting
+  // them costs what the search did, independent of the
+  // graph's size. If a search reached a good part of
+  // the graph we reset all of it in a linear scan.
 
-  const uint16_t* weight;
+  if (m < n / 16) {
+    for (uint32_t i = 0; i < m; ++i) {
+      const uint32_t v = tinygraph_array_get_at(search->touched, i);
 
-  tinygraph_const_s graph;
-  tinygraph_bitset_s seen;
-  tinygraph_heap_s heap;
-} tinygraph_dijkstra;
+      search->dist[v] = UINT32_MAX;
+      search->parent[v] = v;
+
+      tinygraph_bitset_clear_at(search->seen, v);
+    }
+  } else {
+    for (uint32_t i = 0; i < n; ++i) {
+      search->dist[i] = UINT32_MAX;
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+      search->parent[i] = i;
+    }
+
+    tinygraph_bitset_clear(search->seen);
+  }
+
+  tinygraph_array_clear(search->touched);
+  tinygraph_dijkstra_queue_clear(search);
+}
+
+
+// Sets the distance and parent of a node, keeping track
+// of the nodes a search reached for a cheap clear
+TINYGRAPH_WARN_UNUSED
+static inline bool tinygraph_dijkstra_search_relax(
+    tinygraph_dijkstra_search * const search,
+    uint32_t v,
+    uint32_t dist,
+    uint32_t parent)
+{
+  if (search->dist[v] == UINT32_MAX) {
+    if (!tinygraph_array_push(search->touched, v)) {
+      return false;
+    }
+  }
+
+  search->dist[v] = dist;
+  search->parent[v] = parent;
+
+  return true;
+}
+
+
+// Starts a search from its root node
+TINYGRAPH_WARN_UNUSED
+static inline bool tinygraph_dijkstra_search_start(
+    tinygraph_dijkstra_search * const search,
+    uint32_t root,
+    uint32_t priority)
+{
+  return tinygraph_dijkstra_search_relax(search, root, 0, root)
+    && tinygraph_dijkstra_queue_push(search, root, priority);
+}
 
 
 static inline void tinygraph_dijkstra_clear(tinygraph_dijkstra_s ctx) {
@@ -548,22 +3393,29 @@ static inline void tinygraph_dijkstra_clear(tinygraph_dijkstra_s ctx) {
 
   const uint32_t n = tinygraph_get_num_nodes(ctx->graph);
 
-  for (uint32_t i = 0; i < n; ++i) {
-    ctx->dist[i] = UINT32_MAX;
-  }
+  tinygraph_dijkstra_search_clear(&ctx->forward, n);
 
-  for (uint32_t i = 0; i < n; ++i) {
-    ctx->parent[i] = i;
-  }
+  if (ctx->bidir) {
+    tinygraph_dijkstra_search_clear(&ctx->backward, n);
 
-  tinygraph_bitset_clear(ctx->seen);
-  tinygraph_heap_clear(ctx->heap);
+    ctx->meet = UINT32_MAX;
+    ctx->mu = UINT32_MAX;
+  }
 }
 
 
-tinygraph_dijkstra_s tinygraph_dijkstra_construct(tinygraph_const_s graph, const uint16_t* weights) {
+static tinygraph_dijkstra_s tinygraph_dijkstra_construct_impl(
+    tinygraph_const_s graph,
+    tinygraph_bidirectional_const_s bidir,
+    const uint16_t* weights,
+    const uint32_t* lngs,
+    const uint32_t* lats,
+    double scale,
+    tinygraph_dijkstra_queue queue)
+{
   TINYGRAPH_ASSERT(graph);
   TINYGRAPH_ASSERT(!tinygraph_is_empty(graph));
+  TINYGRAPH_ASSERT(weights);
 
   tinygraph_dijkstra *out = malloc(sizeof(tinygraph_dijkstra));
 
@@ -573,73 +3425,103 @@ tinygraph_dijkstra_s tinygraph_dijkstra_construct(tinygraph_const_s graph, const
 
   const uint32_t n = tinygraph_get_num_nodes(graph);
 
-  tinygraph_bitset_s seen = tinygraph_bitset_construct(n);
+  // The priorities on the bucket queue are within the
+  // largest edge weight of the one popped last. With
+  // A* the potential adds up to another edge weight
+  // and one for rounding it down to an integer.
+  uint32_t window = 0;
 
-  if (!seen) {
-    free(out);
+  if (queue == TINYGRAPH_DIJKSTRA_QUEUE_BUCKET_QUEUE || lngs) {
+    const uint32_t m = tinygraph_get_num_edges(graph);
 
-    return NULL;
+    for (uint32_t i = 0; i < m; ++i) {
+      window = weights[i] > window ? weights[i] : window;
+    }
+
+    if (lngs) {
+      window = 2 * window + 1;
+    }
   }
 
-  tinygraph_heap_s heap = tinygraph_heap_construct();
+  *out = (tinygraph_dijkstra){
+    .s = UINT32_MAX,
+    .t = UINT32_MAX,
+    .path = tinygraph_array_construct(0),
+    .weight = weights,
+    .graph = graph,
+    .bidir = bidir,
+    .meet = UINT32_MAX,
+    .mu = UINT32_MAX,
+    .lngs = lngs,
+    .lats = lats,
+    .scale = scale,
+    .offset = 0,
+    .window = window,
+  };
 
-  if (!heap) {
-    tinygraph_bitset_destruct(seen);
+  if (!out->path) {
     free(out);
 
     return NULL;
   }
 
-  uint32_t* dist = malloc(n * sizeof(uint32_t));
-
-  if (!dist) {
-    tinygraph_heap_destruct(heap);
-    tinygraph_bitset_destruct(seen);
+  if (!tinygraph_dijkstra_search_construct(&out->forward, n, queue, window)) {
+    tinygraph_array_destruct(out->path);
     free(out);
 
     return NULL;
   }
 
-  uint32_t* parent = malloc(n * sizeof(uint32_t));
-
-  if (!parent) {
-    free(dist);
-    tinygraph_heap_destruct(heap);
-    tinygraph_bitset_destruct(seen);
+  if (bidir && !tinygraph_dijkstra_search_construct(&out->backward, n, queue, window)) {
+    tinygraph_dijkstra_search_destruct(&out->forward);
+    tinygraph_array_destruct(out->path);
     free(out);
 
     return NULL;
   }
 
-  tinygraph_array_s path = tinygraph_array_construct(0);
+  return out;
+}
 
-  if (!path) {
-    free(parent);
-    free(dist);
-    tinygraph_heap_destruct(heap);
-    tinygraph_bitset_destruct(seen);
-    free(out);
 
-    return NULL;
-  }
+tinygraph_dijkstra_s tinygraph_dijkstra_construct(tinygraph_const_s graph, const uint16_t* weights) {
+  return tinygraph_dijkstra_construct_impl(graph, NULL, weights, NULL, NULL, 0, TINYGRAPH_DIJKSTRA_QUEUE_BINARY_HEAP);
+}
 
-  *out = (tinygraph_dijkstra){
-    .s = UINT32_MAX,
-    .t = UINT32_MAX,
-    .dist = dist,
-    .parent = parent,
-    .path = path,
-    .weight = weights,
-    .graph = graph,
-    .seen = seen,
-    .heap = heap,
-  };
 
-  // Resets the internal state e.g. sets
-  // self-loops for the parents array
-  tinygraph_dijkstra_clear(out);
+tinygraph_dijkstra_s tinygraph_dijkstra_construct_with_queue(
+    tinygraph_const_s graph,
+    const uint16_t* weights,
+    tinygraph_dijkstra_queue queue)
+{
+  return tinygraph_dijkstra_construct_impl(graph, NULL, weights, NULL, NULL, 0, queue);
+}
 
-  return out;
+
+tinygraph_dijkstra_s tinygraph_dijkstra_construct_bidirectional(
+    tinygraph_bidirectional_const_s bidir,
+    const uint16_t* weights,
+    tinygraph_dijkstra_queue queue)
+{
+  TINYGRAPH_ASSERT(bidir);
+
+  return tinygraph_dijkstra_construct_impl(bidir->graph, bidir, weights, NULL, NULL, 0, queue);
+}
+
+
+tinygraph_dijkstra_s tinygraph_dijkstra_construct_astar(
+    tinygraph_const_s graph,
+    const uint16_t* weights,
+    const uint32_t* lngs,
+    const uint32_t* lats,
+    double scale,
+    tinygraph_dijkstra_queue queue)
+{
+  TINYGRAPH_ASSERT(lngs);
+  TINYGRAPH_ASSERT(lats);
+  TINYGRAPH_ASSERT(scale >= 0);
+
+  return tinygraph_dijkstra_construct_impl(graph, NULL, weights, lngs, lats, scale, queue);
 }
 
 
@@ -651,12 +3533,13 @@ void tinygraph_dijkstra_destruct(tinygraph_dijkstra * const ctx) {
   ctx->s = UINT32_MAX;
   ctx->t = UINT32_MAX;
 
-  free(ctx->dist);
-  free(ctx->parent);
-
   tinygraph_array_destruct(ctx->path);
-  tinygraph_heap_destruct(ctx->heap);
-  tinygraph_bitset_destruct(ctx->seen);
+
+  tinygraph_dijkstra_search_destruct(&ctx->forward);
+
+  if (ctx->bidir) {
+    tinygraph_dijkstra_search_destruct(&ctx->backward);
+  }
 
   free(ctx);
 }
@@ -677,6 +3560,192 @@ static inline uint32_t tinygraph_saturated_add_u32(uint32_t a, uint32_t b) {
 }
 
 
+// The A* potential of node v: a lower bound on its distance
+// to the target node from the straight line between them,
+// scaled from coordinate to weight units. Rounding it down
+// keeps it consistent for integer weights, see
+//
+// - A Formal Basis for the Heuristic Determination of Minimum
+//   Cost Paths, Hart, Nilsson, Raphael, IEEE SSC 1968
+// - Computing the Shortest Path: A* Search Meets Graph Theory,
+//   Goldberg, Harrelson, SODA 2005
+static inline uint32_t tinygraph_dijkstra_potential(tinygraph_dijkstra_const_s ctx, uint32_t v) {
+  if (!ctx->lngs) {
+    return 0;
+  }
+
+  const double dx = (double)ctx->lngs[v] - (double)ctx->lngs[ctx->t];
+  const double dy = (double)ctx->lats[v] - (double)ctx->lats[ctx->t];
+
+  const double h = floor(ctx->scale * sqrt(dx * dx + dy * dy));
+
+  if (h >= UINT32_MAX) {
+    return UINT32_MAX;
+  }
+
+  return (uint32_t)h;
+}
+
+
+// The A* priority of node v at distance dist; subtracting
+// the source node's potential starts the search at zero
+// as the radix heap and bucket queue require
+static inline uint32_t tinygraph_dijkstra_key(tinygraph_dijkstra_const_s ctx, uint32_t dist, uint32_t v) {
+  const uint32_t key = tinygraph_saturated_add_u32(dist, tinygraph_dijkstra_potential(ctx, v));
+
+  if (key == UINT32_MAX) {
+    return UINT32_MAX;
+  }
+
+  return key > ctx->offset ? key - ctx->offset : 0;
+}
+
+
+// Settles the next node of one direction in a bidirectional
+// search: relaxes its out edges in the forward search and its
+// in edges in the backward search, and updates the shortest
+// distance mu over the nodes both searches have reached.
+// Writes the settled node's distance into `top`, keeping it
+// as is if the queue only had an outdated entry for a node.
+TINYGRAPH_WARN_UNUSED
+static bool tinygraph_dijkstra_bidirectional_step(tinygraph_dijkstra_s ctx, bool forward, uint32_t *top) {
+  tinygraph_dijkstra_search * const search = forward ? &ctx->forward : &ctx->backward;
+  const tinygraph_dijkstra_search * const other = forward ? &ctx->backward : &ctx->forward;
+
+  uint32_t u, key;
+
+  if (!tinygraph_dijkstra_queue_pop(search, &u, &key)) {
+    return false;
+  }
+
+  if (tinygraph_bitset_get_at(search->seen, u)) {
+    return true;
+  }
+
+  tinygraph_bitset_set_at(search->seen, u);
+
+  const uint32_t distu = search->dist[u];
+
+  *top = distu;
+
+  uint32_t it, last;
+
+  if (forward) {
+    tinygraph_get_out_edges(ctx->graph, u, &it, &last);
+  } else {
+    tinygraph_bidirectional_get_in_edges(ctx->bidir, u, &it, &last);
+  }
+
+  tinygraph_neighbors_it nit;
+  uint32_t v;
+
+  tinygraph_neighbors_begin_range(forward ? ctx->graph : ctx->bidir->reversed, &nit, u, it, last);
+
+  for (; tinygraph_neighbors_next(&nit, &v); ++it) {
+    uint32_t e = it;
+
+    // The in edge's source is v, map the in edge to
+    // its edge id in v's out edges for its weight
+    if (!forward) {
+      uint32_t vfirst, vlast;
+      tinygraph_get_out_edges(ctx->graph, v, &vfirst, &vlast);
+
+      e = tinygraph_bidirectional_get_forward_edge_in(ctx->bidir, it, vfirst, vlast);
+    }
+
+    const uint32_t alt = tinygraph_saturated_add_u32(distu, ctx->weight[e]);
+
+    if (alt < search->dist[v]) {
+      if (!tinygraph_dijkstra_search_relax(search, v, alt, u)
+          || !tinygraph_dijkstra_queue_push(search, v, alt)) {
+        return false;
+      }
+    }
+
+    // The searches meet in v; the trees' paths to v are
+    // at most as long as their distances, we stitch the
+    // path through the meeting node when retrieving it
+    if (other->dist[v] != UINT32_MAX) {
+      const uint32_t through = tinygraph_saturated_add_u32(search->dist[v], other->dist[v]);
+
+      if (through < ctx->mu) {
+        ctx->mu = through;
+        ctx->meet = v;
+      }
+    }
+  }
+
+  return true;
+}
+
+
+// Runs a forward search from s and a backward search from t,
+// alternating between them until they can no longer improve
+// on the shortest distance mu over the nodes both reached.
+//
+// See
+// - Bidirectional Search, Pohl, Machine Intelligence 1971
+// - Engineering Route Planning Algorithms, Delling et al.,
+//   Algorithmics of Large and Complex Networks 2009
+TINYGRAPH_WARN_UNUSED
+static bool tinygraph_dijkstra_shortest_path_bidirectional(tinygraph_dijkstra_s ctx, uint32_t s, uint32_t t) {
+  TINYGRAPH_ASSERT(ctx->bidir);
+
+  // The state only holds the one s-t query,
+  // re-use it only for the very same query
+  if (s == ctx->s && t == ctx->t && (s == t || ctx->mu != UINT32_MAX)) {
+    return true;
+  }
+
+  tinygraph_dijkstra_clear(ctx);
+  tinygraph_array_clear(ctx->path);
+
+  if (s == t) {
+    ctx->s = s;
+    ctx->t = t;
+
+    return true;
+  }
+
+  if (!tinygraph_dijkstra_search_start(&ctx->forward, s, 0)
+      || !tinygraph_dijkstra_search_start(&ctx->backward, t, 0)) {
+    tinygraph_dijkstra_clear(ctx);
+    return false;
+  }
+
+  ctx->s = s;
+  ctx->t = t;
+
+  // The distances of the nodes settled last in each
+  // direction; all nodes not settled yet are at least
+  // as far. As soon as their sum reaches mu no path
+  // through a node not settled in both directions can
+  // be shorter than mu, and we are done.
+
+  uint32_t tops[2] = {0, 0};
+
+  for (uint32_t i = 0; ; i ^= 1) {
+    if (tinygraph_dijkstra_queue_is_empty(&ctx->forward)
+        || tinygraph_dijkstra_queue_is_empty(&ctx->backward)) {
+      break;
+    }
+
+    // Saturated distances end the search here, too
+    if (tinygraph_saturated_add_u32(tops[0], tops[1]) >= ctx->mu) {
+      break;
+    }
+
+    if (!tinygraph_dijkstra_bidirectional_step(ctx, i == 0, &tops[i])) {
+      tinygraph_dijkstra_clear(ctx);
+      return false;
+    }
+  }
+
+  // A saturated mu can not be told apart from other paths
+  return ctx->mu != UINT32_MAX;
+}
+
+
 bool tinygraph_dijkstra_shortest_path(
     tinygraph_dijkstra_s ctx,
     uint32_t s,
@@ -685,13 +3754,31 @@ bool tinygraph_dijkstra_shortest_path(
   TINYGRAPH_ASSERT(ctx);
   TINYGRAPH_ASSERT(tinygraph_has_node(ctx->graph, s));
   TINYGRAPH_ASSERT(tinygraph_has_node(ctx->graph, t));
-  TINYGRAPH_ASSERT(ctx->heap);
-  TINYGRAPH_ASSERT(ctx->seen);
-  TINYGRAPH_ASSERT(ctx->dist);
-  TINYGRAPH_ASSERT(ctx->parent);
+  TINYGRAPH_ASSERT(ctx->forward.dist);
+  TINYGRAPH_ASSERT(ctx->forward.parent);
+  TINYGRAPH_ASSERT(ctx->forward.seen);
   TINYGRAPH_ASSERT(ctx->weight);
 
+  if (ctx->bidir) {
+    return tinygraph_dijkstra_shortest_path_bidirectional(ctx, s, t);
+  }
+
+  tinygraph_dijkstra_search * const search = &ctx->forward;
+
   if (s == t) {
+    // The search state belongs to the source node; start
+    // a new one if the source changes, otherwise a later
+    // search from s would resume the previous search
+    if (s != ctx->s) {
+      tinygraph_dijkstra_clear(ctx);
+      tinygraph_array_clear(ctx->path);
+
+      if (!tinygraph_dijkstra_search_start(search, s, 0)) {
+        tinygraph_dijkstra_clear(ctx);
+        return false;
+      }
+    }
+
     ctx->s = s;
     ctx->t = t;
 
@@ -708,39 +3795,54 @@ bool tinygraph_dijkstra_shortest_path(
   // and only the target node changes, we can re-use
   // the internal state. Otherwise clear it and start
   // the search from scratch with the new source node.
-  if (s != ctx->s) {
+  bool restart = s != ctx->s;
+
+  if (!restart) {
+    // The source node is the same and we have explored t already
+    // in a previous search, this means we're done here
+    if (tinygraph_bitset_get_at(search->seen, t)) {
+      ctx->t = t;
+      return true;
+    }
+
+    // A* searches settle nodes with their exact distance
+    // but the frontier's priorities are directed towards
+    // the previous target node, start over for a new one
+    restart = ctx->lngs && t != ctx->t;
+  }
+
+  if (restart) {
     tinygraph_dijkstra_clear(ctx);
 
     ctx->s = s;
     ctx->t = t;
-    ctx->dist[s] = 0;
+    ctx->offset = tinygraph_dijkstra_potential(ctx, s);
 
-    if (!tinygraph_heap_push(ctx->heap, s, 0)) {
+    if (!tinygraph_dijkstra_search_start(search, s, 0)) {
       tinygraph_dijkstra_clear(ctx);
       tinygraph_array_clear(ctx->path);
       return false;
     }
   } else {
-    // The source node is the same and we have explored t already
-    // in a previous search, this means we're done here
     ctx->t = t;
-    ctx->dist[s] = 0;
-
-    if (tinygraph_bitset_get_at(ctx->seen, t)) {
-      return true;
-    }
   }
 
-  while (!tinygraph_heap_is_empty(ctx->heap)) {
-    const uint32_t u = tinygraph_heap_pop(ctx->heap);
+  while (!tinygraph_dijkstra_queue_is_empty(search)) {
+    uint32_t u, keyu;
+
+    if (!tinygraph_dijkstra_queue_pop(search, &u, &keyu)) {
+      tinygraph_dijkstra_clear(ctx);
+      tinygraph_array_clear(ctx->path);
+      return false;
+    }
 
-    if (tinygraph_bitset_get_at(ctx->seen, u)) {
+    if (tinygraph_bitset_get_at(search->seen, u)) {
       continue;
     } else {
-      tinygraph_bitset_set_at(ctx->seen, u);
+      tinygraph_bitset_set_at(search->seen, u);
     }
 
-    const uint32_t distu = ctx->dist[u];
+    const uint32_t distu = search->dist[u];
 
     // The following is a bit different to the classical Dijkstra
     // implementation: even if u is the target node, we still want
@@ -754,16 +3856,36 @@ bool tinygraph_dijkstra_shortest_path(
 
     tinygraph_get_out_edges(ctx->graph, u, &it, &last);
 
-    for (; it != last; ++it) {
-      const uint32_t v = tinygraph_get_edge_target(ctx->graph, it);
+    tinygraph_neighbors_it nit;
+    uint32_t v;
+
+    tinygraph_neighbors_begin_range(ctx->graph, &nit, u, it, last);
 
+    for (; tinygraph_neighbors_next(&nit, &v); ++it) {
       const uint32_t alt = tinygraph_saturated_add_u32(distu, ctx->weight[it]);
 
-      if (alt < ctx->dist[v]) {
-        ctx->dist[v] = alt;
-        ctx->parent[v] = u;
+      if (alt < search->dist[v]) {
+        uint32_t key = tinygraph_dijkstra_key(ctx, alt, v);
+
+        // The radix heap and bucket queue rely on the priorities
+        // being within the window after the one popped last; with
+        // a consistent potential they are, clamping them keeps the
+        // queues intact for coordinates breaking the lower bound.
+        // We clamp against the priority u was popped with; after
+        // an earlier clamp raised it, it is more than u's key.
+        // The heaps take any priority and are left unclamped.
+        const bool monotone = search->queue == TINYGRAPH_DIJKSTRA_QUEUE_RADIX_HEAP
+          || search->queue == TINYGRAPH_DIJKSTRA_QUEUE_BUCKET_QUEUE;
+
+        if (ctx->lngs && monotone) {
+          const uint32_t keymax = tinygraph_saturated_add_u32(keyu, ctx->window);
+
+          key = key < keyu ? keyu : key;
+          key = key > keymax ? keymax : key;
+        }
 
-        if (!tinygraph_heap_push(ctx->heap, v, alt)) {
+        if (!tinygraph_dijkstra_search_relax(search, v, alt, u)
+            || !tinygraph_dijkstra_queue_push(search, v, key)) {
           tinygraph_dijkstra_clear(ctx);
           tinygraph_array_clear(ctx->path);
           return false;
@@ -798,13 +3920,17 @@ bool tinygraph_dijkstra_shortest_path(
 
 uint32_t tinygraph_dijkstra_get_distance(tinygraph_dijkstra_s ctx) {
   TINYGRAPH_ASSERT(ctx);
-  TINYGRAPH_ASSERT(ctx->dist);
+  TINYGRAPH_ASSERT(ctx->forward.dist);
 
   if (ctx->s == ctx->t) {
     return 0;
   }
 
-  return ctx->dist[ctx->t];
+  if (ctx->bidir) {
+    return ctx->mu;
+  }
+
+  return ctx->forward.dist[ctx->t];
 }
 
 
@@ -816,7 +3942,7 @@ bool tinygraph_dijkstra_get_path(
   TINYGRAPH_ASSERT(ctx);
   TINYGRAPH_ASSERT(first);
   TINYGRAPH_ASSERT(last);
-  TINYGRAPH_ASSERT(ctx->parent);
+  TINYGRAPH_ASSERT(ctx->forward.parent);
   TINYGRAPH_ASSERT(ctx->path);
 
   if (ctx->s == ctx->t) {
@@ -839,15 +3965,19 @@ bool tinygraph_dijkstra_get_path(
   // meaning we clear the path so that the user can
   // continue without unrecoverable ctx corruption.
 
-  uint32_t p = ctx->t;
+  // The bidirectional search's path goes through the
+  // meeting node: the forward tree's path up to it,
+  // then the backward tree's path from it to t
+  const uint32_t *parent = ctx->forward.parent;
+  uint32_t p = ctx->bidir ? ctx->meet : ctx->t;
 
-  while (p != ctx->parent[p]) {
+  while (p != parent[p]) {
     if (!tinygraph_array_push(ctx->path, p)) {
       tinygraph_array_clear(ctx->path);
       return false;
     }
 
-    p = ctx->parent[p];
+    p = parent[p];
   }
 
   if (!tinygraph_array_push(ctx->path, ctx->s)) {
@@ -857,6 +3987,20 @@ bool tinygraph_dijkstra_get_path(
 
   tinygraph_array_reverse(ctx->path);
 
+  if (ctx->bidir) {
+    parent = ctx->backward.parent;
+    p = ctx->meet;
+
+    while (p != parent[p]) {
+      p = parent[p];
+
+      if (!tinygraph_array_push(ctx->path, p)) {
+        tinygraph_array_clear(ctx->path);
+        return false;
+      }
+    }
+  }
+
   *first = tinygraph_array_get_data(ctx->path);
   *last = *first + tinygraph_array_get_size(ctx->path);
 
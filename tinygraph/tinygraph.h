@@ -59,6 +59,82 @@ tinygraph_s tinygraph_construct_from_unsorted_edges(
     const uint32_t* targets,
     uint32_t n);
 
+/**
+ * Creates a tiny graph from `n` source nodes in
+ * `sources` and `n` target nodes in `targets`
+ * and writes the edge permutation it applied
+ * into `permutation`.
+ *
+ * The graph is the same as the one from
+ * `tinygraph_construct_from_unsorted_edges`.
+ * The graph's edge `e` is the input edge
+ * `permutation[e]`; duplicate edges keep their
+ * input order. Use it to bring per-edge data
+ * such as weights into edge id order.
+ *
+ * Note: `permutation` must have space for `n`
+ * edge indices.
+ *
+ * The caller is responsible to destruct the
+ * returned object with `tinygraph_destruct`.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+tinygraph_s tinygraph_construct_from_unsorted_edges_permutation(
+    const uint32_t* sources,
+    const uint32_t* targets,
+    uint32_t n,
+    uint32_t* permutation);
+
+/**
+ * Creates a tiny graph from `n` source nodes in
+ * `sources` and `n` target nodes in `targets`
+ * carrying per-edge records along.
+ *
+ * The `n` records of `payload_size` bytes each
+ * in `payload` are written to `payload_out` in
+ * the graph's edge id order, e.g. edge weights
+ * for `tinygraph_dijkstra_construct`. For more
+ * than one column pass an array of structs.
+ *
+ * Note: `payload_out` must have space for `n`
+ * records and must not alias `payload`.
+ *
+ * The caller is responsible to destruct the
+ * returned object with `tinygraph_destruct`.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+tinygraph_s tinygraph_construct_from_unsorted_edges_payload(
+    const uint32_t* sources,
+    const uint32_t* targets,
+    uint32_t n,
+    const void* payload,
+    void* payload_out,
+    uint32_t payload_size);
+
+/**
+ * Creates a tiny graph from `n` source nodes in
+ * `sources` and `n` target nodes in `targets`
+ * using up to `num_threads` threads, including
+ * the calling thread.
+ *
+ * The resulting graph is the very same as the
+ * one `tinygraph_construct_from_unsorted_edges`
+ * creates. With `num_threads` of zero or one
+ * the construction runs on the calling thread.
+ *
+ * The caller is responsible to destruct the
+ * returned object with `tinygraph_destruct`.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+tinygraph_s tinygraph_construct_from_unsorted_edges_parallel(
+    const uint32_t* sources,
+    const uint32_t* targets,
+    uint32_t n,
+    uint32_t num_threads);
+
 /**
  * Copies `graph` and returns a new graph with
  * the same nodes and edges as `graph`.
@@ -82,6 +158,47 @@ TINYGRAPH_API
 TINYGRAPH_WARN_UNUSED
 tinygraph_s tinygraph_copy_reversed(tinygraph_const_s graph);
 
+/**
+ * Copies `graph` and returns a new graph with
+ * the same nodes as `graph` but the edges
+ * are reversed, using up to `num_threads`
+ * threads, including the calling thread.
+ *
+ * The resulting graph is the very same as the
+ * one `tinygraph_copy_reversed` creates.
+ *
+ * The caller is responsible to destruct the
+ * returned object with `tinygraph_destruct`.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+tinygraph_s tinygraph_copy_reversed_parallel(tinygraph_const_s graph, uint32_t num_threads);
+
+/**
+ * Copies `graph` and returns a new graph with
+ * the same nodes and edges as `graph` but the
+ * edge targets are stored compressed.
+ *
+ * Each node's sorted targets are delta coded
+ * and stored as variable-length integers. On
+ * spatially reordered graphs most targets
+ * then take up a single byte instead of four.
+ * Nodes with very many out edges store their
+ * targets Elias-Fano coded for fast lookups.
+ *
+ * Note: compressed graphs do not support
+ * `tinygraph_get_neighbors`, use the decoding
+ * `tinygraph_neighbors_begin` iterator instead.
+ * The function `tinygraph_get_edge_target` has
+ * to decode the edge's range and is slow.
+ *
+ * The caller is responsible to destruct the
+ * returned object with `tinygraph_destruct`.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+tinygraph_s tinygraph_copy_compressed(tinygraph_const_s graph);
+
 /**
  * Destructs `graph` releasing resources.
  */
@@ -95,6 +212,13 @@ TINYGRAPH_API
 TINYGRAPH_WARN_UNUSED
 bool tinygraph_is_empty(tinygraph_const_s graph);
 
+/**
+ * Returns true if `graph`'s edge targets are compressed.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_is_compressed(tinygraph_const_s graph);
+
 /**
  * Returns the number of nodes in `graph`.
  */
@@ -141,6 +265,8 @@ uint32_t tinygraph_get_out_degree(tinygraph_const_s graph, uint32_t v);
  * This function is a shortcut for the common use case of
  * - retrieving a node's out edges `e` with `tinygraph_get_out_edges()`,
  * - iterating over all targets for `e` with `tinygraph_get_edge_target()`
+ *
+ * Note: `graph` must not be compressed.
  */
 TINYGRAPH_API
 void tinygraph_get_neighbors(
@@ -149,6 +275,45 @@ void tinygraph_get_neighbors(
     const uint32_t **last,
     uint32_t v);
 
+/**
+ * Iterator over a node's neighbors, decoding
+ * compressed edge targets on the fly. Its
+ * fields are internal and must not be used.
+ */
+typedef struct tinygraph_neighbors_it {
+  const uint32_t *targets;
+  const uint8_t *bytes;
+  const struct tinygraph_eliasfano *hub;
+  uint64_t pos;
+  uint32_t prev;
+  uint32_t left;
+  bool head;
+} tinygraph_neighbors_it;
+
+/**
+ * Initializes the iterator `it` over node `v`'s
+ * neighbors in `graph`, in order of their edges.
+ *
+ * The iterator works for both compressed and
+ * uncompressed graphs and stays valid as long
+ * as `graph` does.
+ */
+TINYGRAPH_API
+void tinygraph_neighbors_begin(
+    tinygraph_const_s graph,
+    tinygraph_neighbors_it *it,
+    uint32_t v);
+
+/**
+ * Writes the iterator `it`'s next neighbor into
+ * `target` and advances the iterator.
+ *
+ * Returns false if there are no neighbors left.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_neighbors_next(tinygraph_neighbors_it *it, uint32_t *target);
+
 /**
  * Returns true if `graph` contains node `v`.
  */
@@ -218,6 +383,200 @@ bool tinygraph_reorder(
     const uint16_t* lats,
     uint32_t n);
 
+/**
+ * Space filling curves to reorder graph nodes with.
+ *
+ * The Hilbert curve never jumps between far away
+ * cells and in general gives smaller node id gaps
+ * between neighbors than the z-order curve, at a
+ * slightly higher cost to compute.
+ */
+typedef enum tinygraph_curve {
+  TINYGRAPH_CURVE_ZORDER,
+  TINYGRAPH_CURVE_HILBERT,
+} tinygraph_curve;
+
+/**
+ * Reorders graph nodes based on their spatial embedding
+ * like `tinygraph_reorder` but along the space filling
+ * `curve`; `tinygraph_reorder` uses the z-order curve.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_reorder_curve(
+    uint32_t* nodes,
+    const uint16_t* lngs,
+    const uint16_t* lats,
+    uint32_t n,
+    tinygraph_curve curve);
+
+/**
+ * Reorders graph nodes based on their spatial embedding
+ * like `tinygraph_reorder_curve` but for 32 bit fixed-point
+ * coordinates in the `n` sized `lngs` and `lats` arrays.
+ *
+ * With `coarse` the order only goes down to cells of
+ * the curve holding about a memory page of node ids;
+ * within these cells the nodes keep their order from
+ * the `nodes` array. This is faster and good enough
+ * for memory locality and delta compression.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_reorder32(
+    uint32_t* nodes,
+    const uint32_t* lngs,
+    const uint32_t* lats,
+    uint32_t n,
+    tinygraph_curve curve,
+    bool coarse);
+
+/**
+ * Reorders graph nodes based on the graph's structure
+ * alone, for graphs without a spatial embedding:
+ *
+ * - `nodes[i]` the node i's id in the new order
+ *
+ * The caller is responsible for providing the num_nodes
+ * sized `nodes` array, see `tinygraph_permute` to apply
+ * the order to the graph.
+ *
+ * This one sorts hubs first: by their number of out and
+ * in edges, descending. It is cheap and groups the few
+ * nodes most edges point to in skewed graphs.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_reorder_degree(tinygraph_const_s graph, uint32_t* nodes);
+
+/**
+ * Reorders graph nodes like `tinygraph_reorder_degree`
+ * in reverse Cuthill-McKee order: a breadth first search
+ * on the graph's edges taken as undirected, visiting
+ * neighbors by ascending degree, reversed.
+ *
+ * It is cheap and gives small gaps between neighbors
+ * for mesh-like graphs such as road networks.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_reorder_rcm(tinygraph_const_s graph, uint32_t* nodes);
+
+/**
+ * Reorders graph nodes like `tinygraph_reorder_degree`
+ * in Gorder order: greedily placing next the node with
+ * the most edges and shared in neighbors to the last
+ * `window` placed nodes, e.g. a window of five.
+ *
+ * It is more expensive than the other orders, but
+ * it gives the best locality in general, also for
+ * skewed graphs such as social networks.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_reorder_gorder(tinygraph_const_s graph, uint32_t* nodes, uint32_t window);
+
+/**
+ * Computes the strongly connected components of `graph`,
+ * writing node v's component into `labels[v]` and the
+ * number of components into `num_components`.
+ *
+ * Components are labeled from zero in reverse topological
+ * order: there are no edges from a component to one with
+ * a larger label. The caller is responsible for providing
+ * the num_nodes sized `labels` array.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_scc(tinygraph_const_s graph, uint32_t* labels, uint32_t* num_components);
+
+/**
+ * Reorders graph nodes like `tinygraph_reorder_degree`
+ * such that the strongly connected components are each
+ * contiguous, ordered by their size, the largest first.
+ *
+ * Within the components the nodes are ordered along the
+ * space filling `curve` if `lngs` and `lats` are given,
+ * see `tinygraph_reorder_curve`, or by their id if NULL.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_reorder_scc(
+    tinygraph_const_s graph,
+    uint32_t* nodes,
+    const uint16_t* lngs,
+    const uint16_t* lats,
+    tinygraph_curve curve);
+
+/**
+ * Creates a copy of the subgraph of `graph` induced by its
+ * largest strongly connected component, e.g. for routing
+ * where all nodes have to be reachable from each other.
+ *
+ * The nodes of the copy keep their relative order. Their
+ * ids in `graph` are written into the num_nodes sized
+ * `nodes` array, as many as the copy has nodes.
+ *
+ * The caller is responsible to destruct the
+ * returned object with `tinygraph_destruct`.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+tinygraph_s tinygraph_copy_largest_scc(tinygraph_const_s graph, uint32_t* nodes);
+
+/**
+ * Creates a copy of `graph` with its nodes renumbered
+ * according to the permutation `nodes`:
+ *
+ * - `nodes[u]` the old node id of the new node u
+ *
+ * that is the nodes in the order `tinygraph_reorder`
+ * sorts them into. The graph's num_nodes sized `nodes`
+ * array must be a permutation of the node ids.
+ *
+ * If `inverse` is not NULL, the inverse permutation
+ * is written into the num_nodes sized `inverse` array:
+ *
+ * - `inverse[v]` the new node id of the old node v
+ *
+ * If `edges` is not NULL, the edge permutation is
+ * written into the num_edges sized `edges` array:
+ *
+ * - `edges[e]` the old edge id of the new edge e
+ *
+ * Use `tinygraph_permute_inplace` with `nodes` and
+ * `edges` to bring node and edge attributes such as
+ * coordinates and weights into the new order.
+ *
+ * The copy is uncompressed, see `tinygraph_copy_compressed`.
+ *
+ * The caller is responsible to destruct the
+ * returned object with `tinygraph_destruct`.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+tinygraph_s tinygraph_permute(
+    tinygraph_const_s graph,
+    const uint32_t* nodes,
+    uint32_t* inverse,
+    uint32_t* edges);
+
+/**
+ * Permutes the `n` values of `size` bytes each in
+ * `values` inplace, such that the value i afterwards
+ * is the value `permutation[i]` from before.
+ *
+ * Returns false if the temporary space for marking
+ * values already in place can not be allocated.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+bool tinygraph_permute_inplace(
+    void* values,
+    uint32_t size,
+    const uint32_t* permutation,
+    uint32_t n);
+
 /**
  * Iterates over all nodes in `graph`.
  */
@@ -231,6 +590,129 @@ bool tinygraph_reorder(
   for (uint32_t item = 0; item < tinygraph_get_num_edges(graph); ++item)
 
 
+/**
+ * Bidirectional graph: a graph together with its
+ * in edges, mapping in edges to their forward edges.
+ */
+typedef struct tinygraph_bidirectional* tinygraph_bidirectional_s;
+typedef const struct tinygraph_bidirectional* tinygraph_bidirectional_const_s;
+
+/**
+ * Creates a bidirectional graph for `graph`.
+ *
+ * The in edges have their own edge ids, ordered
+ * by target and then source. Each in edge maps to
+ * its forward edge in `graph` with a byte per edge,
+ * so that e.g. edge weights need to be stored only
+ * once, for the forward edges.
+ *
+ * Note: during the lifetime of the bidirectional
+ * graph, the graph it was created for must not
+ * change.
+ *
+ * The caller is responsible to destruct the
+ * returned object with `tinygraph_bidirectional_destruct`.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+tinygraph_bidirectional_s tinygraph_bidirectional_construct(tinygraph_const_s graph);
+
+/**
+ * Destructs `bidir` releasing resources.
+ */
+TINYGRAPH_API
+void tinygraph_bidirectional_destruct(tinygraph_bidirectional_s bidir);
+
+/**
+ * Returns the graph `bidir` was created for.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+tinygraph_const_s tinygraph_bidirectional_get_graph(tinygraph_bidirectional_const_s bidir);
+
+/**
+ * Returns the reversed graph `bidir` stores; its
+ * out edges are the in edges of the graph, with
+ * the same ids as in all functions below.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+tinygraph_const_s tinygraph_bidirectional_get_reversed(tinygraph_bidirectional_const_s bidir);
+
+/**
+ * Writes the in edge range [first, last) for all
+ * in edges of node `target` into `first` and `last`.
+ */
+TINYGRAPH_API
+void tinygraph_bidirectional_get_in_edges(
+    tinygraph_bidirectional_const_s bidir,
+    uint32_t target,
+    uint32_t* first,
+    uint32_t* last);
+
+/**
+ * Writes the node `v`'s in neighbors delimited by
+ * [first, last) into `first` and `last`, in order
+ * of their in edges.
+ */
+TINYGRAPH_API
+void tinygraph_bidirectional_get_in_neighbors(
+    tinygraph_bidirectional_const_s bidir,
+    const uint32_t **first,
+    const uint32_t **last,
+    uint32_t v);
+
+/**
+ * Returns the number of incoming edges at node `v`.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_bidirectional_get_in_degree(tinygraph_bidirectional_const_s bidir, uint32_t v);
+
+/**
+ * Returns the in edge `e`'s source node.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_bidirectional_get_edge_source(tinygraph_bidirectional_const_s bidir, uint32_t e);
+
+/**
+ * Returns the in edge `e`'s edge id in the graph.
+ *
+ * Note: the mapping looks up the out edges of
+ * the in edge's source, see `tinygraph_get_out_edges`.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_bidirectional_get_forward_edge(tinygraph_bidirectional_const_s bidir, uint32_t e);
+
+/**
+ * Returns the in edge `e`'s edge id in the graph
+ * like `tinygraph_bidirectional_get_forward_edge`
+ * for callers knowing the in edge's source already:
+ * [first, last) are the source's out edges from
+ * `tinygraph_get_out_edges` on the graph.
+ *
+ * Searches walking in edges together with their
+ * source nodes skip the source lookup this way.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_bidirectional_get_forward_edge_in(
+    tinygraph_bidirectional_const_s bidir,
+    uint32_t e,
+    uint32_t first,
+    uint32_t last);
+
+/**
+ * Returns the total size in bytes `bidir` uses on top
+ * of the graph it was created for.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+uint32_t tinygraph_bidirectional_size_in_bytes(tinygraph_bidirectional_const_s bidir);
+
+
 /**
  * Single-source shortest-path search context, caching
  * internal state between multiple runs for efficiency.
@@ -273,6 +755,110 @@ tinygraph_dijkstra_s tinygraph_dijkstra_construct(
     tinygraph_const_s graph,
     const uint16_t* weights);
 
+/**
+ * Priority queues for the shortest-path search.
+ *
+ * The binary heap works for any weights; the
+ * radix heap and the bucket queue exploit that
+ * distances popped in the search never decrease
+ * and that edge weights are small integers.
+ *
+ * The radix heap moves each queued node at most
+ * 32 times between its buckets. The bucket queue
+ * pushes and pops in constant time but needs one
+ * bucket per distance up to the largest weight,
+ * that is up to 65536 buckets, and is the best
+ * choice for graphs with small weights.
+ *
+ * The queues above hold a node once per time its
+ * distance improved. The indexed heap decreases
+ * a node's distance in place instead, so that it
+ * never holds more than the search frontier, at
+ * the cost of four bytes per graph node.
+ */
+typedef enum tinygraph_dijkstra_queue {
+  TINYGRAPH_DIJKSTRA_QUEUE_BINARY_HEAP,
+  TINYGRAPH_DIJKSTRA_QUEUE_RADIX_HEAP,
+  TINYGRAPH_DIJKSTRA_QUEUE_BUCKET_QUEUE,
+  TINYGRAPH_DIJKSTRA_QUEUE_INDEXED_HEAP,
+} tinygraph_dijkstra_queue;
+
+/**
+ * Creates a single-source shortest-path context
+ * like `tinygraph_dijkstra_construct` but with the
+ * priority queue `queue` for its searches instead
+ * of the binary heap.
+ *
+ * The caller is responsible to destruct the
+ * returned object with `tinygraph_dijkstra_destruct`.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+tinygraph_dijkstra_s tinygraph_dijkstra_construct_with_queue(
+    tinygraph_const_s graph,
+    const uint16_t* weights,
+    tinygraph_dijkstra_queue queue);
+
+/**
+ * Creates a shortest-path context running its
+ * s-t searches bidirectionally: a forward search
+ * from s on the graph `bidir` was constructed
+ * from and a backward search from t on its in
+ * edges, alternating until they meet. The edge
+ * weights `weights` are per edge of the graph.
+ *
+ * Bidirectional searches settle about half the
+ * nodes a single search does for far away nodes
+ * but can not re-use their state across queries
+ * from the same source node.
+ *
+ * The caller is responsible to destruct the
+ * returned object with `tinygraph_dijkstra_destruct`.
+ * The bidirectional graph must outlive it.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+tinygraph_dijkstra_s tinygraph_dijkstra_construct_bidirectional(
+    tinygraph_bidirectional_const_s bidir,
+    const uint16_t* weights,
+    tinygraph_dijkstra_queue queue);
+
+/**
+ * Creates a shortest-path context running goal
+ * directed A* searches with the nodes' 32 bit
+ * fixed-point coordinates in the num_nodes sized
+ * `lngs` and `lats` arrays:
+ *
+ * - `lngs[i]` the longitude fixed-point for node i
+ * - `lats[i]` the latitude fixed-point for node i
+ *
+ * The searches prefer nodes towards the target
+ * node by the straight line distance to it times
+ * `scale`, the weight per coordinate unit. For
+ * shortest paths every edge's weight must be at
+ * least `scale` times its straight line length.
+ * For geographic coordinates project them first
+ * e.g. scale longitudes by the cosine of the
+ * region's latitude (equirectangular projection).
+ *
+ * Searches from the same source node re-use the
+ * state for target nodes a previous search has
+ * settled already and start over otherwise.
+ *
+ * The caller is responsible to destruct the
+ * returned object with `tinygraph_dijkstra_destruct`.
+ * The coordinates must outlive it.
+ */
+TINYGRAPH_API
+TINYGRAPH_WARN_UNUSED
+tinygraph_dijkstra_s tinygraph_dijkstra_construct_astar(
+    tinygraph_const_s graph,
+    const uint16_t* weights,
+    const uint32_t* lngs,
+    const uint32_t* lats,
+    double scale,
+    tinygraph_dijkstra_queue queue);
+
 /**
  * Destructs `ctx` releasing resources.
  */